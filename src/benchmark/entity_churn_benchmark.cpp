@@ -0,0 +1,208 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: create and destroy 1M entities with components, pooled through EntityFactory against plain heap allocation
+#include "game/basic/component.h"
+#include "game/basic/component_storage.h"
+#include "game/basic/entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/basic/pool_allocator.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace multiplayer_server
+{
+  // a projectile sized component, spawned and destroyed with its entity
+  class ChurnComponent : public Component
+  {
+  public:
+    ChurnComponent(Entity *owner) : Component(owner) {}
+
+    void update(float dt) override { lifetime_ -= dt; }
+    void render() override {}
+    void before_destruct() override {}
+
+  private:
+    float position_[3] = {0.0f, 0.0f, 0.0f};
+    float velocity_[3] = {1.0f, 0.0f, 1.0f};
+    float lifetime_ = 1.0f;
+  };
+
+  // entity without behaviour, its logger is quiet so the benchmark doesn't measure log files
+  class ChurnEntity : public Entity
+  {
+  public:
+    ChurnEntity(EntityId id) : Entity(id) {}
+
+    static void quiet_logger() { get_entity_logger()->set_level(LoggerLevel::Warn); }
+  };
+
+  // resident memory of this process in bytes, 0 if the platform is not supported
+  static size_t get_resident_memory()
+  {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+      if (line.compare(0, 6, "VmRSS:") == 0)
+      {
+        std::istringstream stream(line.substr(6));
+        size_t kilobytes = 0;
+        stream >> kilobytes;
+        return kilobytes * 1024;
+      }
+    }
+#endif
+    return 0;
+  }
+
+  struct ChurnResult
+  {
+    double milliseconds = 0.0;
+    size_t memory_growth = 0;
+  };
+
+  // spawn batch_size entities, destroy them at the next tick boundary, until total entities lived
+  template <typename Spawn, typename DestroyAll>
+  static ChurnResult run_churn(size_t total, size_t batch_size, Spawn &&spawn, DestroyAll &&destroy_all)
+  {
+    size_t memory_before = get_resident_memory();
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t created = 0; created < total;)
+    {
+      size_t count = std::min(batch_size, total - created);
+      for (size_t i = 0; i < count; i++)
+      {
+        spawn();
+      }
+      destroy_all();
+      created += count;
+    }
+
+    ChurnResult result;
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    size_t memory_after = get_resident_memory();
+    result.memory_growth = memory_after > memory_before ? memory_after - memory_before : 0;
+    return result;
+  }
+
+  static void print_result(const char *name, const ChurnResult &result, size_t total)
+  {
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << result.milliseconds
+              << std::setw(18) << result.milliseconds * 1000000.0 / static_cast<double>(total)
+              << std::setw(18) << result.memory_growth / 1024 << std::endl;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("entities", po::value<size_t>()->default_value(1000000), "entities created and destroyed in total")
+    ("batch", po::value<size_t>()->default_value(1000), "entities alive at the same time, destroyed together at a tick boundary")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t total = vm["entities"].as<size_t>();
+  size_t batch_size = std::max(vm["batch"].as<size_t>(), static_cast<size_t>(1));
+  auto &factory = EntityFactory::get_instance();
+  ChurnEntity::quiet_logger();
+
+  std::cout << total << " entities with one component, " << batch_size << " alive at a time" << std::endl;
+  std::cout << std::left << std::setw(12) << "allocation" << std::right << std::setw(12) << "total ms" << std::setw(18) << "ns per entity" << std::setw(18) << "memory growth KB" << std::endl;
+
+  // the whole spawn of a game, registry and handle included
+  // id generation too, one thread gets 128 ids per millisecond once it used up ENTITY_ID_MAX_BORROW_MS of borrowed time
+  std::vector<EntityId> alive;
+  alive.reserve(batch_size);
+  auto spawned = run_churn(
+      total, batch_size, [&]()
+      {
+        auto entity = factory.create_entity<ChurnEntity>();
+        entity->add_component<ChurnComponent>();
+        alive.push_back(entity->get_id()); },
+      [&]()
+      {
+        for (EntityId id : alive)
+        {
+          factory.destroy_entity(id);
+        }
+        alive.clear();
+        factory.flush_destroyed_entities(); });
+  print_result("factory", spawned, total);
+
+  // ids of the allocation only rows, they are never registered and the id generator would limit the rate
+  EntityId next_id = 1;
+
+  // allocation only, entity and control block in one slab block, component in a pool of the world storage
+  auto &component_pool = ComponentStorage::get_world().get_pool<ChurnComponent>();
+  std::vector<std::pair<std::shared_ptr<ChurnEntity>, ComponentHandle>> pooled_alive;
+  pooled_alive.reserve(batch_size);
+  auto pooled = run_churn(
+      total, batch_size, [&]()
+      {
+        auto entity = make_pooled_shared<ChurnEntity>(next_id++);
+        auto component = component_pool.create(entity.get());
+        pooled_alive.emplace_back(std::move(entity), component.first); },
+      [&]()
+      {
+        for (auto &item : pooled_alive)
+        {
+          component_pool.destroy(item.second);
+        }
+        pooled_alive.clear(); });
+  print_result("pooled", pooled, total);
+
+  // allocation only, one make_shared per entity and per component as before pooling
+  std::vector<std::pair<std::shared_ptr<ChurnEntity>, std::shared_ptr<ChurnComponent>>> heap_alive;
+  heap_alive.reserve(batch_size);
+  auto heap = run_churn(
+      total, batch_size, [&]()
+      {
+        auto entity = std::make_shared<ChurnEntity>(next_id++);
+        auto component = std::make_shared<ChurnComponent>(entity.get());
+        heap_alive.emplace_back(std::move(entity), std::move(component)); },
+      [&]()
+      {
+        // components go before their owner, as in Entity::delete_all_components
+        for (auto &item : heap_alive)
+        {
+          item.second.reset();
+        }
+        heap_alive.clear(); });
+  print_result("heap", heap, total);
+
+  std::cout << "entities left in the factory " << factory.get_entity_count() << ", pooled allocation speedup " << std::setprecision(2) << heap.milliseconds / pooled.milliseconds << "x" << std::endl;
+  return EXIT_SUCCESS;
+}
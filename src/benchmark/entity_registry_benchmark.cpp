@@ -0,0 +1,284 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: contention of the sharded entity registry against one global lock, many threads create, look up and destroy entities, every phase timed on its own
+#include "game/basic/entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/basic/pool_allocator.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace multiplayer_server
+{
+  // its logger is quiet, otherwise every create and destruct writes the log file under the lock of the file sink
+  class RegistryEntity : public Entity
+  {
+  public:
+    RegistryEntity(EntityId id) : Entity(id) {}
+
+    static void quiet_logger() { get_entity_logger()->set_level(LoggerLevel::Warn); }
+  };
+
+  // the registry before sharding with the lock it would need, every call takes the same mutex
+  // destroyed entities wait for flush_destroyed_entities() like in the factory, so both have the same teardown
+  class GlobalLockRegistry
+  {
+  public:
+    std::shared_ptr<Entity> create_entity()
+    {
+      EntityId id = EntityFactory::get_instance().generate_id();
+      std::shared_ptr<Entity> entity = make_pooled_shared<RegistryEntity>(id);
+      std::lock_guard<std::mutex> lock(mutex_);
+      entities_.emplace(id, entity);
+      return entity;
+    }
+
+    std::shared_ptr<Entity> get_entity(EntityId id)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto iter = entities_.find(id);
+      return iter != entities_.end() ? iter->second : nullptr;
+    }
+
+    void destroy_entity(EntityId id)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto iter = entities_.find(id);
+      if (iter == entities_.end())
+      {
+        return;
+      }
+      iter->second->set_validate(false);
+      destroyed_entities_.emplace_back(std::move(iter->second));
+      entities_.erase(iter);
+    }
+
+    void flush_destroyed_entities()
+    {
+      std::vector<std::shared_ptr<Entity>> flushing;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushing.swap(destroyed_entities_);
+      }
+      for (auto &entity : flushing)
+      {
+        entity->before_destruct();
+      }
+    }
+
+    size_t get_entity_count()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return entities_.size();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::unordered_map<EntityId, std::shared_ptr<Entity>> entities_;
+    std::vector<std::shared_ptr<Entity>> destroyed_entities_;
+  };
+
+  // adapt the factory to the registry interface of run_registry
+  struct FactoryRegistry
+  {
+    EntityFactory &factory = EntityFactory::get_instance();
+
+    std::shared_ptr<Entity> create_entity() { return factory.create_entity<RegistryEntity>(); }
+    std::shared_ptr<Entity> get_entity(EntityId id) { return factory.get_entity(id); }
+    void destroy_entity(EntityId id) { factory.destroy_entity(id); }
+    void flush_destroyed_entities() { factory.flush_destroyed_entities(); }
+    size_t get_entity_count() { return factory.get_entity_count(); }
+  };
+
+  enum RegistryPhase
+  {
+    kCreatePhase = 0,
+    kLookupPhase,
+    kDestroyPhase,
+    kFlushPhase,
+    kPhaseCount
+  };
+
+  static const char *kPhaseNames[kPhaseCount] = {"create", "lookup", "destroy", "flush"};
+
+  struct RegistryBenchmarkResult
+  {
+    double milliseconds[kPhaseCount] = {};
+    uint64_t operations[kPhaseCount] = {};
+    uint64_t misses = 0;
+    size_t entities_left = 0;
+  };
+
+  // every thread creates its entities, looks each of them up lookups times, then destroys them
+  // all threads finish a phase before the next one starts, so every phase is timed on its own
+  // the flush runs on the main thread after all workers joined, as at the tick boundary
+  template <typename Registry>
+  static RegistryBenchmarkResult run_registry(Registry &registry, int thread_count, size_t entities_per_thread, int lookups)
+  {
+    std::atomic<int> ready{0};
+    std::atomic<int> phase{-1};
+    std::atomic<int> finished{0};
+    std::atomic<uint64_t> misses{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++)
+    {
+      threads.emplace_back([&]()
+                           {
+                             auto wait_phase = [&phase](int wanted)
+                             {
+                               while (phase.load(std::memory_order_acquire) < wanted)
+                               {
+                                 std::this_thread::yield();
+                               }
+                             };
+
+                             std::vector<EntityId> ids;
+                             ids.reserve(entities_per_thread);
+                             ready.fetch_add(1);
+
+                             wait_phase(kCreatePhase);
+                             for (size_t k = 0; k < entities_per_thread; k++)
+                             {
+                               ids.push_back(registry.create_entity()->get_id());
+                             }
+                             finished.fetch_add(1, std::memory_order_acq_rel);
+
+                             wait_phase(kLookupPhase);
+                             uint64_t miss = 0;
+                             for (int round = 0; round < lookups; round++)
+                             {
+                               for (EntityId id : ids)
+                               {
+                                 miss += registry.get_entity(id) ? 0 : 1;
+                               }
+                             }
+                             misses.fetch_add(miss);
+                             finished.fetch_add(1, std::memory_order_acq_rel);
+
+                             wait_phase(kDestroyPhase);
+                             for (EntityId id : ids)
+                             {
+                               registry.destroy_entity(id);
+                             }
+                             finished.fetch_add(1, std::memory_order_acq_rel); });
+    }
+
+    while (ready.load() < thread_count)
+    {
+      std::this_thread::yield();
+    }
+
+    RegistryBenchmarkResult result;
+    for (int current = kCreatePhase; current < kFlushPhase; current++)
+    {
+      auto begin = std::chrono::steady_clock::now();
+      phase.store(current, std::memory_order_release);
+      while (finished.load(std::memory_order_acquire) < thread_count * (current + 1))
+      {
+        std::this_thread::yield();
+      }
+      result.milliseconds[current] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    registry.flush_destroyed_entities();
+    result.milliseconds[kFlushPhase] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t entities = static_cast<uint64_t>(thread_count) * entities_per_thread;
+    result.operations[kCreatePhase] = entities;
+    result.operations[kLookupPhase] = entities * static_cast<uint64_t>(lookups);
+    result.operations[kDestroyPhase] = entities;
+    result.operations[kFlushPhase] = entities;
+    result.misses = misses.load();
+    result.entities_left = registry.get_entity_count();
+    return result;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("threads", po::value<std::vector<int>>()->multitoken()->default_value({1, 4, 16, 32}, "1 4 16 32"), "thread counts to measure")
+    ("entities", po::value<size_t>()->default_value(20000), "entities created by every thread")
+    ("lookups", po::value<int>()->default_value(10), "lookups of every entity")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  auto thread_counts = vm["threads"].as<std::vector<int>>();
+  thread_counts.erase(std::remove_if(thread_counts.begin(), thread_counts.end(), [](int count)
+                                     { return count <= 0; }),
+                      thread_counts.end());
+  if (vm.count("help") || thread_counts.empty())
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t entities_per_thread = vm["entities"].as<size_t>();
+  int lookups = std::max(vm["lookups"].as<int>(), 0);
+  RegistryEntity::quiet_logger();
+
+  std::cout << entities_per_thread << " entities per thread, " << lookups << " lookups per entity, " << ENTITY_REGISTRY_SHARD_COUNT << " shards" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(10) << "phase" << std::setw(20) << "sharded Mops/s" << std::setw(20) << "global lock Mops/s" << std::setw(10) << "speedup" << std::endl;
+
+  bool success = true;
+  for (int thread_count : thread_counts)
+  {
+    FactoryRegistry factory_registry;
+    auto sharded = run_registry(factory_registry, thread_count, entities_per_thread, lookups);
+
+    GlobalLockRegistry global_registry;
+    auto global = run_registry(global_registry, thread_count, entities_per_thread, lookups);
+
+    for (int phase = kCreatePhase; phase < kPhaseCount; phase++)
+    {
+      // a phase without operations, lookups may be 0
+      if (sharded.operations[phase] == 0)
+      {
+        continue;
+      }
+      double sharded_rate = static_cast<double>(sharded.operations[phase]) / sharded.milliseconds[phase] / 1000.0;
+      double global_rate = static_cast<double>(global.operations[phase]) / global.milliseconds[phase] / 1000.0;
+      std::cout << std::setw(8) << thread_count << std::setw(10) << kPhaseNames[phase] << std::fixed << std::setprecision(2)
+                << std::setw(20) << sharded_rate << std::setw(20) << global_rate
+                << std::setw(9) << sharded_rate / global_rate << "x" << std::endl;
+    }
+
+    // every lookup runs before its entity is destroyed, a miss is a lost registration
+    if (sharded.misses != 0 || global.misses != 0 || sharded.entities_left != 0 || global.entities_left != 0)
+    {
+      std::cout << "registry lost entities, sharded misses " << sharded.misses << ", global lock misses " << global.misses << std::endl;
+      success = false;
+    }
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
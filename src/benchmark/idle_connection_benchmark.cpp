@@ -0,0 +1,239 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: measure the memory footprint of idle tcp connections, with and without idle read mode
+#include "network/asio_server.h"
+#include "network/asio_tcp_connection.h"
+#include "network/buffer_pool.h"
+#include "network/connection.h"
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// one loopback source address can't open more connections to one port than its ephemeral ports
+#define CONNECTIONS_PER_SOURCE_ADDRESS 20000
+
+namespace multiplayer_server
+{
+  // resident memory of this process in bytes, 0 if the platform is not supported
+  static size_t get_resident_memory()
+  {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+      if (line.compare(0, 6, "VmRSS:") == 0)
+      {
+        std::istringstream stream(line.substr(6));
+        size_t kilobytes = 0;
+        stream >> kilobytes;
+        return kilobytes * 1024;
+      }
+    }
+#endif
+    return 0;
+  }
+
+  // every connection needs a socket on both sides
+  static void raise_file_limit(size_t connection_count)
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+    {
+      return;
+    }
+    rlim_t wanted = static_cast<rlim_t>(connection_count * 2 + 1024);
+    if (limit.rlim_cur < wanted)
+    {
+      limit.rlim_cur = std::min(wanted, limit.rlim_max);
+      setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#else
+    (void)connection_count;
+#endif
+  }
+
+  // open idle client connections to an in-process server, step by step up to the largest count
+  // the footprint of every step is measured from the same baseline, so steps don't hide freed memory from each other
+  class IdleConnectionBenchmark
+  {
+  public:
+    IdleConnectionBenchmark(int port, int io_threads, bool idle_read_mode, int settle_ms)
+        : port_(port), io_threads_(io_threads), idle_read_mode_(idle_read_mode), settle_ms_(settle_ms) {}
+
+    bool run(std::vector<size_t> counts)
+    {
+      std::sort(counts.begin(), counts.end());
+      raise_file_limit(counts.back());
+
+      auto server = std::make_unique<AsioServer>("127.0.0.1", port_, true, false);
+      server->set_io_context_thread_count(io_threads_);
+      server->set_idle_read_mode(idle_read_mode_);
+      std::function<bool(std::shared_ptr<Connection>)> callback = [this](std::shared_ptr<Connection> connection)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        server_connections_.push_back(connection);
+        return true;
+      };
+      server->regist_on_client_connected(callback);
+      try
+      {
+        server->start();
+      }
+      catch (const std::exception &e)
+      {
+        std::cout << "listen on 127.0.0.1:" << port_ << " failed, error: " << e.what() << std::endl;
+        return false;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(settle_ms_));
+      size_t baseline = get_resident_memory();
+      if (baseline == 0)
+      {
+        std::cout << "resident memory is not available on this platform" << std::endl;
+      }
+      std::cout << "idle read mode: " << (idle_read_mode_ ? "on" : "off") << ", receive buffer size: " << MAX_BUFFER_SIZE
+                << ", baseline memory: " << baseline / 1024 << " KB" << std::endl;
+      std::cout << "connections\tmemory KB\tbytes per connection\treceive buffers in use" << std::endl;
+
+      bool success = true;
+      for (size_t count : counts)
+      {
+        if (!connect_until(count) || !wait_accepted(count))
+        {
+          success = false;
+          break;
+        }
+
+        // let the server reach its idle state, in idle read mode every borrowed buffer is back in the pool
+        std::this_thread::sleep_for(std::chrono::milliseconds(settle_ms_));
+        size_t memory = get_resident_memory();
+        size_t delta = memory > baseline ? memory - baseline : 0;
+        std::cout << count << "\t" << delta / 1024 << "\t" << delta / count << "\t" << BufferPool::get_receive_pool().get_used_count() << std::endl;
+      }
+
+      client_sockets_.clear();
+      server->stop();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        server_connections_.clear();
+      }
+      return success;
+    }
+
+  private:
+    bool connect_until(size_t count)
+    {
+      while (client_sockets_.size() < count)
+      {
+        // spread clients over 127.0.0.x so one source address never runs out of ports
+        size_t source_index = client_sockets_.size() / CONNECTIONS_PER_SOURCE_ADDRESS;
+        auto source = boost::asio::ip::make_address_v4(boost::asio::ip::address_v4::loopback().to_uint() + static_cast<uint32_t>(source_index));
+        auto target = boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), static_cast<unsigned short>(port_));
+
+        auto socket = std::make_unique<boost::asio::ip::tcp::socket>(client_context_);
+        boost::system::error_code error;
+        socket->open(boost::asio::ip::tcp::v4(), error);
+        if (!error)
+        {
+          socket->bind(boost::asio::ip::tcp::endpoint(source, 0), error);
+        }
+        if (!error)
+        {
+          socket->connect(target, error);
+        }
+        if (error)
+        {
+          std::cout << "connection " << client_sockets_.size() << " failed, error: " << error.message() << std::endl;
+          return false;
+        }
+        client_sockets_.push_back(std::move(socket));
+      }
+      return true;
+    }
+
+    bool wait_accepted(size_t count)
+    {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+      while (std::chrono::steady_clock::now() < deadline)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (server_connections_.size() >= count)
+          {
+            return true;
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      std::cout << "server accepted less than " << count << " connections in time" << std::endl;
+      return false;
+    }
+
+  private:
+    int port_ = 0;
+    int io_threads_ = 1;
+    bool idle_read_mode_ = true;
+    int settle_ms_ = 1000;
+
+    // client sockets only connect, they are never read or written
+    boost::asio::io_context client_context_;
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::socket>> client_sockets_;
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Connection>> server_connections_;
+  };
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("counts", po::value<std::vector<size_t>>()->multitoken()->default_value({10000, 50000, 100000}, "10000 50000 100000"), "numbers of idle connections to measure")
+    ("port", po::value<int>()->default_value(29600), "port of the in-process server, out of the ephemeral range used by the clients")
+    ("io-threads", po::value<int>()->default_value(2), "io threads of the server")
+    ("idle-read-mode", po::value<bool>()->default_value(true), "connections wait for readable without a receive buffer")
+    ("settle-ms", po::value<int>()->default_value(1000), "wait before every measurement")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  auto counts = vm["counts"].as<std::vector<size_t>>();
+  counts.erase(std::remove(counts.begin(), counts.end(), 0), counts.end());
+  if (vm.count("help") || counts.empty())
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  IdleConnectionBenchmark benchmark(vm["port"].as<int>(), std::max(vm["io-threads"].as<int>(), 1), vm["idle-read-mode"].as<bool>(), std::max(vm["settle-ms"].as<int>(), 0));
+  return benchmark.run(counts) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
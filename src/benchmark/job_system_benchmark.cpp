@@ -0,0 +1,237 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: compare the work stealing job system with a naive thread pool sharing one locked queue
+#include "game/job/job_system.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace multiplayer_server
+{
+  // the usual first thread pool, all threads pop from one queue under one mutex, the caller blocks until its tasks finished
+  class NaiveThreadPool
+  {
+  public:
+    NaiveThreadPool(int thread_count)
+    {
+      for (int i = 0; i < thread_count; i++)
+      {
+        threads_.emplace_back([this]()
+                              { thread_loop(); });
+      }
+    }
+
+    ~NaiveThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      condition_.notify_all();
+      for (auto &thread : threads_)
+      {
+        thread.join();
+      }
+    }
+
+    // non-copyable
+    NaiveThreadPool(const NaiveThreadPool &) = delete;
+    NaiveThreadPool &operator=(const NaiveThreadPool &) = delete;
+    NaiveThreadPool(NaiveThreadPool &&) = delete;
+    NaiveThreadPool &operator=(NaiveThreadPool &&) = delete;
+
+    void submit(std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+      }
+      condition_.notify_one();
+    }
+
+    void parallel_for(size_t begin, size_t end, size_t grain_size, const std::function<void(size_t, size_t)> &function)
+    {
+      std::mutex done_mutex;
+      std::condition_variable done_condition;
+      size_t unfinished = (end - begin + grain_size - 1) / grain_size;
+      for (size_t range_begin = begin; range_begin < end; range_begin += grain_size)
+      {
+        size_t range_end = std::min(range_begin + grain_size, end);
+        submit([&, range_begin, range_end]()
+               {
+                 function(range_begin, range_end);
+                 std::lock_guard<std::mutex> lock(done_mutex);
+                 if (--unfinished == 0)
+                 {
+                   done_condition.notify_one();
+                 } });
+      }
+
+      std::unique_lock<std::mutex> lock(done_mutex);
+      done_condition.wait(lock, [&unfinished]()
+                          { return unfinished == 0; });
+    }
+
+  private:
+    void thread_loop()
+    {
+      while (true)
+      {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          condition_.wait(lock, [this]()
+                          { return stop_ || !tasks_.empty(); });
+          if (stop_ && tasks_.empty())
+          {
+            return;
+          }
+          task = std::move(tasks_.front());
+          tasks_.pop();
+        }
+        task();
+      }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::queue<std::function<void()>> tasks_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+  };
+
+  // a small entity update, integrate a position and keep it inside the world
+  struct BenchmarkBody
+  {
+    float x = 0.0f;
+    float z = 0.0f;
+    float speed_x = 1.0f;
+    float speed_z = 0.5f;
+  };
+
+  static void update_bodies(std::vector<BenchmarkBody> &bodies, size_t begin, size_t end, int work)
+  {
+    for (size_t index = begin; index < end; index++)
+    {
+      auto &body = bodies[index];
+      for (int step = 0; step < work; step++)
+      {
+        body.x = std::fmod(body.x + body.speed_x * 0.033f + 1000.0f, 1000.0f);
+        body.z = std::fmod(body.z + body.speed_z * 0.033f + 1000.0f, 1000.0f);
+      }
+    }
+  }
+
+  // average milliseconds of one round
+  template <typename Function>
+  static double measure(int rounds, Function &&function)
+  {
+    // the first round warms up caches and wakes the threads
+    function();
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+      function();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+  }
+
+  static void print_result(const char *name, double job_system_ms, double thread_pool_ms)
+  {
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(14) << job_system_ms << std::setw(14) << thread_pool_ms
+              << std::setw(10) << std::setprecision(2) << thread_pool_ms / job_system_ms << "x" << std::endl;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("threads", po::value<int>()->default_value(static_cast<int>(std::max(std::thread::hardware_concurrency(), 2u))), "threads executing jobs, the job system counts the calling thread")
+    ("entities", po::value<size_t>()->default_value(100000), "entities updated by parallel_for")
+    ("grain", po::value<size_t>()->default_value(DEFAULT_PARALLEL_FOR_GRAIN_SIZE), "entities in one job")
+    ("work", po::value<int>()->default_value(8), "update steps of one entity")
+    ("tasks", po::value<size_t>()->default_value(10000), "tiny jobs of the fan out test")
+    ("rounds", po::value<int>()->default_value(50), "measured rounds of every test")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int thread_count = std::max(vm["threads"].as<int>(), 2);
+  size_t entity_count = vm["entities"].as<size_t>();
+  size_t grain_size = std::max(vm["grain"].as<size_t>(), static_cast<size_t>(1));
+  int work = std::max(vm["work"].as<int>(), 1);
+  size_t task_count = vm["tasks"].as<size_t>();
+  int rounds = std::max(vm["rounds"].as<int>(), 1);
+
+  // the same number of threads execute jobs in both, the caller of the job system is one of them
+  JobSystem job_system(thread_count - 1);
+  NaiveThreadPool thread_pool(thread_count);
+  std::vector<BenchmarkBody> bodies(entity_count);
+
+  std::cout << thread_count << " threads, " << entity_count << " entities, grain " << grain_size << ", " << rounds << " rounds" << std::endl;
+  std::cout << std::left << std::setw(24) << "test" << std::right << std::setw(14) << "job system ms" << std::setw(14) << "pool ms" << std::setw(11) << "speedup" << std::endl;
+
+  // parallel_for over entity ranges
+  auto update_range = [&bodies, work](size_t begin, size_t end)
+  { update_bodies(bodies, begin, end, work); };
+  double job_system_ms = measure(rounds, [&]()
+                                 { job_system.parallel_for(0, entity_count, grain_size, update_range); });
+  double thread_pool_ms = measure(rounds, [&]()
+                                  { thread_pool.parallel_for(0, entity_count, grain_size, update_range); });
+  print_result("parallel_for", job_system_ms, thread_pool_ms);
+
+  // many tiny independent jobs, the cost is scheduling only
+  std::atomic<uint64_t> counter{0};
+  auto tiny_job = [&counter]()
+  { counter.fetch_add(1, std::memory_order_relaxed); };
+  job_system_ms = measure(rounds, [&]()
+                          {
+                            auto parent = job_system.create_job([]() {});
+                            for (size_t i = 0; i < task_count; i++)
+                            {
+                              job_system.run(job_system.create_job(tiny_job, parent));
+                            }
+                            job_system.run(parent);
+                            job_system.wait(parent); });
+  thread_pool_ms = measure(rounds, [&]()
+                           { thread_pool.parallel_for(0, task_count, 1, [&tiny_job](size_t, size_t)
+                                                      { tiny_job(); }); });
+  print_result("fan out tiny jobs", job_system_ms, thread_pool_ms);
+
+  std::cout << "total tiny jobs executed: " << counter.load() << ", stolen jobs: " << job_system.get_stolen_count() << std::endl;
+  return EXIT_SUCCESS;
+}
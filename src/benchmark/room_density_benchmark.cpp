@@ -0,0 +1,156 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: measure how many small match rooms one core can tick in real time
+#include "game/basic/component.h"
+#include "game/basic/entity.h"
+#include "game/job/job_system.h"
+#include "game/room/room.h"
+#include "game/room/room_manager.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace multiplayer_server
+{
+  // players and projectiles move every tick and stay inside the arena
+  class ArenaMoveComponent : public Component
+  {
+  public:
+    ArenaMoveComponent(Entity *owner, float speed_x, float speed_z) : Component(owner), speed_x_(speed_x), speed_z_(speed_z) {}
+
+    void update(float dt) override
+    {
+      x_ = std::fmod(x_ + speed_x_ * dt + 100.0f, 100.0f);
+      z_ = std::fmod(z_ + speed_z_ * dt + 100.0f, 100.0f);
+    }
+    void render() override {}
+    void before_destruct() override {}
+
+  private:
+    float x_ = 50.0f;
+    float z_ = 50.0f;
+    float speed_x_ = 0.0f;
+    float speed_z_ = 0.0f;
+  };
+
+  // its logger is quiet so the benchmark doesn't measure log files
+  class ArenaEntity : public Entity
+  {
+  public:
+    ArenaEntity(EntityId id) : Entity(id) {}
+
+    static void quiet_logger() { get_entity_logger()->set_level(LoggerLevel::Warn); }
+  };
+
+  // a match: players move, every tick one of them shoots a projectile that lives for one second
+  static void setup_room(Room &room, int player_count)
+  {
+    for (int i = 0; i < player_count; i++)
+    {
+      auto player = room.create_entity<ArenaEntity>();
+      player->add_component<ArenaMoveComponent>(static_cast<float>(i % 7) - 3.0f, static_cast<float>(i % 5) - 2.0f);
+    }
+
+    room.set_tick_handler([](Room &room, float)
+                          {
+                            auto projectile = room.create_entity<ArenaEntity>();
+                            projectile->add_component<ArenaMoveComponent>(20.0f, 10.0f);
+                            EntityId id = projectile->get_id();
+                            projectile->add_timer(1.0f, [&room, id]()
+                                                  { room.destroy_entity(id); }); });
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("rooms", po::value<std::vector<size_t>>()->multitoken()->default_value({100, 1000, 5000}, "100 1000 5000"), "numbers of rooms to measure")
+    ("threads", po::value<int>()->default_value(static_cast<int>(std::max(std::thread::hardware_concurrency(), 2u))), "threads running rooms, the world tick thread included, at least 2")
+    ("players", po::value<int>()->default_value(10), "players in every room")
+    ("tick-rate", po::value<int>()->default_value(ROOM_DEFAULT_TICK_RATE), "ticks per second of every room")
+    ("updates", po::value<int>()->default_value(100), "measured world updates, every room ticks once per update")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  auto room_counts = vm["rooms"].as<std::vector<size_t>>();
+  room_counts.erase(std::remove(room_counts.begin(), room_counts.end(), 0), room_counts.end());
+  if (vm.count("help") || room_counts.empty())
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int thread_count = std::max(vm["threads"].as<int>(), 2);
+  int player_count = std::max(vm["players"].as<int>(), 0);
+  int tick_rate = std::max(vm["tick-rate"].as<int>(), 1);
+  int update_count = std::max(vm["updates"].as<int>(), 1);
+  float tick_delta = 1.0f / static_cast<float>(tick_rate);
+  double tick_budget_us = 1000000.0 / tick_rate;
+
+  ArenaEntity::quiet_logger();
+  // workers plus the world tick thread, which runs rooms while it waits for them
+  JobSystem job_system(thread_count - 1);
+
+  std::cout << thread_count << " threads, " << player_count << " players per room, " << tick_rate << " ticks per second, " << update_count << " updates" << std::endl;
+  std::cout << std::setw(8) << "rooms" << std::setw(12) << "update ms" << std::setw(14) << "parallelism" << std::setw(20) << "cpu us per tick" << std::setw(16) << "rooms per core" << std::setw(10) << "realtime" << std::endl;
+
+  for (size_t room_count : room_counts)
+  {
+    RoomManager room_manager(job_system);
+    for (size_t i = 0; i < room_count; i++)
+    {
+      setup_room(room_manager.create_room(tick_rate), player_count);
+    }
+
+    // fill the projectile timers of the rooms before measuring
+    for (int i = 0; i < tick_rate; i++)
+    {
+      room_manager.update(tick_delta);
+    }
+
+    int64_t duration = 0;
+    int64_t busy = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < update_count; i++)
+    {
+      room_manager.update(tick_delta);
+      duration += room_manager.get_stats().last_duration;
+      busy += room_manager.get_stats().last_busy;
+    }
+    double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // every thread is counted busy for the whole update, so this is an upper bound of the cpu a room needs
+    double update_us = elapsed_us / update_count;
+    double cpu_per_room_tick_us = update_us * thread_count / static_cast<double>(room_count);
+    double rooms_per_core = tick_budget_us / cpu_per_room_tick_us;
+    double parallelism = duration > 0 ? static_cast<double>(busy) / static_cast<double>(duration) : 0.0;
+    std::cout << std::setw(8) << room_count << std::fixed << std::setprecision(3) << std::setw(12) << update_us / 1000.0
+              << std::setw(14) << std::setprecision(2) << parallelism
+              << std::setw(20) << std::setprecision(3) << cpu_per_room_tick_us
+              << std::setw(16) << std::setprecision(0) << rooms_per_core
+              << std::setw(10) << (update_us <= tick_budget_us ? "yes" : "no") << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
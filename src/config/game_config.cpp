@@ -6,6 +6,7 @@
 #include <optional>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 namespace multiplayer_server
 {
@@ -101,6 +102,14 @@ namespace multiplayer_server
       load_logger_config(config_tree);
       load_login_config(config_tree);
       load_services_config(config_tree);
+      load_fault_injection_config(config_tree);
+      load_capture_config(config_tree);
+      load_rate_limit_config(config_tree);
+      load_tick_config(config_tree);
+      load_job_config(config_tree);
+      load_aoi_config(config_tree);
+      load_migration_config(config_tree);
+      load_session_config(config_tree);
     }
     catch(const std::exception& e)
     {
@@ -211,11 +220,41 @@ namespace multiplayer_server
     int concurrency = server_config["concurrency"].GetInt();
 #endif
 
+    // load idle read mode, it's optional
+    bool idle_read_mode = false;
+#ifdef USE_BOOST_JSON_PARSER
+    if (server_config.find("idle_read_mode") != server_config.not_found())
+    {
+      idle_read_mode = server_config.get<bool>("idle_read_mode");
+    }
+#elif USE_RAPIDJSON
+    if (server_config.HasMember("idle_read_mode") && server_config["idle_read_mode"].IsBool())
+    {
+      idle_read_mode = server_config["idle_read_mode"].GetBool();
+    }
+#endif
+
+    // load node id, it's optional, every process of a cluster needs a different one
+    int node_id = 0;
+#ifdef USE_BOOST_JSON_PARSER
+    if (server_config.find("node_id") != server_config.not_found())
+    {
+      node_id = server_config.get<int>("node_id");
+    }
+#elif USE_RAPIDJSON
+    if (server_config.HasMember("node_id") && server_config["node_id"].IsInt())
+    {
+      node_id = server_config["node_id"].GetInt();
+    }
+#endif
+
     // make a shared_ptr of tuple to store server config
     auto server_config_ptr = std::make_shared<AsioServerConfig>();
     server_config_ptr->ip = server_ip;
     server_config_ptr->port = server_port;
     server_config_ptr->concurrency = concurrency;
+    server_config_ptr->idle_read_mode = idle_read_mode;
+    server_config_ptr->node_id = node_id;
     config_[SERVER_CONFIG_STR] = std::static_pointer_cast<void>(server_config_ptr);
   }
 
@@ -597,12 +636,14 @@ namespace multiplayer_server
 #ifdef USE_BOOST_JSON_PARSER
     for (const auto &service : services_config)
     {
-      ServiceConfig service_config;
+      GameServiceConfig service_config;
       service_config.service_name = service.second.get<std::string>("name");
       for (const auto &component : service.second.get_child("components"))
       {
-        service_config.components.emplace_back(component.second.get<std::string>(""));
+        service_config.service_components.emplace_back(component.second.get<std::string>(""));
       }
+      service_config.instances = service.second.get<int>("instances", service_config.instances);
+      service_config.routing = service.second.get<std::string>("routing", service_config.routing);
       data_ptr->emplace_back(service_config);
     }
 #elif USE_RAPIDJSON
@@ -622,6 +663,14 @@ namespace multiplayer_server
       {
         service_config.service_components.emplace_back(component.GetString());
       }
+      if (service.HasMember("instances") && service["instances"].IsInt())
+      {
+        service_config.instances = service["instances"].GetInt();
+      }
+      if (service.HasMember("routing") && service["routing"].IsString())
+      {
+        service_config.routing = service["routing"].GetString();
+      }
 
       data_ptr->emplace_back(service_config);
     }
@@ -629,4 +678,417 @@ namespace multiplayer_server
 
     config_[SERVICES_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
   }
-}
\ No newline at end of file
+
+  // load network fault injection configuration
+  void GameConfig::load_fault_injection_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<FaultInjectionConfig>();
+
+    // fault injection is optional, disabled if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(FAULT_INJECTION_CONFIG_STR) == config_tree.not_found())
+    {
+      config_[FAULT_INJECTION_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+      return;
+    }
+
+    const auto &fault_config = config_tree.get_child(FAULT_INJECTION_CONFIG_STR);
+    data_ptr->enabled = fault_config.get<bool>("enabled", false);
+
+    if (fault_config.find("rules") != fault_config.not_found())
+    {
+      for (const auto &rule : fault_config.get_child("rules"))
+      {
+        FaultInjectionRule rule_config;
+        rule_config.ip_range = rule.second.get<std::string>("ip_range", "");
+        rule_config.latency_ms = rule.second.get<int>("latency_ms", 0);
+        rule_config.jitter_ms = rule.second.get<int>("jitter_ms", 0);
+        rule_config.bandwidth_bytes_per_second = rule.second.get<int64_t>("bandwidth_bytes_per_second", 0);
+        rule_config.loss_rate = rule.second.get<double>("loss_rate", 0.0);
+        rule_config.reorder_rate = rule.second.get<double>("reorder_rate", 0.0);
+        data_ptr->rules.emplace_back(rule_config);
+      }
+    }
+#elif USE_RAPIDJSON
+    if (!config_tree.HasMember(FAULT_INJECTION_CONFIG_STR) || !config_tree[FAULT_INJECTION_CONFIG_STR].IsObject())
+    {
+      config_[FAULT_INJECTION_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+      return;
+    }
+
+    const auto &fault_config = config_tree[FAULT_INJECTION_CONFIG_STR];
+    if (fault_config.HasMember("enabled") && fault_config["enabled"].IsBool())
+    {
+      data_ptr->enabled = fault_config["enabled"].GetBool();
+    }
+
+    if (fault_config.HasMember("rules") && fault_config["rules"].IsArray())
+    {
+      for (const auto &rule : fault_config["rules"].GetArray())
+      {
+        if (!rule.IsObject())
+        {
+          logger_->error("fault injection rule is not a object");
+          continue;
+        }
+
+        FaultInjectionRule rule_config;
+        if (rule.HasMember("ip_range") && rule["ip_range"].IsString())
+        {
+          rule_config.ip_range = rule["ip_range"].GetString();
+        }
+        if (rule.HasMember("latency_ms") && rule["latency_ms"].IsInt())
+        {
+          rule_config.latency_ms = rule["latency_ms"].GetInt();
+        }
+        if (rule.HasMember("jitter_ms") && rule["jitter_ms"].IsInt())
+        {
+          rule_config.jitter_ms = rule["jitter_ms"].GetInt();
+        }
+        if (rule.HasMember("bandwidth_bytes_per_second") && rule["bandwidth_bytes_per_second"].IsNumber())
+        {
+          // written as 1e6 or 1000000.0 it's a double, GetInt64 only accepts integers
+          const auto &bandwidth = rule["bandwidth_bytes_per_second"];
+          rule_config.bandwidth_bytes_per_second = bandwidth.IsInt64() ? bandwidth.GetInt64() : static_cast<int64_t>(bandwidth.GetDouble());
+        }
+        if (rule.HasMember("loss_rate") && rule["loss_rate"].IsNumber())
+        {
+          rule_config.loss_rate = rule["loss_rate"].GetDouble();
+        }
+        if (rule.HasMember("reorder_rate") && rule["reorder_rate"].IsNumber())
+        {
+          rule_config.reorder_rate = rule["reorder_rate"].GetDouble();
+        }
+        data_ptr->rules.emplace_back(rule_config);
+      }
+    }
+#endif
+
+    // probabilities must be in [0, 1]
+    for (auto &rule : data_ptr->rules)
+    {
+      rule.loss_rate = std::clamp(rule.loss_rate, 0.0, 1.0);
+      rule.reorder_rate = std::clamp(rule.reorder_rate, 0.0, 1.0);
+      rule.jitter_ms = std::max(rule.jitter_ms, 0);
+    }
+
+    if (data_ptr->enabled)
+    {
+      logger_->warn("network fault injection is enabled with {} rules", data_ptr->rules.size());
+    }
+    config_[FAULT_INJECTION_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load inbound traffic capture configuration
+  void GameConfig::load_capture_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<TrafficCaptureConfig>();
+
+    // capture is optional, disabled if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(CAPTURE_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &capture_config = config_tree.get_child(CAPTURE_CONFIG_STR);
+      data_ptr->enabled = capture_config.get<bool>("enabled", false);
+      data_ptr->file_path = capture_config.get<std::string>("file", "");
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(CAPTURE_CONFIG_STR) && config_tree[CAPTURE_CONFIG_STR].IsObject())
+    {
+      const auto &capture_config = config_tree[CAPTURE_CONFIG_STR];
+      if (capture_config.HasMember("enabled") && capture_config["enabled"].IsBool())
+      {
+        data_ptr->enabled = capture_config["enabled"].GetBool();
+      }
+      if (capture_config.HasMember("file") && capture_config["file"].IsString())
+      {
+        data_ptr->file_path = capture_config["file"].GetString();
+      }
+    }
+#endif
+
+    if (data_ptr->enabled && data_ptr->file_path.empty())
+    {
+      logger_->error("capture is enabled but capture file is empty");
+      data_ptr->enabled = false;
+    }
+    config_[CAPTURE_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load inbound message rate limit configuration
+  void GameConfig::load_rate_limit_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<RateLimitConfig>();
+
+    // rate limit is optional, disabled if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(RATE_LIMIT_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &rate_config = config_tree.get_child(RATE_LIMIT_CONFIG_STR);
+      data_ptr->enabled = rate_config.get<bool>("enabled", false);
+      data_ptr->default_rate = rate_config.get<double>("default_rate", 0.0);
+      data_ptr->default_burst = rate_config.get<double>("default_burst", 0.0);
+      data_ptr->max_violations = rate_config.get<double>("max_violations", data_ptr->max_violations);
+      data_ptr->violation_decay_per_second = rate_config.get<double>("violation_decay_per_second", data_ptr->violation_decay_per_second);
+
+      if (rate_config.find("messages") != rate_config.not_found())
+      {
+        for (const auto &message : rate_config.get_child("messages"))
+        {
+          RateLimitRule rule;
+          rule.message_id = message.second.get<uint16_t>("id");
+          rule.rate = message.second.get<double>("rate", 0.0);
+          rule.burst = message.second.get<double>("burst", 0.0);
+          data_ptr->rules.emplace_back(rule);
+        }
+      }
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(RATE_LIMIT_CONFIG_STR) && config_tree[RATE_LIMIT_CONFIG_STR].IsObject())
+    {
+      const auto &rate_config = config_tree[RATE_LIMIT_CONFIG_STR];
+      if (rate_config.HasMember("enabled") && rate_config["enabled"].IsBool())
+      {
+        data_ptr->enabled = rate_config["enabled"].GetBool();
+      }
+      if (rate_config.HasMember("default_rate") && rate_config["default_rate"].IsNumber())
+      {
+        data_ptr->default_rate = rate_config["default_rate"].GetDouble();
+      }
+      if (rate_config.HasMember("default_burst") && rate_config["default_burst"].IsNumber())
+      {
+        data_ptr->default_burst = rate_config["default_burst"].GetDouble();
+      }
+      if (rate_config.HasMember("max_violations") && rate_config["max_violations"].IsNumber())
+      {
+        data_ptr->max_violations = rate_config["max_violations"].GetDouble();
+      }
+      if (rate_config.HasMember("violation_decay_per_second") && rate_config["violation_decay_per_second"].IsNumber())
+      {
+        data_ptr->violation_decay_per_second = rate_config["violation_decay_per_second"].GetDouble();
+      }
+
+      if (rate_config.HasMember("messages") && rate_config["messages"].IsArray())
+      {
+        for (const auto &message : rate_config["messages"].GetArray())
+        {
+          if (!message.IsObject() || !message.HasMember("id") || !message["id"].IsUint() || message["id"].GetUint() > 0xffff)
+          {
+            logger_->error("rate limit message rule needs a valid id");
+            continue;
+          }
+
+          RateLimitRule rule;
+          rule.message_id = static_cast<uint16_t>(message["id"].GetUint());
+          if (message.HasMember("rate") && message["rate"].IsNumber())
+          {
+            rule.rate = message["rate"].GetDouble();
+          }
+          if (message.HasMember("burst") && message["burst"].IsNumber())
+          {
+            rule.burst = message["burst"].GetDouble();
+          }
+          data_ptr->rules.emplace_back(rule);
+        }
+      }
+    }
+#endif
+
+    config_[RATE_LIMIT_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load world tick configuration
+  void GameConfig::load_tick_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<TickConfig>();
+
+    // tick is optional, use default values if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(TICK_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &tick_config = config_tree.get_child(TICK_CONFIG_STR);
+      data_ptr->rate = tick_config.get<int>("rate", data_ptr->rate);
+      data_ptr->max_catch_up_ticks = tick_config.get<int>("max_catch_up_ticks", data_ptr->max_catch_up_ticks);
+      data_ptr->stats_interval = tick_config.get<int>("stats_interval", data_ptr->stats_interval);
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(TICK_CONFIG_STR) && config_tree[TICK_CONFIG_STR].IsObject())
+    {
+      const auto &tick_config = config_tree[TICK_CONFIG_STR];
+      if (tick_config.HasMember("rate") && tick_config["rate"].IsInt())
+      {
+        data_ptr->rate = tick_config["rate"].GetInt();
+      }
+      if (tick_config.HasMember("max_catch_up_ticks") && tick_config["max_catch_up_ticks"].IsInt())
+      {
+        data_ptr->max_catch_up_ticks = tick_config["max_catch_up_ticks"].GetInt();
+      }
+      if (tick_config.HasMember("stats_interval") && tick_config["stats_interval"].IsInt())
+      {
+        data_ptr->stats_interval = tick_config["stats_interval"].GetInt();
+      }
+    }
+#endif
+
+    if (data_ptr->rate <= 0)
+    {
+      logger_->error("tick rate must be positive, use default value");
+      data_ptr->rate = TickConfig().rate;
+    }
+    config_[TICK_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load job system configuration
+  void GameConfig::load_job_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<JobSystemConfig>();
+
+    // job system is optional, use default values if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(JOB_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &job_config = config_tree.get_child(JOB_CONFIG_STR);
+      data_ptr->worker_count = job_config.get<int>("worker_count", data_ptr->worker_count);
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(JOB_CONFIG_STR) && config_tree[JOB_CONFIG_STR].IsObject())
+    {
+      const auto &job_config = config_tree[JOB_CONFIG_STR];
+      if (job_config.HasMember("worker_count") && job_config["worker_count"].IsInt())
+      {
+        data_ptr->worker_count = job_config["worker_count"].GetInt();
+      }
+    }
+#endif
+
+    config_[JOB_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load area of interest configuration
+  void GameConfig::load_aoi_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<AoiConfig>();
+
+    // aoi is optional, use default values if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(AOI_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &aoi_config = config_tree.get_child(AOI_CONFIG_STR);
+      data_ptr->cell_size = aoi_config.get<double>("cell_size", data_ptr->cell_size);
+      data_ptr->default_view_radius = aoi_config.get<double>("default_view_radius", data_ptr->default_view_radius);
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(AOI_CONFIG_STR) && config_tree[AOI_CONFIG_STR].IsObject())
+    {
+      const auto &aoi_config = config_tree[AOI_CONFIG_STR];
+      if (aoi_config.HasMember("cell_size") && aoi_config["cell_size"].IsNumber())
+      {
+        data_ptr->cell_size = aoi_config["cell_size"].GetDouble();
+      }
+      if (aoi_config.HasMember("default_view_radius") && aoi_config["default_view_radius"].IsNumber())
+      {
+        data_ptr->default_view_radius = aoi_config["default_view_radius"].GetDouble();
+      }
+    }
+#endif
+
+    if (data_ptr->cell_size <= 0.0)
+    {
+      logger_->error("aoi cell size must be positive, use default value");
+      data_ptr->cell_size = AoiConfig().cell_size;
+    }
+    if (data_ptr->default_view_radius <= 0.0)
+    {
+      logger_->error("aoi default view radius must be positive, use default value");
+      data_ptr->default_view_radius = AoiConfig().default_view_radius;
+    }
+    config_[AOI_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load entity migration configuration
+  void GameConfig::load_migration_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<MigrationConfig>();
+
+    // migration is optional, use default values if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(MIGRATION_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &migration_config = config_tree.get_child(MIGRATION_CONFIG_STR);
+      data_ptr->port = migration_config.get<int>("port", data_ptr->port);
+      data_ptr->handoff_timeout = migration_config.get<int>("handoff_timeout", data_ptr->handoff_timeout);
+      data_ptr->max_buffered_messages = migration_config.get<int>("max_buffered_messages", data_ptr->max_buffered_messages);
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(MIGRATION_CONFIG_STR) && config_tree[MIGRATION_CONFIG_STR].IsObject())
+    {
+      const auto &migration_config = config_tree[MIGRATION_CONFIG_STR];
+      if (migration_config.HasMember("port") && migration_config["port"].IsInt())
+      {
+        data_ptr->port = migration_config["port"].GetInt();
+      }
+      if (migration_config.HasMember("handoff_timeout") && migration_config["handoff_timeout"].IsInt())
+      {
+        data_ptr->handoff_timeout = migration_config["handoff_timeout"].GetInt();
+      }
+      if (migration_config.HasMember("max_buffered_messages") && migration_config["max_buffered_messages"].IsInt())
+      {
+        data_ptr->max_buffered_messages = migration_config["max_buffered_messages"].GetInt();
+      }
+    }
+#endif
+
+    if (data_ptr->handoff_timeout <= 0)
+    {
+      logger_->error("migration handoff timeout must be positive, use default value");
+      data_ptr->handoff_timeout = MigrationConfig().handoff_timeout;
+    }
+    config_[MIGRATION_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+
+  // load resumable session config
+  void GameConfig::load_session_config(const JsonTree &config_tree)
+  {
+    auto data_ptr = std::make_shared<SessionConfig>();
+
+    // session is optional, use default values if not exist
+#ifdef USE_BOOST_JSON_PARSER
+    if (config_tree.find(SESSION_CONFIG_STR) != config_tree.not_found())
+    {
+      const auto &session_config = config_tree.get_child(SESSION_CONFIG_STR);
+      data_ptr->grace_period = session_config.get<int>("grace_period", data_ptr->grace_period);
+      data_ptr->max_buffered_messages = session_config.get<int>("max_buffered_messages", data_ptr->max_buffered_messages);
+      data_ptr->secret = session_config.get<std::string>("secret", data_ptr->secret);
+    }
+#elif USE_RAPIDJSON
+    if (config_tree.HasMember(SESSION_CONFIG_STR) && config_tree[SESSION_CONFIG_STR].IsObject())
+    {
+      const auto &session_config = config_tree[SESSION_CONFIG_STR];
+      if (session_config.HasMember("grace_period") && session_config["grace_period"].IsInt())
+      {
+        data_ptr->grace_period = session_config["grace_period"].GetInt();
+      }
+      if (session_config.HasMember("max_buffered_messages") && session_config["max_buffered_messages"].IsInt())
+      {
+        data_ptr->max_buffered_messages = session_config["max_buffered_messages"].GetInt();
+      }
+      if (session_config.HasMember("secret") && session_config["secret"].IsString())
+      {
+        data_ptr->secret = session_config["secret"].GetString();
+      }
+    }
+#endif
+
+    if (data_ptr->grace_period < 0)
+    {
+      logger_->error("session grace period must not be negative, disable resumable sessions");
+      data_ptr->grace_period = 0;
+    }
+    if (data_ptr->max_buffered_messages < 0)
+    {
+      logger_->error("session max buffered messages must not be negative, use default value");
+      data_ptr->max_buffered_messages = SessionConfig().max_buffered_messages;
+    }
+    config_[SESSION_CONFIG_STR] = std::static_pointer_cast<void>(data_ptr);
+  }
+}
@@ -4,6 +4,8 @@
 #pragma once
 
 #include "log/logger.h"
+#include "network/fault_injection.h"
+#include "network/rate_limiter.h"
 #ifdef USE_BOOST_JSON_PARSER
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -19,6 +21,14 @@
 #define LOG_CONFIG_STR "logger"
 #define LOGIN_CONFIG_STR "login"
 #define SERVICES_CONFIG_STR "services"
+#define FAULT_INJECTION_CONFIG_STR "fault_injection"
+#define CAPTURE_CONFIG_STR "capture"
+#define RATE_LIMIT_CONFIG_STR "rate_limit"
+#define TICK_CONFIG_STR "tick"
+#define JOB_CONFIG_STR "job"
+#define AOI_CONFIG_STR "aoi"
+#define MIGRATION_CONFIG_STR "migration"
+#define SESSION_CONFIG_STR "session"
 
 namespace multiplayer_server
 {
@@ -41,6 +51,9 @@ namespace multiplayer_server
   {
     std::string service_name = "";
     std::vector<std::string> service_components = {};
+    // local instances of the service and how requests are spread over them
+    int instances = 1;
+    std::string routing = "round_robin";
   };
 
   struct AsioServerConfig
@@ -48,6 +61,60 @@ namespace multiplayer_server
     std::string ip = "";
     int port = 0;
     int concurrency = 0;
+    // connections wait for readable without holding a receive buffer
+    bool idle_read_mode = false;
+    // node id of this process, part of every entity id
+    int node_id = 0;
+  };
+
+  struct TrafficCaptureConfig
+  {
+    bool enabled = false;
+    std::string file_path = "";
+  };
+
+  struct TickConfig
+  {
+    // ticks per second
+    int rate = 30;
+    // max ticks to run back to back when the world tick falls behind
+    int max_catch_up_ticks = 5;
+    // seconds between two tick stats logs, 0 disables it
+    int stats_interval = 10;
+  };
+
+  struct JobSystemConfig
+  {
+    // 0 means one worker per core except the tick thread
+    int worker_count = 0;
+  };
+
+  struct AoiConfig
+  {
+    // edge length of one grid cell, about the common view radius works well
+    double cell_size = 50.0;
+    // view radius of entities that don't set their own
+    double default_view_radius = 100.0;
+  };
+
+  struct MigrationConfig
+  {
+    // port other processes send entities to, 0 disables migration
+    int port = 0;
+    // milliseconds to wait for the target process to accept an entity before taking it back
+    int handoff_timeout = 5000;
+    // max messages buffered for one entity during handoff, later ones are dropped
+    int max_buffered_messages = 1024;
+  };
+
+  struct SessionConfig
+  {
+    // seconds a disconnected player entity waits for its client to resume, 0 disables resumable sessions
+    int grace_period = 30;
+    // max messages kept for a disconnected client, the session ends when more are sent
+    int max_buffered_messages = 256;
+    // key signing resume tokens, a random key is used if empty, tokens then don't survive a restart
+    std::string secret = "";
   };
 
   class GameConfig
@@ -96,6 +163,22 @@ namespace multiplayer_server
     void load_login_config(const JsonTree &tree);
     // load game services config
     void load_services_config(const JsonTree &tree);
+    // load network fault injection config, it's optional
+    void load_fault_injection_config(const JsonTree &tree);
+    // load inbound traffic capture config, it's optional
+    void load_capture_config(const JsonTree &tree);
+    // load inbound message rate limit config, it's optional
+    void load_rate_limit_config(const JsonTree &tree);
+    // load world tick config, it's optional
+    void load_tick_config(const JsonTree &tree);
+    // load job system config, it's optional
+    void load_job_config(const JsonTree &tree);
+    // load area of interest config, it's optional
+    void load_aoi_config(const JsonTree &tree);
+    // load entity migration config, it's optional
+    void load_migration_config(const JsonTree &tree);
+    // load resumable session config, it's optional
+    void load_session_config(const JsonTree &tree);
 
   private:
     // config node
@@ -0,0 +1,467 @@
+#include "aoi_grid.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AOI_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace multiplayer_server
+{
+  // append entries whose position is within radius of (x, z)
+  static void filter_in_range(const float *xs, const float *zs, const uint32_t *entries, size_t count,
+                              float x, float z, float radius_square, std::vector<uint32_t> &out)
+  {
+    size_t i = 0;
+#ifdef AOI_USE_SSE2
+    const __m128 center_x = _mm_set1_ps(x);
+    const __m128 center_z = _mm_set1_ps(z);
+    const __m128 range = _mm_set1_ps(radius_square);
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), center_x);
+      __m128 dz = _mm_sub_ps(_mm_loadu_ps(zs + i), center_z);
+      __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+      int mask = _mm_movemask_ps(_mm_cmple_ps(distance, range));
+      for (int bit = 0; mask != 0; bit++, mask >>= 1)
+      {
+        if (mask & 1)
+        {
+          out.push_back(entries[i + bit]);
+        }
+      }
+    }
+#endif
+    // scalar path for the tail, or all entries without SSE2
+    for (; i < count; i++)
+    {
+      float dx = xs[i] - x;
+      float dz = zs[i] - z;
+      if (dx * dx + dz * dz <= radius_square)
+      {
+        out.push_back(entries[i]);
+      }
+    }
+  }
+
+  static float distance_square(float x1, float z1, float x2, float z2)
+  {
+    float dx = x1 - x2;
+    float dz = z1 - z2;
+    return dx * dx + dz * dz;
+  }
+
+  AoiGrid::AoiGrid(float cell_size) : cell_size_(cell_size > 0.0f ? cell_size : AOI_DEFAULT_CELL_SIZE)
+  {
+  }
+
+  AoiGrid &AoiGrid::get_instance()
+  {
+    static AoiGrid instance;
+    return instance;
+  }
+
+  bool AoiGrid::set_cell_size(float cell_size)
+  {
+    if (cell_size <= 0.0f || !entries_.empty())
+    {
+      return false;
+    }
+    cell_size_ = cell_size;
+    return true;
+  }
+
+  uint64_t AoiGrid::get_cell_key(int32_t cell_x, int32_t cell_z)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cell_x)) << 32) | static_cast<uint32_t>(cell_z);
+  }
+
+  int32_t AoiGrid::get_cell_coord(float value) const
+  {
+    return static_cast<int32_t>(std::floor(value / cell_size_));
+  }
+
+  bool AoiGrid::add(EntityId id, float x, float z, float view_radius)
+  {
+    if (indexes_.find(id) != indexes_.end())
+    {
+      return false;
+    }
+
+    uint32_t index = 0;
+    if (!free_indexes_.empty())
+    {
+      index = free_indexes_.back();
+      free_indexes_.pop_back();
+    }
+    else
+    {
+      index = static_cast<uint32_t>(entries_.size());
+      entries_.emplace_back();
+    }
+
+    Entry &entry = entries_[index];
+    entry.id = id;
+    entry.x = x;
+    entry.z = z;
+    entry.view_radius = std::max(view_radius, 0.0f);
+    entry.alive = true;
+    entry.dirty = false;
+    entry.moved = false;
+    max_view_radius_ = std::max(max_view_radius_, entry.view_radius);
+
+    indexes_.emplace(id, index);
+    insert_into_cell(index);
+    mark_dirty(index);
+    return true;
+  }
+
+  bool AoiGrid::remove(EntityId id)
+  {
+    auto iter = indexes_.find(id);
+    if (iter == indexes_.end())
+    {
+      return false;
+    }
+
+    uint32_t index = iter->second;
+    indexes_.erase(iter);
+    // out of the grid now, observers get leave events in next update
+    remove_from_cell(index);
+    // keep the handler until next update, remove() may be called from the handler itself
+    entries_[index].alive = false;
+    removed_indexes_.push_back(index);
+    return true;
+  }
+
+  bool AoiGrid::move(EntityId id, float x, float z)
+  {
+    auto iter = indexes_.find(id);
+    if (iter == indexes_.end())
+    {
+      return false;
+    }
+
+    uint32_t index = iter->second;
+    Entry &entry = entries_[index];
+    if (entry.x == x && entry.z == z)
+    {
+      return true;
+    }
+
+    int32_t cell_x = get_cell_coord(x);
+    int32_t cell_z = get_cell_coord(z);
+    if (cell_x != entry.cell_x || cell_z != entry.cell_z)
+    {
+      remove_from_cell(index);
+      entry.x = x;
+      entry.z = z;
+      insert_into_cell(index);
+    }
+    else
+    {
+      entry.x = x;
+      entry.z = z;
+      Cell &cell = cells_[get_cell_key(cell_x, cell_z)];
+      cell.xs[entry.cell_slot] = x;
+      cell.zs[entry.cell_slot] = z;
+    }
+
+    entry.moved = true;
+    mark_dirty(index);
+    return true;
+  }
+
+  bool AoiGrid::set_view_radius(EntityId id, float view_radius)
+  {
+    auto iter = indexes_.find(id);
+    if (iter == indexes_.end())
+    {
+      return false;
+    }
+
+    Entry &entry = entries_[iter->second];
+    entry.view_radius = std::max(view_radius, 0.0f);
+    // max radius never shrinks, it only makes the search of observers a bit wider
+    max_view_radius_ = std::max(max_view_radius_, entry.view_radius);
+    mark_dirty(iter->second);
+    return true;
+  }
+
+  bool AoiGrid::set_event_handler(EntityId id, EventHandler handler)
+  {
+    auto iter = indexes_.find(id);
+    if (iter == indexes_.end())
+    {
+      return false;
+    }
+
+    entries_[iter->second].handler = std::move(handler);
+    return true;
+  }
+
+  void AoiGrid::insert_into_cell(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+    entry.cell_x = get_cell_coord(entry.x);
+    entry.cell_z = get_cell_coord(entry.z);
+
+    Cell &cell = cells_[get_cell_key(entry.cell_x, entry.cell_z)];
+    entry.cell_slot = static_cast<uint32_t>(cell.entries.size());
+    cell.entries.push_back(index);
+    cell.xs.push_back(entry.x);
+    cell.zs.push_back(entry.z);
+  }
+
+  void AoiGrid::remove_from_cell(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+    auto iter = cells_.find(get_cell_key(entry.cell_x, entry.cell_z));
+    if (iter == cells_.end())
+    {
+      return;
+    }
+
+    // swap with the last one, keep arrays dense
+    Cell &cell = iter->second;
+    uint32_t slot = entry.cell_slot;
+    uint32_t last = static_cast<uint32_t>(cell.entries.size() - 1);
+    if (slot != last)
+    {
+      cell.entries[slot] = cell.entries[last];
+      cell.xs[slot] = cell.xs[last];
+      cell.zs[slot] = cell.zs[last];
+      entries_[cell.entries[slot]].cell_slot = slot;
+    }
+    cell.entries.pop_back();
+    cell.xs.pop_back();
+    cell.zs.pop_back();
+
+    if (cell.entries.empty())
+    {
+      cells_.erase(iter);
+    }
+  }
+
+  void AoiGrid::mark_dirty(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+    if (!entry.dirty)
+    {
+      entry.dirty = true;
+      dirty_indexes_.push_back(index);
+    }
+  }
+
+  void AoiGrid::query(float x, float z, float radius)
+  {
+    candidates_.clear();
+
+    int32_t min_x = get_cell_coord(x - radius);
+    int32_t max_x = get_cell_coord(x + radius);
+    int32_t min_z = get_cell_coord(z - radius);
+    int32_t max_z = get_cell_coord(z + radius);
+    float radius_square = radius * radius;
+
+    for (int32_t cell_x = min_x; cell_x <= max_x; cell_x++)
+    {
+      for (int32_t cell_z = min_z; cell_z <= max_z; cell_z++)
+      {
+        auto iter = cells_.find(get_cell_key(cell_x, cell_z));
+        if (iter == cells_.end())
+        {
+          continue;
+        }
+
+        const Cell &cell = iter->second;
+        filter_in_range(cell.xs.data(), cell.zs.data(), cell.entries.data(), cell.entries.size(), x, z, radius_square, candidates_);
+      }
+    }
+  }
+
+  void AoiGrid::push_event(AoiEventType type, uint32_t watcher, uint32_t target)
+  {
+    const Entry &target_entry = entries_[target];
+    events_.push_back(AoiEvent{type, entries_[watcher].id, target_entry.id, target_entry.x, target_entry.z});
+  }
+
+  void AoiGrid::apply_remove(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+    for (uint32_t observer : entry.observers)
+    {
+      Entry &observer_entry = entries_[observer];
+      observer_entry.visible.erase(index);
+      // the observer may be removed in the same tick, its id can already belong to a new entry
+      if (observer_entry.alive)
+      {
+        push_event(AoiEventType::kLeave, observer, index);
+      }
+    }
+    for (uint32_t target : entry.visible)
+    {
+      entries_[target].observers.erase(index);
+    }
+
+    entry.observers.clear();
+    entry.visible.clear();
+    entry.handler = nullptr;
+    entry.dirty = false;
+    entry.moved = false;
+    free_indexes_.push_back(index);
+  }
+
+  void AoiGrid::apply_as_target(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+
+    // watchers in range of the largest view radius, plus current observers who may leave
+    query(entry.x, entry.z, max_view_radius_);
+    known_.assign(entry.observers.begin(), entry.observers.end());
+    for (uint32_t candidate : candidates_)
+    {
+      if (!entry.observers.count(candidate))
+      {
+        known_.push_back(candidate);
+      }
+    }
+
+    for (uint32_t watcher : known_)
+    {
+      if (watcher == index)
+      {
+        continue;
+      }
+
+      Entry &watcher_entry = entries_[watcher];
+      bool in_view = distance_square(watcher_entry.x, watcher_entry.z, entry.x, entry.z) <= watcher_entry.view_radius * watcher_entry.view_radius;
+      bool was_in_view = entry.observers.count(watcher) > 0;
+
+      if (in_view && !was_in_view)
+      {
+        entry.observers.insert(watcher);
+        watcher_entry.visible.insert(index);
+        push_event(AoiEventType::kEnter, watcher, index);
+      }
+      else if (!in_view && was_in_view)
+      {
+        entry.observers.erase(watcher);
+        watcher_entry.visible.erase(index);
+        push_event(AoiEventType::kLeave, watcher, index);
+      }
+      else if (in_view && entry.moved)
+      {
+        push_event(AoiEventType::kMove, watcher, index);
+      }
+    }
+  }
+
+  void AoiGrid::apply_as_watcher(uint32_t index)
+  {
+    Entry &entry = entries_[index];
+
+    // targets in own view radius, plus current visible targets who may leave
+    query(entry.x, entry.z, entry.view_radius);
+    known_.assign(entry.visible.begin(), entry.visible.end());
+    for (uint32_t candidate : candidates_)
+    {
+      if (!entry.visible.count(candidate))
+      {
+        known_.push_back(candidate);
+      }
+    }
+
+    float radius_square = entry.view_radius * entry.view_radius;
+    for (uint32_t target : known_)
+    {
+      if (target == index)
+      {
+        continue;
+      }
+
+      Entry &target_entry = entries_[target];
+      bool in_view = distance_square(entry.x, entry.z, target_entry.x, target_entry.z) <= radius_square;
+      bool was_in_view = entry.visible.count(target) > 0;
+
+      if (in_view && !was_in_view)
+      {
+        entry.visible.insert(target);
+        target_entry.observers.insert(index);
+        push_event(AoiEventType::kEnter, index, target);
+      }
+      else if (!in_view && was_in_view)
+      {
+        entry.visible.erase(target);
+        target_entry.observers.erase(index);
+        push_event(AoiEventType::kLeave, index, target);
+      }
+    }
+  }
+
+  void AoiGrid::update()
+  {
+    events_.clear();
+
+    for (uint32_t index : removed_indexes_)
+    {
+      apply_remove(index);
+    }
+    removed_indexes_.clear();
+
+    for (uint32_t index : dirty_indexes_)
+    {
+      if (!entries_[index].alive || !entries_[index].dirty)
+      {
+        continue;
+      }
+      apply_as_target(index);
+      apply_as_watcher(index);
+    }
+
+    for (uint32_t index : dirty_indexes_)
+    {
+      entries_[index].dirty = false;
+      entries_[index].moved = false;
+    }
+    dirty_indexes_.clear();
+
+    // dispatch after all changes applied, handlers see a consistent grid
+    for (const auto &event : events_)
+    {
+      auto iter = indexes_.find(event.watcher);
+      if (iter != indexes_.end() && entries_[iter->second].handler)
+      {
+        entries_[iter->second].handler(event);
+      }
+    }
+  }
+
+  std::vector<EntityId> AoiGrid::get_visible(EntityId id) const
+  {
+    std::vector<EntityId> result;
+    auto iter = indexes_.find(id);
+    if (iter != indexes_.end())
+    {
+      for (uint32_t target : entries_[iter->second].visible)
+      {
+        result.push_back(entries_[target].id);
+      }
+    }
+    return result;
+  }
+
+  std::vector<EntityId> AoiGrid::get_observers(EntityId id) const
+  {
+    std::vector<EntityId> result;
+    auto iter = indexes_.find(id);
+    if (iter != indexes_.end())
+    {
+      for (uint32_t observer : entries_[iter->second].observers)
+      {
+        result.push_back(entries_[observer].id);
+      }
+    }
+    return result;
+  }
+}
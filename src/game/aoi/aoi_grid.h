@@ -0,0 +1,160 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: grid based area of interest, decide which entities every entity can see
+#pragma once
+
+#include "game/basic/entity_id.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// default edge length of one grid cell
+#define AOI_DEFAULT_CELL_SIZE 50.0f
+// default view radius of an entity
+#define AOI_DEFAULT_VIEW_RADIUS 100.0f
+
+namespace multiplayer_server
+{
+  enum class AoiEventType : uint8_t
+  {
+    // target comes into the view of watcher
+    kEnter,
+    // target goes out of the view of watcher
+    kLeave,
+    // target moves inside the view of watcher
+    kMove,
+  };
+
+  struct AoiEvent
+  {
+    AoiEventType type = AoiEventType::kEnter;
+    EntityId watcher = kInvalidEntityId;
+    EntityId target = kInvalidEntityId;
+    // position of target
+    float x = 0.0f;
+    float z = 0.0f;
+  };
+
+  // entities are bucketed into square cells on the x-z plane
+  // add, move, remove and view radius changes only mark entries dirty, update() applies them once per tick
+  // and produces all enter, leave and move events of the tick in one batch
+  // distance checks of a cell run 4 entities at a time with SSE2, other platforms use the scalar path
+  // not thread safe, only used by the tick thread
+  class AoiGrid
+  {
+  public:
+    using EventHandler = std::function<void(const AoiEvent &event)>;
+
+  public:
+    AoiGrid(float cell_size = AOI_DEFAULT_CELL_SIZE);
+    ~AoiGrid() = default;
+
+    // non-copyable
+    AoiGrid(const AoiGrid &) = delete;
+    AoiGrid &operator=(const AoiGrid &) = delete;
+    AoiGrid(AoiGrid &&) = delete;
+    AoiGrid &operator=(AoiGrid &&) = delete;
+
+    // grid of the game world
+    static AoiGrid &get_instance();
+
+    // cell size can only be changed while the grid is empty
+    bool set_cell_size(float cell_size);
+    float get_cell_size() const { return cell_size_; }
+
+    // view radius of entities that don't set their own
+    void set_default_view_radius(float view_radius) { default_view_radius_ = view_radius > 0.0f ? view_radius : AOI_DEFAULT_VIEW_RADIUS; }
+    float get_default_view_radius() const { return default_view_radius_; }
+
+    bool add(EntityId id, float x, float z, float view_radius);
+    bool remove(EntityId id);
+    bool move(EntityId id, float x, float z);
+    bool set_view_radius(EntityId id, float view_radius);
+    bool contains(EntityId id) const { return indexes_.find(id) != indexes_.end(); }
+
+    // events of the entity as a watcher are passed to the handler during update()
+    bool set_event_handler(EntityId id, EventHandler handler);
+
+    // apply all changes since last update, then dispatch events to handlers
+    void update();
+
+    // events of the last update
+    const std::vector<AoiEvent> &get_events() const { return events_; }
+
+    // entities in the view of id, and entities who can see id
+    std::vector<EntityId> get_visible(EntityId id) const;
+    std::vector<EntityId> get_observers(EntityId id) const;
+
+    size_t size() const { return indexes_.size(); }
+
+  private:
+    struct Entry
+    {
+      EntityId id = kInvalidEntityId;
+      float x = 0.0f;
+      float z = 0.0f;
+      float view_radius = 0.0f;
+      int32_t cell_x = 0;
+      int32_t cell_z = 0;
+      // position in the arrays of its cell
+      uint32_t cell_slot = 0;
+      bool alive = false;
+      bool dirty = false;
+      bool moved = false;
+      // entries in view of this entry
+      std::unordered_set<uint32_t> visible;
+      // entries that can see this entry
+      std::unordered_set<uint32_t> observers;
+      EventHandler handler;
+    };
+
+    // entries of one cell, positions are stored apart so they can be loaded 4 at a time
+    struct Cell
+    {
+      std::vector<uint32_t> entries;
+      std::vector<float> xs;
+      std::vector<float> zs;
+    };
+
+    static uint64_t get_cell_key(int32_t cell_x, int32_t cell_z);
+    int32_t get_cell_coord(float value) const;
+
+    void insert_into_cell(uint32_t index);
+    void remove_from_cell(uint32_t index);
+    void mark_dirty(uint32_t index);
+
+    // collect entries within radius of (x, z) into candidates_
+    void query(float x, float z, float radius);
+
+    void apply_remove(uint32_t index);
+    // update who can see the entry, and what the entry can see
+    void apply_as_target(uint32_t index);
+    void apply_as_watcher(uint32_t index);
+
+    void push_event(AoiEventType type, uint32_t watcher, uint32_t target);
+
+  private:
+    float cell_size_ = AOI_DEFAULT_CELL_SIZE;
+    float default_view_radius_ = AOI_DEFAULT_VIEW_RADIUS;
+    // the largest view radius of all entries, bounds the search of observers
+    float max_view_radius_ = 0.0f;
+
+    // deque keeps entries in place when it grows, handlers may add entries while they are called
+    std::deque<Entry> entries_;
+    std::vector<uint32_t> free_indexes_;
+    std::unordered_map<EntityId, uint32_t> indexes_;
+    std::unordered_map<uint64_t, Cell> cells_;
+
+    // changes since last update
+    std::vector<uint32_t> dirty_indexes_;
+    std::vector<uint32_t> removed_indexes_;
+
+    // scratch buffers reused by every update
+    std::vector<uint32_t> candidates_;
+    std::vector<uint32_t> known_;
+    std::vector<AoiEvent> events_;
+  };
+}
@@ -3,7 +3,7 @@
 
 namespace multiplayer_server
 {
-  ClientEntity::ClientEntity(const std::string &id) : Entity(id)
+  ClientEntity::ClientEntity(EntityId id) : Entity(id)
   {
   }
 
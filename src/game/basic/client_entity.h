@@ -11,7 +11,7 @@ namespace multiplayer_server
   class ClientEntity : public Entity
   {
   public:
-    ClientEntity(const std::string &id);
+    ClientEntity(EntityId id);
     virtual ~ClientEntity();
 
     virtual void update(float dt) override;
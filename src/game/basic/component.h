@@ -2,6 +2,7 @@
 // Author: CasinoHe
 // Purpose: Base class for all components in the game
 #pragma once
+#include "game/property/property.h"
 #include <string>
 #include <memory>
 
@@ -13,7 +14,7 @@ namespace multiplayer_server
   class Component
   {
   public:
-    Component(std::shared_ptr<Entity> owner);
+    Component(Entity *owner);
     virtual ~Component();
 
   // non-copyable
@@ -35,14 +36,27 @@ namespace multiplayer_server
     // before destruct
     virtual void before_destruct() = 0;
 
-    // get owner, return a shared_ptr
-    virtual std::shared_ptr<Entity> get_owner();
-    virtual void set_owner(std::shared_ptr<Entity> owner) { owner_ = owner; }
-    virtual void reset_owner() { owner_.reset(); }
+    // properties are restored by Entity::load_state, rebuild state derived from them
+    virtual void on_state_loaded() {}
+
+    // get owner, nullptr after the component is removed from its owner
+    Entity *get_owner() const { return owner_; }
+    virtual void set_owner(Entity *owner) { owner_ = owner; properties_.set_owner(owner); }
+    virtual void reset_owner() { owner_ = nullptr; active_ = false; properties_.set_owner(nullptr); }
+
+    // the pool only updates active components, it follows the valid flag of the owner
+    bool is_active() const { return active_; }
+    void set_active(bool active) { active_ = active; }
+
+    // replicated fields of this component, declare Property members on it
+    PropertySet &get_properties() { return properties_; }
+    const PropertySet &get_properties() const { return properties_; }
 
   protected:
     std::string name_ = "";
-    // owner of this component, use weak_ptr to avoid circular reference
-    std::weak_ptr<Entity> owner_;
+    // owner of this component, the owner always outlives its components
+    Entity *owner_ = nullptr;
+    bool active_ = true;
+    PropertySet properties_;
   };
 }
\ No newline at end of file
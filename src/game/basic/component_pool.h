@@ -0,0 +1,200 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: per type contiguous storage of components
+#pragma once
+
+#include "game/basic/component_type.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <utility>
+
+// number of components in one chunk of a component pool
+#define COMPONENT_POOL_CHUNK_SIZE 256
+
+namespace multiplayer_server
+{
+  // index in a component pool plus the generation of the index when the handle was made
+  // the generation changes when the component is destroyed, so old handles get nullptr
+  struct ComponentHandle
+  {
+    uint32_t index = 0;
+    // 0 is never used by a live component
+    uint32_t generation = 0;
+
+    bool is_valid() const { return generation != 0; }
+    bool operator==(const ComponentHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ComponentHandle &other) const { return !(*this == other); }
+  };
+
+  // type erased interface of component pools, entities destroy components and storages update them through it
+  class ComponentPoolBase
+  {
+  public:
+    virtual ~ComponentPoolBase() = default;
+
+    // destroy the component of the handle
+    virtual void destroy(ComponentHandle handle) = 0;
+    // call update of all active components in storage order
+    virtual void update_all(float dt) = 0;
+    // number of alive components
+    virtual size_t size() const = 0;
+  };
+
+  // all components of type T live in chunks of contiguous storage
+  // components never move once created, so pointers stay valid until the component is destroyed
+  // pools belong to a ComponentStorage, the world and every room have their own
+  // create and destroy are thread safe, get and iteration run on the thread of the simulation owning the pool
+  template <typename T>
+  class ComponentPool final : public ComponentPoolBase
+  {
+  public:
+    ComponentPool() = default;
+    ~ComponentPool()
+    {
+      for (uint32_t index = 0; index < alive_.size(); index++)
+      {
+        if (alive_[index])
+        {
+          slot(index)->~T();
+        }
+      }
+    }
+
+    // non-copyable
+    ComponentPool(const ComponentPool &) = delete;
+    ComponentPool &operator=(const ComponentPool &) = delete;
+    ComponentPool(ComponentPool &&) = delete;
+    ComponentPool &operator=(ComponentPool &&) = delete;
+
+    // construct a component, return its handle and pointer
+    template <typename... Args>
+    std::pair<ComponentHandle, T *> create(Args &&...args)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      uint32_t index = 0;
+      if (!free_indexes_.empty())
+      {
+        index = free_indexes_.back();
+        free_indexes_.pop_back();
+      }
+      else
+      {
+        index = static_cast<uint32_t>(alive_.size());
+        if (index % COMPONENT_POOL_CHUNK_SIZE == 0)
+        {
+          chunks_.emplace_back(new Storage[COMPONENT_POOL_CHUNK_SIZE]);
+        }
+        alive_.push_back(0);
+        generations_.push_back(1);
+      }
+
+      T *component = nullptr;
+      try
+      {
+        component = new (storage(index)) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        free_indexes_.push_back(index);
+        throw;
+      }
+
+      alive_[index] = 1;
+      alive_count_++;
+      return {ComponentHandle{index, generations_[index]}, component};
+    }
+
+    virtual void destroy(ComponentHandle handle) override
+    {
+      uint32_t index = handle.index;
+      T *component = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index >= alive_.size() || !alive_[index] || generations_[index] != handle.generation)
+        {
+          return;
+        }
+        component = slot(index);
+        // handles of this component are invalid from now on, skip 0 when it wraps
+        generations_[index] = generations_[index] + 1 ? generations_[index] + 1 : 1;
+      }
+
+      // destruct outside the lock, destructor may create or destroy other components of this type
+      component->~T();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      alive_[index] = 0;
+      alive_count_--;
+      free_indexes_.push_back(index);
+    }
+
+    // get component by handle, nullptr if it's destroyed
+    T *get(ComponentHandle handle)
+    {
+      uint32_t index = handle.index;
+      if (index >= alive_.size() || !alive_[index] || generations_[index] != handle.generation)
+      {
+        return nullptr;
+      }
+      return slot(index);
+    }
+
+    // iterate all alive components in storage order
+    template <typename Function>
+    void for_each(Function &&function)
+    {
+      for (uint32_t index = 0; index < alive_.size(); index++)
+      {
+        if (alive_[index])
+        {
+          function(*slot(index));
+        }
+      }
+    }
+
+    virtual void update_all(float dt) override
+    {
+      for_each([dt](T &component)
+               {
+                 if (component.is_active())
+                 {
+                   component.update(dt);
+                 } });
+    }
+
+    virtual size_t size() const override { return alive_count_; }
+
+  private:
+    // raw storage of one component
+    struct Storage
+    {
+      alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    unsigned char *storage(uint32_t index)
+    {
+      return chunks_[index / COMPONENT_POOL_CHUNK_SIZE][index % COMPONENT_POOL_CHUNK_SIZE].data;
+    }
+
+    T *slot(uint32_t index)
+    {
+      return std::launder(reinterpret_cast<T *>(storage(index)));
+    }
+
+  private:
+    std::mutex mutex_;
+    // chunks never move, only the chunk list grows
+    std::vector<std::unique_ptr<Storage[]>> chunks_;
+    // alive flag of every index, dense so iteration skips dead slots quickly
+    std::vector<uint8_t> alive_;
+    // generation of every index, bumped when the component is destroyed
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> free_indexes_;
+    size_t alive_count_ = 0;
+  };
+}
@@ -0,0 +1,114 @@
+#include "component_registry.h"
+#include "game/basic/component.h"
+#include "log/logger.h"
+#include <iostream>
+
+namespace multiplayer_server
+{
+  // function local, components register from static initializers of other files
+  ComponentRegistry &ComponentRegistry::get_instance()
+  {
+    static ComponentRegistry instance;
+    return instance;
+  }
+
+  bool ComponentRegistry::add(const char *name, ComponentTypeId type, int32_t tick_order, ComponentInfo::Factory factory)
+  {
+    uint64_t name_hash = hash_component_name(name);
+    if (by_hash_.count(name_hash) || find_by_type(type) != kInvalidComponentIndex)
+    {
+      // loggers may not exist yet during static initialization
+      std::cerr << "ComponentRegistry: component " << name << " registered twice or its name hash collides" << std::endl;
+      return false;
+    }
+
+    ComponentIndex index = static_cast<ComponentIndex>(infos_.size());
+    ComponentInfo &info = infos_.emplace_back();
+    info.name = name;
+    info.name_hash = name_hash;
+    info.type = type;
+    info.tick_order = tick_order;
+    info.factory = factory;
+
+    by_hash_[name_hash] = index;
+    if (type >= by_type_.size())
+    {
+      by_type_.resize(type + 1, kInvalidComponentIndex);
+    }
+    by_type_[type] = index;
+    return true;
+  }
+
+  ComponentIndex ComponentRegistry::find(uint64_t name_hash) const
+  {
+    auto iter = by_hash_.find(name_hash);
+    return iter != by_hash_.end() ? iter->second : kInvalidComponentIndex;
+  }
+
+  ComponentIndex ComponentRegistry::find_by_type(ComponentTypeId type) const
+  {
+    return type < by_type_.size() ? by_type_[type] : kInvalidComponentIndex;
+  }
+
+  const ComponentInfo *ComponentRegistry::get_info(ComponentIndex index) const
+  {
+    return index < infos_.size() ? &infos_[index] : nullptr;
+  }
+
+  int32_t ComponentRegistry::get_tick_order(ComponentTypeId type) const
+  {
+    ComponentIndex index = find_by_type(type);
+    return index != kInvalidComponentIndex ? infos_[index].tick_order : COMPONENT_TICK_ORDER_DEFAULT;
+  }
+
+  std::vector<ComponentIndex> ComponentRegistry::resolve(const std::vector<std::string> &names, const std::string &context) const
+  {
+    std::vector<ComponentIndex> indexes;
+    indexes.reserve(names.size());
+    for (const auto &name : names)
+    {
+      ComponentIndex index = find(name);
+      if (index == kInvalidComponentIndex)
+      {
+        g_logger->warn("{}: unknown component {}", context, name);
+        continue;
+      }
+      indexes.push_back(index);
+    }
+    return indexes;
+  }
+
+  Component *ComponentRegistry::create(ComponentIndex index, Entity &entity)
+  {
+    if (index >= infos_.size())
+    {
+      return nullptr;
+    }
+
+    ComponentInfo &info = infos_[index];
+    Component *component = info.factory(entity);
+    if (component && !info.schema_ready.load(std::memory_order_acquire))
+    {
+      // every instance declares the same fields in the same order
+      std::call_once(info.schema_once, [&info, component]()
+                     {
+                       const PropertySet &properties = component->get_properties();
+                       for (uint32_t i = 0; i < properties.size(); i++)
+                       {
+                         info.schema.push_back(ReplicatedField{properties.get_name(i), properties.get_scope(i)});
+                       }
+                       info.schema_ready.store(true, std::memory_order_release); });
+    }
+    return component;
+  }
+
+  const std::vector<ReplicatedField> &ComponentRegistry::get_schema(ComponentIndex index) const
+  {
+    static const std::vector<ReplicatedField> empty;
+    if (index >= infos_.size() || !infos_[index].schema_ready.load(std::memory_order_acquire))
+    {
+      return empty;
+    }
+    return infos_[index].schema;
+  }
+}
@@ -0,0 +1,108 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: components register their factory and metadata by name hash, entities create them without string compares
+#pragma once
+
+#include "game/basic/component_type.h"
+#include "game/property/property.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// tick order of components registered without one, components update in ascending order
+#define COMPONENT_TICK_ORDER_DEFAULT 0
+
+// put in the .cpp of a component, the component registers itself before main
+// T must be constructible from the owner alone, the name is the class name used in config
+#define REGISTER_COMPONENT(T, tick_order)                                                                                     \
+  static ::multiplayer_server::Component *create_registered_##T(::multiplayer_server::Entity &entity)                          \
+  {                                                                                                                          \
+    return entity.add_component<T>();                                                                                        \
+  }                                                                                                                          \
+  [[maybe_unused]] static const bool registered_##T = ::multiplayer_server::ComponentRegistry::get_instance().add(             \
+      #T, ::multiplayer_server::get_component_type_id<T>(), tick_order, &create_registered_##T)
+
+namespace multiplayer_server
+{
+  class Entity;
+
+  // position of a component in the registry
+  using ComponentIndex = uint32_t;
+  constexpr ComponentIndex kInvalidComponentIndex = UINT32_MAX;
+
+  // fnv-1a, the hash is also written to saved entity state
+  constexpr uint64_t hash_component_name(std::string_view name)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : name)
+    {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  struct ReplicatedField
+  {
+    std::string name;
+    PropertyScope scope = PropertyScope::kServerOnly;
+  };
+
+  struct ComponentInfo
+  {
+    // add the component to the entity, return the existing one if the entity has it
+    using Factory = Component *(*)(Entity &entity);
+
+    std::string name;
+    uint64_t name_hash = 0;
+    ComponentTypeId type = 0;
+    int32_t tick_order = COMPONENT_TICK_ORDER_DEFAULT;
+    Factory factory = nullptr;
+
+    // property fields of the component in set order, taken from the first component created by the registry
+    std::vector<ReplicatedField> schema;
+    std::atomic<bool> schema_ready{false};
+    std::once_flag schema_once;
+  };
+
+  // filled during static initialization and read only afterwards, so lookups need no lock
+  class ComponentRegistry
+  {
+  public:
+    static ComponentRegistry &get_instance();
+
+    // return false if the name or the type is already registered
+    bool add(const char *name, ComponentTypeId type, int32_t tick_order, ComponentInfo::Factory factory);
+
+    ComponentIndex find(uint64_t name_hash) const;
+    ComponentIndex find(std::string_view name) const { return find(hash_component_name(name)); }
+    ComponentIndex find_by_type(ComponentTypeId type) const;
+    // nullptr if the index is invalid
+    const ComponentInfo *get_info(ComponentIndex index) const;
+    size_t size() const { return infos_.size(); }
+
+    // components without registry entry update at the default order
+    int32_t get_tick_order(ComponentTypeId type) const;
+
+    // resolve names to indexes once, unknown names are logged with the context and skipped
+    std::vector<ComponentIndex> resolve(const std::vector<std::string> &names, const std::string &context) const;
+
+    // add the component of the index to the entity, nullptr if the index is invalid
+    Component *create(ComponentIndex index, Entity &entity);
+
+    // empty until a component of the index was created
+    const std::vector<ReplicatedField> &get_schema(ComponentIndex index) const;
+
+  private:
+    // deque, infos never move so once_flag can live in them
+    std::deque<ComponentInfo> infos_;
+    std::unordered_map<uint64_t, ComponentIndex> by_hash_;
+    // component type id -> index
+    std::vector<ComponentIndex> by_type_;
+  };
+}
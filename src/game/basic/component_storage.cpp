@@ -0,0 +1,60 @@
+#include "component_storage.h"
+#include "component_registry.h"
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  ComponentStorage::ComponentStorage()
+  {
+    for (auto &pool : pools_)
+    {
+      pool.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // entities of the storage are destroyed before it, pools only destruct components left by them
+  ComponentStorage::~ComponentStorage()
+  {
+    for (auto &pool : pools_)
+    {
+      delete pool.load(std::memory_order_relaxed);
+    }
+  }
+
+  ComponentStorage &ComponentStorage::get_world()
+  {
+    static ComponentStorage *instance = new ComponentStorage();
+    return *instance;
+  }
+
+  void ComponentStorage::add_update_order(ComponentTypeId type, ComponentPoolBase *pool)
+  {
+    // pools of the same order keep the order they are created in
+    int32_t tick_order = ComponentRegistry::get_instance().get_tick_order(type);
+    auto position = std::find_if(update_order_.begin(), update_order_.end(), [tick_order](const std::pair<int32_t, ComponentPoolBase *> &item)
+                                 { return item.first > tick_order; });
+    update_order_.insert(position, {tick_order, pool});
+    update_order_changed_ = true;
+  }
+
+  void ComponentStorage::update_all(float dt)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (update_order_changed_)
+      {
+        update_order_changed_ = false;
+        updating_pools_.clear();
+        for (auto &item : update_order_)
+        {
+          updating_pools_.push_back(item.second);
+        }
+      }
+    }
+
+    for (ComponentPoolBase *pool : updating_pools_)
+    {
+      pool->update_all(dt);
+    }
+  }
+}
@@ -0,0 +1,79 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: component pools of one simulation, the world and every room have their own
+#pragma once
+
+#include "game/basic/component_pool.h"
+#include "game/basic/component_type.h"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// max number of component classes, type ids are dense so this is the number of registered components
+#define COMPONENT_STORAGE_MAX_TYPES 256
+
+namespace multiplayer_server
+{
+  // rooms tick on different workers at the same time, so they must not share pools with each other or the world
+  // pools are created on the first component of their type and live as long as the storage
+  // getting a pool is lock free once it exists, iterating a pool runs on the thread of the simulation
+  class ComponentStorage
+  {
+  public:
+    ComponentStorage();
+    ~ComponentStorage();
+
+    // non-copyable
+    ComponentStorage(const ComponentStorage &) = delete;
+    ComponentStorage &operator=(const ComponentStorage &) = delete;
+    ComponentStorage(ComponentStorage &&) = delete;
+    ComponentStorage &operator=(ComponentStorage &&) = delete;
+
+    // pools of the world, never destructed, entities destroyed during static destruction can still release components
+    static ComponentStorage &get_world();
+
+    // update components of all pools, pools go in ascending tick order of their registry entry
+    // components of one type are updated together in storage order, called by the thread of the simulation
+    void update_all(float dt);
+
+    template <typename T>
+    ComponentPool<T> &get_pool()
+    {
+      ComponentTypeId type = get_component_type_id<T>();
+      if (type >= COMPONENT_STORAGE_MAX_TYPES)
+      {
+        std::abort();
+      }
+
+      ComponentPoolBase *pool = pools_[type].load(std::memory_order_acquire);
+      if (!pool)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool = pools_[type].load(std::memory_order_relaxed);
+        if (!pool)
+        {
+          pool = new ComponentPool<T>();
+          pools_[type].store(pool, std::memory_order_release);
+          add_update_order(type, pool);
+        }
+      }
+      return *static_cast<ComponentPool<T> *>(pool);
+    }
+
+  private:
+    // mutex_ must be locked
+    void add_update_order(ComponentTypeId type, ComponentPoolBase *pool);
+
+  private:
+    std::mutex mutex_;
+    std::array<std::atomic<ComponentPoolBase *>, COMPONENT_STORAGE_MAX_TYPES> pools_;
+    // pools in update order, guarded by mutex_, copied by update_all when a pool is added
+    std::vector<std::pair<int32_t, ComponentPoolBase *>> update_order_;
+    bool update_order_changed_ = false;
+    std::vector<ComponentPoolBase *> updating_pools_;
+  };
+}
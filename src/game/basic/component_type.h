@@ -0,0 +1,35 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: dense integer type id of every component class
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+
+namespace multiplayer_server
+{
+  class Component;
+
+  using ComponentTypeId = uint32_t;
+
+  // every component class gets a small dense id, so entities can index components by type without strings
+  // the id is bound to the type through a static variable, it's fixed after the first use and costs one load
+  class ComponentTypeCounter
+  {
+  public:
+    static ComponentTypeId next()
+    {
+      static std::atomic<ComponentTypeId> counter{0};
+      return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  template <typename T>
+  ComponentTypeId get_component_type_id()
+  {
+    static_assert(std::is_base_of<Component, T>::value, "T must be derived from Component");
+    static const ComponentTypeId id = ComponentTypeCounter::next();
+    return id;
+  }
+}
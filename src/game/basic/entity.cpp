@@ -1,15 +1,16 @@
 #include "entity.h"
 #include "component.h"
-#include "game/component/network_component.h"
+#include "game/property/property_replicator.h"
+#include <algorithm>
 
 namespace multiplayer_server
 {
-  Entity::Entity(const std::string& id)
+  Entity::Entity(EntityId id)
     : id_(id)
   {
-    components_.clear();
-    // create logger
-    logger_ = g_logger_manager.create_logger("Entity", LoggerLevel::Debug, "log/entity.log");
+    properties_.set_owner(this);
+    // all entities share one logger
+    logger_ = get_entity_logger();
     logger_->debug("Entity {} constructed", id_);
   }
 
@@ -21,22 +22,47 @@ namespace multiplayer_server
     before_destruct();
   }
 
+  void Entity::before_destruct()
+  {
+    timer_wheel_->cancel_timers(timers_);
+    delete_all_components();
+  }
+
+  TimerHandle Entity::add_timer(float delay, TimerWheel::Callback callback, float interval)
+  {
+    return timer_wheel_->add_timer(delay, std::move(callback), interval, &timers_);
+  }
+
+  bool Entity::cancel_timer(TimerHandle handle)
+  {
+    return timer_wheel_->cancel_timer(handle);
+  }
+
   // delete all components
   void Entity::delete_all_components()
   {
-    for (auto it = components_.begin(); it != components_.end(); ++it)
+    // move out first, before_destruct may call back into this entity
+    std::vector<ComponentSlot> components;
+    components.swap(components_);
+    component_table_.clear();
+    for (auto it = components.rbegin(); it != components.rend(); ++it)
     {
-      it->second->before_destruct();
+      destroy_component(*it);
     }
-    components_.clear();
   }
 
-  // logic update
-  void Entity::update(float dt)
+  // logic update, components are updated by ComponentStorage::update_all in storage order
+  void Entity::update([[maybe_unused]] float dt)
   {
-    for (auto it = components_.begin(); it != components_.end(); ++it)
+  }
+
+  void Entity::set_validate(bool validate)
+  {
+    validate_ = validate;
+    timers_.paused = !validate;
+    for (auto &slot : components_)
     {
-      it->second->update(dt);
+      slot.component->set_active(validate);
     }
   }
 
@@ -45,33 +71,210 @@ namespace multiplayer_server
   {
     for (auto it = components_.begin(); it != components_.end(); ++it)
     {
-      it->second->render();
+      it->component->render();
     }
   }
 
   // init component from config using std::vector<std::string> as name list
   void Entity::init_components(const std::vector<std::string>& names)
   {
-    for (auto it = names.begin(); it != names.end(); ++it)
+    add_components(ComponentRegistry::get_instance().resolve(names, "Entity " + std::to_string(id_)));
+  }
+
+  void Entity::add_components(const std::vector<ComponentIndex> &indexes)
+  {
+    auto &registry = ComponentRegistry::get_instance();
+    components_.reserve(components_.size() + indexes.size());
+    for (ComponentIndex index : indexes)
+    {
+      registry.create(index, *this);
+    }
+  }
+
+  // release owner and return the component to its pool
+  void Entity::destroy_component(const ComponentSlot &slot)
+  {
+    slot.component->before_destruct();
+    slot.component->reset_owner();
+    slot.pool->destroy(slot.handle);
+  }
+
+  // logger shared by all entities, created once instead of looked up per entity
+  const std::shared_ptr<LoggerImp> &Entity::get_entity_logger()
+  {
+    static std::shared_ptr<LoggerImp> logger = g_logger_manager.create_logger("Entity", LoggerLevel::Debug, "log/entity.log");
+    return logger;
+  }
+
+  void Entity::on_message(uint16_t message_id, [[maybe_unused]] const char *data, size_t size)
+  {
+    logger_->debug("Entity {} ignore message {}, size {}", id_, message_id, size);
+  }
+
+  void Entity::on_property_dirty()
+  {
+    // entities not created by the factory have no handle and are never replicated
+    if (property_dirty_ || !handle_.is_valid())
+    {
+      return;
+    }
+    property_dirty_ = true;
+    PropertyReplicator::get_instance().add_dirty_entity(handle_);
+  }
+
+  void Entity::collect_property_changes()
+  {
+    property_dirty_ = false;
+    properties_.collect_changes();
+    for (auto &slot : components_)
+    {
+      slot.component->get_properties().collect_changes();
+    }
+  }
+
+  bool Entity::serialize_properties(PropertyWriter &writer, bool to_owner, bool full) const
+  {
+    size_t start = writer.size();
+    writer.write(id_);
+    size_t count_offset = writer.size();
+    writer.write(static_cast<uint8_t>(0));
+
+    uint8_t count = 0;
+    auto write_set = [&](const PropertySet &set, size_t set_index)
+    {
+      uint64_t mask = (full ? ~0ULL : set.get_changed_mask()) & set.get_visible_mask(to_owner);
+      if (mask == 0)
+      {
+        return;
+      }
+      writer.write(static_cast<uint8_t>(set_index));
+      set.serialize(writer, mask);
+      count++;
+    };
+
+    write_set(properties_, 0);
+    // set index is one byte, components after the 255th are not replicated
+    for (size_t i = 0; i < components_.size() && i < 255; i++)
+    {
+      write_set(components_[i].component->get_properties(), i + 1);
+    }
+
+    if (count == 0)
+    {
+      writer.truncate(start);
+      return false;
+    }
+    writer.patch(count_offset, count);
+    return true;
+  }
+
+  void Entity::save_state(PropertyWriter &writer) const
+  {
+    auto &registry = ComponentRegistry::get_instance();
+    size_t count = std::min<size_t>(components_.size(), 255);
+    writer.write(static_cast<uint8_t>(count));
+    for (size_t i = 0; i < count; i++)
     {
-      std::string name = *it;
-      if (name == "NetworkComponent")
+      const ComponentInfo *info = registry.get_info(registry.find_by_type(components_[i].type));
+      writer.write(info ? info->name_hash : hash_component_name(components_[i].component->get_name()));
+    }
+
+    // every set is prefixed by its size, so sets of unknown components can be skipped
+    auto write_set = [&writer](const PropertySet &set, size_t set_index)
+    {
+      writer.write(static_cast<uint8_t>(set_index));
+      size_t size_offset = writer.size();
+      writer.write(static_cast<uint32_t>(0));
+      set.serialize(writer, set.get_all_mask());
+      uint32_t size = static_cast<uint32_t>(writer.size() - size_offset - sizeof(uint32_t));
+      for (size_t i = 0; i < sizeof(uint32_t); i++)
       {
-        add_component<NetworkComponent>();
+        writer.patch(size_offset + i, static_cast<uint8_t>((size >> (i * 8)) & 0xff));
       }
+    };
+
+    writer.write(static_cast<uint8_t>(count + 1));
+    write_set(properties_, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+      write_set(components_[i].component->get_properties(), i + 1);
     }
   }
 
-  // update owner of component
-  void Entity::update_component_owner(std::shared_ptr<Component> component, std::shared_ptr<Entity> owner)
+  bool Entity::load_state(PropertyReader &reader)
   {
-    if (!owner)
+    uint8_t component_count = 0;
+    if (!reader.read(component_count))
     {
-      component->reset_owner();
+      return false;
     }
-    else
+
+    // unknown hashes keep their place as invalid indexes, so set indexes still match
+    auto &registry = ComponentRegistry::get_instance();
+    std::vector<ComponentIndex> indexes(component_count, kInvalidComponentIndex);
+    for (auto &index : indexes)
+    {
+      uint64_t name_hash = 0;
+      if (!reader.read(name_hash))
+      {
+        return false;
+      }
+      index = registry.find(name_hash);
+    }
+    for (ComponentIndex index : indexes)
+    {
+      registry.create(index, *this);
+    }
+
+    uint8_t set_count = 0;
+    if (!reader.read(set_count))
+    {
+      return false;
+    }
+
+    for (uint8_t i = 0; i < set_count; i++)
+    {
+      uint8_t set_index = 0;
+      uint32_t size = 0;
+      if (!reader.read(set_index) || !reader.read(size) || size > reader.remaining())
+      {
+        return false;
+      }
+
+      PropertySet *set = nullptr;
+      if (set_index == 0)
+      {
+        set = &properties_;
+      }
+      else if (set_index <= indexes.size())
+      {
+        const ComponentInfo *info = registry.get_info(indexes[set_index - 1]);
+        if (info && info->type < component_table_.size() && component_table_[info->type])
+        {
+          set = &component_table_[info->type]->get_properties();
+        }
+      }
+
+      if (!set)
+      {
+        logger_->warn("Entity {} skip state of unknown property set {}", id_, set_index);
+        reader.skip(size);
+        continue;
+      }
+
+      PropertyReader set_reader(reader.current(), size);
+      if (!set->deserialize(set_reader))
+      {
+        logger_->error("Entity {} load property set {} failed", id_, set_index);
+        return false;
+      }
+      reader.skip(size);
+    }
+
+    for (auto &slot : components_)
     {
-      component->set_owner(owner);
+      slot.component->on_state_loaded();
     }
+    return true;
   }
-}
\ No newline at end of file
+}
@@ -4,6 +4,14 @@
 
 #pragma once
 #include "log/logger.h"
+#include "game/basic/component_storage.h"
+#include "game/basic/component_registry.h"
+#include "game/basic/entity_id.h"
+#include "game/basic/entity_handle.h"
+#include "game/basic/mailbox.h"
+#include "game/property/property.h"
+#include "game/timer/timer_wheel.h"
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <map>
@@ -20,14 +28,14 @@ namespace multiplayer_server
   public:
     std::string ip_ = "";
     int port_ = 0;
-    std::string entity_id_ = "";
+    EntityId entity_id_ = kInvalidEntityId;
 
     EntityProxy(std::shared_ptr<LoggerImp> logger = g_logger) : logger_(logger) {}
 
     // get the string of the position
     std::string get_pos() const
     {
-      return ip_ + "_" + std::to_string(port_) + "_" + entity_id_;
+      return ip_ + "_" + std::to_string(port_) + "_" + std::to_string(entity_id_);
     }
 
     // get ip
@@ -36,6 +44,9 @@ namespace multiplayer_server
     // get port
     int get_port() const { return port_; }
 
+    // get entity id
+    EntityId get_entity_id() const { return entity_id_; }
+
     // parse the string to ServerEntityPos
     [[nodiscard]] bool parse_pos(const std::string &pos)
     {
@@ -45,7 +56,7 @@ namespace multiplayer_server
         auto pos2 = pos.rfind("_");
         ip_ = pos.substr(0, pos1);
         port_ = std::stoi(pos.substr(pos1 + 1, pos2 - pos1 - 1));
-        entity_id_ = pos.substr(pos2 + 1);
+        entity_id_ = std::stoull(pos.substr(pos2 + 1));
         validate = true;
         return true;
       }
@@ -56,7 +67,7 @@ namespace multiplayer_server
       }
     }
 
-    void set_proxy(const std::string &id, const std::string &ip, int port)
+    void set_proxy(EntityId id, const std::string &ip, int port)
     {
       this->entity_id_ = id;
       this->ip_ = ip;
@@ -74,11 +85,11 @@ namespace multiplayer_server
 
   // abstract base class for all entities
   // define the base interface
-  // we need to pass this pointer to component to get the owner, so Entity should inherit from std::enable_shared_from_this
-  class Entity : public std::enable_shared_from_this<Entity>
+  // components keep a raw pointer of their owner, other systems keep an EntityHandle instead of a shared_ptr
+  class Entity
   {
   public:
-    Entity(const std::string &id);
+    Entity(EntityId id);
     virtual ~Entity();
 
   // non-copyable
@@ -90,6 +101,7 @@ namespace multiplayer_server
 
   // all interface
   public:
+    // logic of the entity itself, components are updated before it by the pools of the storage
     virtual void update(float dt);
     virtual void render();
 
@@ -97,99 +109,93 @@ namespace multiplayer_server
     virtual void set_name(const std::string& name) { name_ = name; }
     virtual const std::string &get_name() { return name_; }
     // get id
-    virtual const std::string &get_id() { return id_; }
+    virtual EntityId get_id() const { return id_; }
+    // get handle, resolve it by EntityFactory::get_entity
+    EntityHandle get_handle() const { return handle_; }
 
-    // call before destruct
-    virtual void before_destruct() { delete_all_components(); }
+    // call before destruct, cancel timers and delete components
+    virtual void before_destruct();
 
     // init component from config using std::vector<std::string> as name list
     virtual void init_components(const std::vector<std::string> &names);
+    // add registered components by index, resolve names by ComponentRegistry::resolve once and reuse the indexes
+    void add_components(const std::vector<ComponentIndex> &indexes);
 
-    // get component by type 
+    // get component by type, O(1) lookup by the dense type id
     template<typename T>
-    std::shared_ptr<T> get_component()
+    T *get_component()
     {
-      std::string type = typeid(T).name();
-      auto it = components_.find(type);
-      if (it != components_.end())
+      ComponentTypeId type = get_component_type_id<T>();
+      if (type < component_table_.size())
       {
-        return std::static_pointer_cast<T>(it->second);
+        return static_cast<T *>(component_table_[type]);
       }
       return nullptr;
     }
 
-    // add component
-    template<typename T>
-    std::shared_ptr<T> add_component()
+    // add component, the component is constructed in the pool of its type
+    template<typename T, typename... Args>
+    T *add_component(Args &&...args)
     {
       // check the type of T, must be derived from Component
       static_assert(std::is_base_of<Component, T>::value, "T must be derived from Component");
 
-      std::string type = typeid(T).name();
-      auto it = components_.find(type);
-      if (it != components_.end())
+      ComponentTypeId type = get_component_type_id<T>();
+      if (T *exists = get_component<T>())
+      {
+        return exists;
+      }
+
+      auto &pool = component_storage_->get_pool<T>();
+      auto [handle, component] = pool.create(this, std::forward<Args>(args)...);
+      if (type >= component_table_.size())
       {
-        return std::static_pointer_cast<T>(it->second);
+        component_table_.resize(type + 1, nullptr);
       }
-      std::shared_ptr<T> component = std::make_shared<T>(shared_from_this());
-      components_.emplace(type, component);
+      component_table_[type] = component;
+      component->set_active(validate_);
+      // keep update order, components of the same order stay in add order
+      int32_t tick_order = ComponentRegistry::get_instance().get_tick_order(type);
+      auto position = std::find_if(components_.begin(), components_.end(), [tick_order](const ComponentSlot &slot)
+                                   { return slot.tick_order > tick_order; });
+      components_.insert(position, ComponentSlot{type, tick_order, handle, component, &pool});
       // debug log
-      logger_->debug("Entity {} add component {}", id_, type);
+      logger_->debug("Entity {} add component {}", id_, typeid(T).name());
       return component;
     }
 
-    // attach component
+    // get handle of component, resolve it by ComponentPool<T>::get of the storage of the entity
     template<typename T>
-    bool attach_component(std::shared_ptr<T> component)
+    ComponentHandle get_component_handle()
     {
-      // check the type of T, must be derived from Component
-      static_assert(std::is_base_of<Component, T>::value, "T must be derived from Component");
-
-      std::string type = typeid(T).name();
-      auto it = components_.find(type);
-      if (it != components_.end())
+      ComponentTypeId type = get_component_type_id<T>();
+      for (const auto &slot : components_)
       {
-        return false;
+        if (slot.type == type)
+        {
+          return slot.handle;
+        }
       }
-      update_component_owner(component, shared_from_this());
-      components_.emplace(type, component);
-      // log
-      logger_->debug("Entity {} attach component {}", id_, type);
-      return true;
+      return ComponentHandle();
     }
-    
+
     // delete component
     template<typename T>
     [[nodiscard]] bool delete_component()
     {
-      std::string type = typeid(T).name();
-      auto it = components_.find(type);
-      if (it != components_.end())
+      ComponentTypeId type = get_component_type_id<T>();
+      for (auto it = components_.begin(); it != components_.end(); ++it)
       {
-        components_.erase(it);
-        // debug log
-        logger_->debug("Entity {} delete component {}", id_, type);
-        return true;
-      }
-      // release owner weak_ptr to avoid subsequent use
-      update_component_owner(it->second, nullptr);
-
-      return false;
-    }
-
-    // delete component by exists component
-    template<typename T>
-    [[nodiscard]] bool delete_component(std::shared_ptr<T> component)
-    {
-      std::string type = typeid(T).name();
-      auto it = components_.find(type);
-      if (it != components_.end() && it->second == component)
-      {
-        components_.erase(it);
-        // debug log
-        logger_->debug("Entity {} delete component {}", id_, type);
-        update_component_owner(component, nullptr);
-        return true;
+        if (it->type == type)
+        {
+          ComponentSlot slot = *it;
+          components_.erase(it);
+          component_table_[type] = nullptr;
+          destroy_component(slot);
+          // debug log
+          logger_->debug("Entity {} delete component {}", id_, typeid(T).name());
+          return true;
+        }
       }
       return false;
     }
@@ -197,21 +203,89 @@ namespace multiplayer_server
     // delete all components
     void delete_all_components();
 
-    // set validate value
-    void set_validate(bool validate) { validate_ = validate; }
+    // set validate value, timers and components of an invalid entity don't run
+    void set_validate(bool validate);
+    bool is_valid() const { return validate_; }
+
+    // replicated fields of the entity itself, declare Property members on it
+    PropertySet &get_properties() { return properties_; }
+    const PropertySet &get_properties() const { return properties_; }
+
+    // called by property sets of the entity and its components on the first dirty field of a tick
+    void on_property_dirty();
+    // move dirty bits of the entity and its components into change masks, called by the replicator once per tick
+    void collect_property_changes();
+    // write entity id and the fields the owner or observers can see, changed fields only unless full
+    // set 0 is the entity itself, set n is the nth component in update order
+    // return false and write nothing if no field is written
+    bool serialize_properties(PropertyWriter &writer, bool to_owner, bool full) const;
+
+    // fire callback on the tick thread after delay seconds, then every interval seconds if interval > 0
+    // timers are cancelled when the entity is destroyed, so callbacks can capture this
+    TimerHandle add_timer(float delay, TimerWheel::Callback callback, float interval = 0.0f);
+    bool cancel_timer(TimerHandle handle);
+    size_t get_timer_count() const { return timers_.count; }
+    // timers go to the world wheel unless the entity lives in a room, set it before adding any timer
+    void set_timer_wheel(TimerWheel &timer_wheel) { timer_wheel_ = &timer_wheel; }
+    // components go to the world pools unless the entity lives in a room, set it before adding any component
+    void set_component_storage(ComponentStorage &component_storage) { component_storage_ = &component_storage; }
+    ComponentStorage &get_component_storage() const { return *component_storage_; }
+
+    // messages sent to the entity from any thread, use EntityFactory::post_message to send one
+    Mailbox &get_mailbox() { return mailbox_; }
+    // handle a message of the mailbox, called by the tick thread
+    virtual void on_message(uint16_t message_id, const char *data, size_t size);
+
+    // write component name hashes and all fields including server only ones, used to move the entity to another process
+    void save_state(PropertyWriter &writer) const;
+    // create components by name hash and read fields written by save_state
+    // components unknown in this process are skipped, return false if the data is broken
+    bool load_state(PropertyReader &reader);
+
+  protected:
+    // logger shared by all entities
+    static const std::shared_ptr<LoggerImp> &get_entity_logger();
 
   private:
-    // to avoid include component.h and add friend class Component
-    void update_component_owner(std::shared_ptr<Component> component, std::shared_ptr<Entity> owner);
+    friend class EntityFactory;
+    void set_handle(EntityHandle handle) { handle_ = handle; }
+
+    // a component owned by this entity, the component itself lives in the pool of its type
+    struct ComponentSlot
+    {
+      ComponentTypeId type;
+      int32_t tick_order;
+      ComponentHandle handle;
+      Component *component;
+      ComponentPoolBase *pool;
+    };
+
+    // release owner and return the component to its pool
+    void destroy_component(const ComponentSlot &slot);
 
   protected:
     // entity name
     std::string name_ = "";
     // entity unique id
-    std::string id_ = "";
+    EntityId id_ = kInvalidEntityId;
+    // handle in the entity factory
+    EntityHandle handle_;
+
+    // entity components in ascending tick order of their registry entry
+    std::vector<ComponentSlot> components_;
+    // component type id -> component, nullptr if the entity doesn't have it
+    std::vector<Component *> component_table_;
+
+    PropertySet properties_;
+    // already in the dirty list of the replicator
+    bool property_dirty_ = false;
 
-    // entity components
-    std::map<std::string, std::shared_ptr<Component>> components_;
+    Mailbox mailbox_;
+    // timers in the wheel of the thread running the entity
+    TimerWheel *timer_wheel_ = &TimerWheel::get_instance();
+    TimerOwner timers_;
+    // pools of the simulation running the entity
+    ComponentStorage *component_storage_ = &ComponentStorage::get_world();
     
     // logger object
     std::shared_ptr<LoggerImp> logger_ = nullptr;
@@ -0,0 +1,71 @@
+#include "entity_blueprint.h"
+#include "game/basic/entity_factory.h"
+#include "log/logger.h"
+
+namespace multiplayer_server
+{
+  static std::shared_ptr<ServerEntity> create_server_entity(EntityFactory &factory, ServerEntity::ServerEntityType type, const std::string &ip, int port)
+  {
+    return factory.create_entity<ServerEntity>(type, ip, port);
+  }
+
+  // entity classes a blueprint can create
+  static EntityBlueprint::Creator find_creator(const std::string &class_name)
+  {
+    if (class_name == "ServerEntity")
+    {
+      return &create_server_entity;
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<const EntityBlueprint> EntityBlueprint::compile(const std::string &name, const std::string &class_name, const std::string &type, const std::vector<std::string> &components)
+  {
+    Creator creator = find_creator(class_name);
+    if (!creator)
+    {
+      g_logger->error("EntityBlueprint {}: unknown entity class {}", name, class_name);
+      return nullptr;
+    }
+
+    auto blueprint = std::make_shared<EntityBlueprint>();
+    blueprint->name_ = name;
+    blueprint->creator_ = creator;
+    blueprint->type_ = ServerEntity::get_type_from_string(type);
+    blueprint->component_indexes_ = ComponentRegistry::get_instance().resolve(components, "EntityBlueprint " + name);
+    return blueprint;
+  }
+
+  std::shared_ptr<ServerEntity> EntityBlueprint::spawn(EntityFactory &factory, const std::string &ip, int port) const
+  {
+    auto entity = creator_(factory, type_, ip, port);
+    if (!entity)
+    {
+      return nullptr;
+    }
+
+    entity->add_components(component_indexes_);
+    return entity;
+  }
+
+  EntityBlueprintCache &EntityBlueprintCache::get_instance()
+  {
+    static EntityBlueprintCache instance;
+    return instance;
+  }
+
+  void EntityBlueprintCache::add(std::shared_ptr<const EntityBlueprint> blueprint)
+  {
+    if (!blueprint)
+    {
+      return;
+    }
+    blueprints_[blueprint->get_name()] = std::move(blueprint);
+  }
+
+  std::shared_ptr<const EntityBlueprint> EntityBlueprintCache::find(const std::string &name) const
+  {
+    auto iter = blueprints_.find(name);
+    return iter != blueprints_.end() ? iter->second : nullptr;
+  }
+}
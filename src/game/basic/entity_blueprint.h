@@ -0,0 +1,59 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: entity blueprints compiled once from config, spawning an entity doesn't touch any string
+#pragma once
+
+#include "game/basic/server_entity.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// blueprint of entities created for new clients
+#define LOGIN_BLUEPRINT_NAME "login"
+
+namespace multiplayer_server
+{
+  class EntityFactory;
+
+  // class, server entity type and component list resolved from their names
+  // spawn() is one pooled allocation for the entity and its control block, components come from their pools
+  class EntityBlueprint
+  {
+  public:
+    using Creator = std::shared_ptr<ServerEntity> (*)(EntityFactory &factory, ServerEntity::ServerEntityType type, const std::string &ip, int port);
+
+  public:
+    // nullptr if the class is unknown, unknown components are skipped
+    static std::shared_ptr<const EntityBlueprint> compile(const std::string &name, const std::string &class_name, const std::string &type, const std::vector<std::string> &components);
+
+    // create an entity with all components of the blueprint
+    std::shared_ptr<ServerEntity> spawn(EntityFactory &factory, const std::string &ip, int port) const;
+
+    const std::string &get_name() const { return name_; }
+    ServerEntity::ServerEntityType get_type() const { return type_; }
+    size_t get_component_count() const { return component_indexes_.size(); }
+
+  private:
+    std::string name_;
+    Creator creator_ = nullptr;
+    ServerEntity::ServerEntityType type_ = ServerEntity::ServerEntityType::kServiceEntity;
+    // indexes in the component registry
+    std::vector<ComponentIndex> component_indexes_;
+  };
+
+  // blueprints by name, filled before the world tick starts and read only afterwards
+  class EntityBlueprintCache
+  {
+  public:
+    static EntityBlueprintCache &get_instance();
+
+    // replace the blueprint of the same name
+    void add(std::shared_ptr<const EntityBlueprint> blueprint);
+    // nullptr if not found
+    std::shared_ptr<const EntityBlueprint> find(const std::string &name) const;
+
+  private:
+    std::unordered_map<std::string, std::shared_ptr<const EntityBlueprint>> blueprints_;
+  };
+}
@@ -1,17 +1,20 @@
 #include "entity_factory.h"
 #include "entity.h"
-#include "uuid.h"
+#include <algorithm>
+#include <iterator>
 
 namespace multiplayer_server
 {
   EntityFactory::EntityFactory()
   {
-    entities_.clear();
-    uuid_ = std::make_shared<UUID>();
   }
 
   EntityFactory::~EntityFactory()
   {
+    while (MpscNode *node = ready_entities_.pop())
+    {
+      delete static_cast<ReadyEntity *>(node);
+    }
   }
 
   // get the singleton instance
@@ -22,16 +25,39 @@ namespace multiplayer_server
   }
 
   // generate new unique id
-  std::string EntityFactory::generate_id()
+  EntityId EntityFactory::generate_id()
   {
-    return uuid_->get();
+    return EntityIdGenerator::generate();
+  }
+
+  // register entity into its shard
+  bool EntityFactory::register_entity(EntityId id, std::shared_ptr<Entity> entity)
+  {
+    EntityHandle handle = handles_.allocate(entity.get());
+    if (!handle.is_valid())
+    {
+      return false;
+    }
+    entity->set_handle(handle);
+
+    auto &shard = get_shard(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (!shard.entities.emplace(id, std::move(entity)).second)
+    {
+      handles_.invalidate(handle);
+      handles_.release(handle);
+      return false;
+    }
+    return true;
   }
 
   // get entity by id
-  std::shared_ptr<Entity> EntityFactory::get_entity(const std::string& id)
+  std::shared_ptr<Entity> EntityFactory::get_entity(EntityId id)
   {
-    auto iter = entities_.find(id);
-    if (iter != entities_.end())
+    auto &shard = get_shard(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto iter = shard.entities.find(id);
+    if (iter != shard.entities.end())
     {
       return iter->second;
     }
@@ -39,37 +65,132 @@ namespace multiplayer_server
   }
 
   // destroy entity by id
-  void EntityFactory::destroy_entity(const std::string& id)
+  void EntityFactory::destroy_entity(EntityId id)
   {
-    auto iter = entities_.find(id);
-    if (iter != entities_.end())
+    auto &shard = get_shard(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto iter = shard.entities.find(id);
+    if (iter == shard.entities.end())
     {
-      entities_.erase(iter);
+      return;
     }
 
-    // we need to check the reference count of the entity
-    // if the reference count is 0, we can delete the entity
-    // if the reference count is not 0, we can't delete the entity
-    // because there are some other shared_ptr point to the entity
-    // so we need to set the entity to be invalid
-    if (iter->second.use_count() == 1)
+    // stop updating it and invalidate its handles now, destruct it at the tick boundary
+    // still under the shard lock, so a flush can't release the handle before it's invalidated
+    iter->second->set_validate(false);
+    handles_.invalidate(iter->second->get_handle());
+    shard.destroyed.emplace_back(std::move(iter->second));
+    shard.entities.erase(iter);
+  }
+
+  // destruct entities destroyed in this tick
+  void EntityFactory::flush_destroyed_entities()
+  {
+    for (auto &shard : shards_)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      std::move(shard.destroyed.begin(), shard.destroyed.end(), std::back_inserter(flushing_entities_));
+      shard.destroyed.clear();
+    }
+
+    for (auto &entity : flushing_entities_)
     {
-      // use count is 1, means only iter->second owns the entity 
-      // so we can delete the entity
-      iter->second.reset();
+      // components are released now even if someone still holds the entity
+      entity->before_destruct();
+      handles_.release(entity->get_handle());
     }
-    else if (iter->second.use_count() > 1)
+    // entities destroyed by before_destruct wait for the next boundary
+    flushing_entities_.clear();
+  }
+
+  bool EntityFactory::post_message(EntityId id, uint16_t message_id, EntityId sender, const char *data, size_t size)
+  {
+    auto message = std::make_unique<EntityMessage>(message_id, sender, data, size);
+    EntityHandle handle;
     {
-      // use count is greater than 1, means there are some other shared_ptr point to the entity
-      // so we can't release the shared_ptr, or we cannot obtain the entity
-      // we need to set the entity to be invalid
-      iter->second->set_validate(false);
+      // the entity can't be released while it's in the shard, push under the read lock instead of holding a reference
+      auto &shard = get_shard(id);
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto iter = shard.entities.find(id);
+      if (iter == shard.entities.end())
+      {
+        return false;
+      }
+
+      if (!iter->second->get_mailbox().push(std::move(message)))
+      {
+        return true;
+      }
+      handle = iter->second->get_handle();
     }
-    else
+
+    ReadyEntity *ready = new ReadyEntity();
+    ready->handle = handle;
+    ready_entities_.push(ready);
+    return true;
+  }
+
+  void EntityFactory::dispatch_messages(size_t batch_count)
+  {
+    // take the entities scheduled so far, entities scheduled while dispatching wait for the next call
+    while (MpscNode *node = ready_entities_.pop())
+    {
+      dispatching_entities_.push_back(static_cast<ReadyEntity *>(node));
+    }
+
+    for (ReadyEntity *ready : dispatching_entities_)
+    {
+      // destroyed entities drop their messages, the mailbox frees them when the entity is released
+      Entity *entity = handles_.resolve(ready->handle);
+      if (!entity || !entity->is_valid())
+      {
+        delete ready;
+        continue;
+      }
+
+      bool left = entity->get_mailbox().drain(batch_count, [entity](const EntityMessage &message)
+                                              { entity->on_message(message.message_id, message.data.data(), message.data.size()); });
+
+      if (left)
+      {
+        // still scheduled, handle the rest in the next call
+        ready_entities_.push(ready);
+      }
+      else
+      {
+        delete ready;
+      }
+    }
+    dispatching_entities_.clear();
+  }
+
+  void EntityFactory::update_entities(float dt)
+  {
+    // components of all world entities first, one pool after another
+    ComponentStorage::get_world().update_all(dt);
+
+    // take a snapshot of raw pointers from the handle table, entities may be created or destroyed during update
+    handles_.collect(update_entities_);
+
+    for (Entity *entity : update_entities_)
+    {
+      if (entity->is_valid())
+      {
+        entity->update(dt);
+      }
+    }
+    update_entities_.clear();
+  }
+
+  // number of registered entities
+  size_t EntityFactory::get_entity_count() const
+  {
+    size_t count = 0;
+    for (auto &shard : shards_)
     {
-      // use count is 0, means the entity is invalid
-      // we don't need to do anything
-      // TODO: maybe there is an error
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      count += shard.entities.size();
     }
+    return count;
   }
-}
\ No newline at end of file
+}
@@ -4,17 +4,29 @@
 
 #pragma once
 
+#include "game/basic/entity_id.h"
+#include "game/basic/pool_allocator.h"
+#include "game/basic/entity_handle.h"
+#include "game/basic/mpsc_queue.h"
+#include <mutex>
 #include <memory>
-#include <map>
+#include <unordered_map>
+#include <shared_mutex>
+#include <array>
 #include <string>
+#include <vector>
+
+// number of entity registry shards, must be a power of 2
+#define ENTITY_REGISTRY_SHARD_COUNT 64
 
 namespace multiplayer_server
 {
   // forward declaration for entity
   class Entity;
-  class UUID;
 
   // entity factory is a singleton
+  // entities are registered in shards selected by id hash, every shard has its own shared_mutex
+  // lookups of different shards never contend, lookups of one shard only share a read lock
   // final class
   class EntityFactory final
   {
@@ -26,10 +38,13 @@ namespace multiplayer_server
     static EntityFactory& get_instance();
 
     // get entity by id
-    std::shared_ptr<Entity> get_entity(const std::string& id);
+    std::shared_ptr<Entity> get_entity(EntityId id);
+    // get entity by handle, lock free and without reference counting
+    // the pointer stays valid until the end of the current tick
+    Entity *get_entity(EntityHandle handle) const { return handles_.resolve(handle); }
 
     // generate unique id
-    std::string generate_id();
+    EntityId generate_id();
 
     // template function, create a new entity with template type
     template <typename T, typename ...Args>
@@ -39,37 +54,55 @@ namespace multiplayer_server
       static_assert(std::is_base_of<Entity, T>::value, "T must be derived from Entity");
 
       // get a unique id
-      std::string id(generate_id());
+      EntityId id = generate_id();
 
-      // create entity and forward the args
-      std::shared_ptr<T> entity = std::make_shared<T>(id, std::forward<Args>(args)...);
+      // create entity and forward the args, entity and its control block share one pooled block
+      std::shared_ptr<T> entity = make_pooled_shared<T>(id, std::forward<Args>(args)...);
       if (!entity)
       {
         return nullptr;
       }
 
-      entities_.emplace(id, entity);
-
-      // TODO: register entity to a global entity manager, especially for a huge number of server processes
+      register_entity(id, entity);
       return entity;
     }
 
     // template function, create a new entity with id and template type
     template <typename T, typename ...Args>
-    std::shared_ptr<T> create_entity_with_id(const std::string& id, Args... args)
+    std::shared_ptr<T> create_entity_with_id(EntityId id, Args... args)
     {
       // check the type of T, must be derived from Entity
       static_assert(std::is_base_of<Entity, T>::value, "T must be derived from Entity");
 
-      std::shared_ptr<T> entity = std::make_shared<T>(id, std::forward<Args>(args)...);
-      entities_.emplace(id, entity);
-
-      // TODO: register entity to a global entity manager, especially for a huge number of server processes
+      std::shared_ptr<T> entity = make_pooled_shared<T>(id, std::forward<Args>(args)...);
+      if (!register_entity(id, entity))
+      {
+        return nullptr;
+      }
       return entity;
     }
 
     // destroy an entity by id
-    void destroy_entity(const std::string& id);
+    // the entity can't be found and its handles resolve to nullptr immediately
+    // but it's destructed at the end of the tick, so pointers got in this tick stay valid
+    void destroy_entity(EntityId id);
+
+    // destruct entities destroyed in this tick, called at the tick boundary
+    void flush_destroyed_entities();
+
+    // thread safe and lock free except the registry lookup, return false if the entity doesn't exist
+    // the message is handled by the tick thread in the next dispatch_messages()
+    bool post_message(EntityId id, uint16_t message_id, EntityId sender, const char *data, size_t size);
+
+    // handle messages of entities scheduled before the call, each entity handles at most batch_count messages
+    // messages sent while dispatching wait for the next call, called by the world tick
+    void dispatch_messages(size_t batch_count);
+
+    // update components in the world pools, then all valid entities, called by the world tick
+    void update_entities(float dt);
+
+    // number of registered entities
+    size_t get_entity_count() const;
 
   // non-copyable
   private:
@@ -80,8 +113,40 @@ namespace multiplayer_server
     EntityFactory& operator=(const EntityFactory&&) = delete;
 
   private:
-    // map of all entities
-    std::map<std::string, std::shared_ptr<Entity>> entities_;
-    std::shared_ptr<UUID> uuid_;
+    struct alignas(64) EntityShard
+    {
+      mutable std::shared_mutex mutex;
+      std::unordered_map<EntityId, std::shared_ptr<Entity>> entities;
+      // entities of the shard destroyed in this tick, waiting for the tick boundary
+      std::vector<std::shared_ptr<Entity>> destroyed;
+    };
+
+    // low bits of an id are thread slot and sequence, mix all bits to spread ids over shards
+    static size_t get_shard_index(EntityId id) { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 32) & (ENTITY_REGISTRY_SHARD_COUNT - 1); }
+    EntityShard &get_shard(EntityId id) { return shards_[get_shard_index(id)]; }
+
+    // return false if the id is already registered
+    bool register_entity(EntityId id, std::shared_ptr<Entity> entity);
+
+  private:
+    // all entities
+    std::array<EntityShard, ENTITY_REGISTRY_SHARD_COUNT> shards_;
+    // handles of all entities
+    EntityHandleTable handles_;
+
+    // destroyed entities of all shards taken at the tick boundary
+    std::vector<std::shared_ptr<Entity>> flushing_entities_;
+    // entities of the running update, entities may be created or destroyed during update
+    // destroyed ones are released at the tick boundary, so the pointers stay valid during update
+    std::vector<Entity *> update_entities_;
+
+    // an entity with pending messages, it's in the ready queue at most once
+    // the mailbox is released with the entity, a destroyed entity resolves to nullptr and its messages are dropped
+    struct ReadyEntity : public MpscNode
+    {
+      EntityHandle handle;
+    };
+    MpscQueue ready_entities_;
+    std::vector<ReadyEntity *> dispatching_entities_;
   };
 }
\ No newline at end of file
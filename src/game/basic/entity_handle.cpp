@@ -0,0 +1,167 @@
+#include "entity_handle.h"
+
+namespace multiplayer_server
+{
+  EntityHandleTable::~EntityHandleTable()
+  {
+    for (auto &chunk : chunks_)
+    {
+      delete[] chunk.load(std::memory_order_relaxed);
+    }
+  }
+
+  EntityHandleTable::Slot *EntityHandleTable::get_slot(uint32_t slot) const
+  {
+    uint32_t chunk_index = slot / ENTITY_HANDLE_CHUNK_SIZE;
+    if (chunk_index >= ENTITY_HANDLE_MAX_CHUNKS)
+    {
+      return nullptr;
+    }
+
+    Slot *chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+    if (!chunk)
+    {
+      return nullptr;
+    }
+    return &chunk[slot % ENTITY_HANDLE_CHUNK_SIZE];
+  }
+
+  size_t EntityHandleTable::get_thread_free_list_index()
+  {
+    static std::atomic<size_t> next_index{0};
+    static thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) & (ENTITY_HANDLE_FREE_LIST_COUNT - 1);
+    return index;
+  }
+
+  bool EntityHandleTable::allocate_new_slot(uint32_t &index)
+  {
+    index = slot_count_.load(std::memory_order_relaxed);
+    do
+    {
+      if (index >= ENTITY_HANDLE_CHUNK_SIZE * ENTITY_HANDLE_MAX_CHUNKS)
+      {
+        return false;
+      }
+    } while (!slot_count_.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    // the chunk may not exist yet, whoever gets there first creates it
+    auto &chunk = chunks_[index / ENTITY_HANDLE_CHUNK_SIZE];
+    if (!chunk.load(std::memory_order_acquire))
+    {
+      std::lock_guard<std::mutex> lock(chunk_mutex_);
+      if (!chunk.load(std::memory_order_relaxed))
+      {
+        chunk.store(new Slot[ENTITY_HANDLE_CHUNK_SIZE], std::memory_order_release);
+      }
+    }
+    return true;
+  }
+
+  bool EntityHandleTable::pop_free_slot(FreeList &free_list, uint32_t &index)
+  {
+    if (free_list.size.load(std::memory_order_relaxed) == 0)
+    {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(free_list.mutex);
+    if (free_list.slots.empty())
+    {
+      return false;
+    }
+    index = free_list.slots.back();
+    free_list.slots.pop_back();
+    free_list.size.store(free_list.slots.size(), std::memory_order_relaxed);
+    return true;
+  }
+
+  EntityHandle EntityHandleTable::allocate(Entity *entity)
+  {
+    // own list first, then slots freed by other threads, a new slot only if no list has one
+    uint32_t index = 0;
+    size_t own_index = get_thread_free_list_index();
+    bool found = false;
+    for (size_t i = 0; i < ENTITY_HANDLE_FREE_LIST_COUNT && !found; i++)
+    {
+      found = pop_free_slot(free_lists_[(own_index + i) & (ENTITY_HANDLE_FREE_LIST_COUNT - 1)], index);
+    }
+    if (!found && !allocate_new_slot(index))
+    {
+      return EntityHandle();
+    }
+
+    Slot *slot = get_slot(index);
+    slot->entity.store(entity, std::memory_order_release);
+    return EntityHandle{index, slot->generation.load(std::memory_order_relaxed)};
+  }
+
+  // the owner of the handle is the only caller for its slot, so no lock is needed
+  void EntityHandleTable::invalidate(EntityHandle handle)
+  {
+    Slot *slot = get_slot(handle.slot);
+    if (!slot || slot->generation.load(std::memory_order_relaxed) != handle.generation)
+    {
+      return;
+    }
+
+    slot->entity.store(nullptr, std::memory_order_release);
+    // skip 0 when the generation wraps, it's the generation of invalid handles
+    uint32_t generation = handle.generation + 1;
+    slot->generation.store(generation ? generation : 1, std::memory_order_release);
+  }
+
+  void EntityHandleTable::release(EntityHandle handle)
+  {
+    Slot *slot = get_slot(handle.slot);
+    // the slot must be invalidated first
+    if (!slot || slot->generation.load(std::memory_order_relaxed) == handle.generation || slot->entity.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    auto &free_list = free_lists_[get_thread_free_list_index()];
+    std::lock_guard<std::mutex> lock(free_list.mutex);
+    free_list.slots.push_back(handle.slot);
+    free_list.size.store(free_list.slots.size(), std::memory_order_relaxed);
+  }
+
+  Entity *EntityHandleTable::resolve(EntityHandle handle) const
+  {
+    if (!handle.is_valid())
+    {
+      return nullptr;
+    }
+
+    Slot *slot = get_slot(handle.slot);
+    if (!slot || slot->generation.load(std::memory_order_acquire) != handle.generation)
+    {
+      return nullptr;
+    }
+
+    Entity *entity = slot->entity.load(std::memory_order_acquire);
+    // check again, the slot may be invalidated and reused in between
+    if (slot->generation.load(std::memory_order_acquire) != handle.generation)
+    {
+      return nullptr;
+    }
+    return entity;
+  }
+
+  void EntityHandleTable::collect(std::vector<Entity *> &entities) const
+  {
+    uint32_t slot_count = slot_count_.load(std::memory_order_acquire);
+    for (uint32_t index = 0; index < slot_count; index++)
+    {
+      // free and invalidated slots hold nullptr, a slot counted before its chunk exists is skipped
+      Slot *slot = get_slot(index);
+      if (!slot)
+      {
+        continue;
+      }
+      if (Entity *entity = slot->entity.load(std::memory_order_acquire))
+      {
+        entities.push_back(entity);
+      }
+    }
+  }
+}
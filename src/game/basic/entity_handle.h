@@ -0,0 +1,94 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: generational handles of entities, resolve to a raw pointer without touching reference counts
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// number of slots in one chunk of the handle table
+#define ENTITY_HANDLE_CHUNK_SIZE 4096
+// max chunks of the handle table, the table holds up to 4M live entities
+#define ENTITY_HANDLE_MAX_CHUNKS 1024
+// number of free slot lists, must be a power of 2
+#define ENTITY_HANDLE_FREE_LIST_COUNT 64
+
+namespace multiplayer_server
+{
+  class Entity;
+
+  // slot in the handle table plus the generation of the slot when the handle was made
+  // the generation changes when the entity is destroyed, so old handles resolve to nullptr
+  struct EntityHandle
+  {
+    uint32_t slot = 0;
+    // 0 is never used by a live entity
+    uint32_t generation = 0;
+
+    bool is_valid() const { return generation != 0; }
+    bool operator==(const EntityHandle &other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const EntityHandle &other) const { return !(*this == other); }
+  };
+
+  // slots live in chunks that never move, so resolve() and invalidate() are lock free
+  // freed slots go to one of many free lists, a thread allocates from its own list and only takes others when it's empty
+  // new slots come from an atomic counter, only creating a chunk takes a lock
+  class EntityHandleTable
+  {
+  public:
+    EntityHandleTable() = default;
+    ~EntityHandleTable();
+
+    // non-copyable
+    EntityHandleTable(const EntityHandleTable &) = delete;
+    EntityHandleTable &operator=(const EntityHandleTable &) = delete;
+    EntityHandleTable(EntityHandleTable &&) = delete;
+    EntityHandleTable &operator=(EntityHandleTable &&) = delete;
+
+    // bind a slot to the entity, return an invalid handle if the table is full
+    EntityHandle allocate(Entity *entity);
+    // old handles of the slot resolve to nullptr from now on
+    void invalidate(EntityHandle handle);
+    // give the slot back, call it after invalidate() once nobody uses the entity pointer any more
+    void release(EntityHandle handle);
+
+    // thread safe, nullptr if the entity is destroyed
+    Entity *resolve(EntityHandle handle) const;
+
+    // append pointers of all live entities in slot order, without touching reference counts
+    void collect(std::vector<Entity *> &entities) const;
+
+  private:
+    struct Slot
+    {
+      std::atomic<Entity *> entity{nullptr};
+      std::atomic<uint32_t> generation{1};
+    };
+
+    struct alignas(64) FreeList
+    {
+      std::mutex mutex;
+      std::vector<uint32_t> slots;
+      // read without the lock to skip empty lists
+      std::atomic<size_t> size{0};
+    };
+
+    Slot *get_slot(uint32_t slot) const;
+    // return false if the table is full
+    bool allocate_new_slot(uint32_t &index);
+    bool pop_free_slot(FreeList &free_list, uint32_t &index);
+
+    // free list of the calling thread, threads are spread over the lists in the order they first allocate
+    static size_t get_thread_free_list_index();
+
+  private:
+    std::array<std::atomic<Slot *>, ENTITY_HANDLE_MAX_CHUNKS> chunks_ = {};
+    std::atomic<uint32_t> slot_count_{0};
+    // only held to create a chunk
+    std::mutex chunk_mutex_;
+    std::array<FreeList, ENTITY_HANDLE_FREE_LIST_COUNT> free_lists_;
+  };
+}
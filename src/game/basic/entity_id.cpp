@@ -0,0 +1,160 @@
+#include "entity_id.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define ENTITY_ID_THREAD_SLOT_COUNT (1u << ENTITY_ID_THREAD_BITS)
+#define ENTITY_ID_MAX_SEQUENCE ((1u << ENTITY_ID_SEQUENCE_BITS) - 1)
+#define ENTITY_ID_MAX_NODE ((1 << ENTITY_ID_NODE_BITS) - 1)
+
+namespace multiplayer_server
+{
+  static std::atomic<int> s_node_id{0};
+  // bit i is set while slot i is owned by a thread, the shared last slot is never owned
+  static std::atomic<uint64_t> s_used_thread_slots{0};
+  // last timestamp of every freed slot
+  static std::atomic<uint64_t> s_thread_slot_timestamps[ENTITY_ID_THREAD_SLOT_COUNT] = {};
+  // timestamp and sequence of the shared slot, packed as timestamp << sequence bits | sequence
+  static std::atomic<uint64_t> s_shared_slot_state{0};
+
+  struct EntityIdThreadState
+  {
+    uint32_t slot = 0;
+    bool shared = false;
+    uint64_t last_timestamp = 0;
+    uint32_t sequence = 0;
+
+    EntityIdThreadState()
+    {
+      // take the lowest free slot, the last slot is shared by all threads that come when no slot is free
+      uint64_t used = s_used_thread_slots.load(std::memory_order_relaxed);
+      do
+      {
+        slot = 0;
+        while (slot < ENTITY_ID_THREAD_SLOT_COUNT - 1 && (used & (1ULL << slot)))
+        {
+          slot++;
+        }
+      } while (slot < ENTITY_ID_THREAD_SLOT_COUNT - 1 &&
+               !s_used_thread_slots.compare_exchange_weak(used, used | (1ULL << slot), std::memory_order_acquire, std::memory_order_relaxed));
+
+      if (slot == ENTITY_ID_THREAD_SLOT_COUNT - 1)
+      {
+        shared = true;
+        return;
+      }
+
+      // continue after the ids of the last owner, the next id moves to a new millisecond
+      last_timestamp = s_thread_slot_timestamps[slot].load(std::memory_order_relaxed);
+      sequence = ENTITY_ID_MAX_SEQUENCE;
+    }
+
+    ~EntityIdThreadState()
+    {
+      if (shared)
+      {
+        return;
+      }
+      s_thread_slot_timestamps[slot].store(last_timestamp, std::memory_order_relaxed);
+      s_used_thread_slots.fetch_and(~(1ULL << slot), std::memory_order_release);
+    }
+  };
+
+  static thread_local EntityIdThreadState t_state;
+
+  static uint64_t now_timestamp()
+  {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t timestamp = static_cast<uint64_t>(now) > ENTITY_ID_EPOCH_MS ? static_cast<uint64_t>(now) - ENTITY_ID_EPOCH_MS : 0;
+    // never 0, so no id is kInvalidEntityId
+    return timestamp > 0 ? timestamp : 1;
+  }
+
+  // move to now, or to the next sequence, or borrow the next millisecond when the sequence is used up
+  // return false if borrowing would go too far ahead of the clock, the caller waits and tries again
+  static bool advance(uint64_t now, uint64_t &timestamp, uint32_t &sequence)
+  {
+    if (now > timestamp)
+    {
+      timestamp = now;
+      sequence = 0;
+    }
+    else if (sequence < ENTITY_ID_MAX_SEQUENCE)
+    {
+      sequence++;
+    }
+    else if (timestamp - now < ENTITY_ID_MAX_BORROW_MS)
+    {
+      timestamp++;
+      sequence = 0;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  static EntityId compose(uint64_t timestamp, uint32_t slot, uint32_t sequence)
+  {
+    uint64_t node = static_cast<uint64_t>(s_node_id.load(std::memory_order_relaxed));
+    return (timestamp << (ENTITY_ID_NODE_BITS + ENTITY_ID_THREAD_BITS + ENTITY_ID_SEQUENCE_BITS)) |
+           (node << (ENTITY_ID_THREAD_BITS + ENTITY_ID_SEQUENCE_BITS)) |
+           (static_cast<uint64_t>(slot) << ENTITY_ID_SEQUENCE_BITS) |
+           sequence;
+  }
+
+  bool EntityIdGenerator::set_node_id(int node_id)
+  {
+    if (node_id < 0 || node_id > ENTITY_ID_MAX_NODE)
+    {
+      return false;
+    }
+
+    s_node_id.store(node_id, std::memory_order_relaxed);
+    return true;
+  }
+
+  int EntityIdGenerator::get_node_id()
+  {
+    return s_node_id.load(std::memory_order_relaxed);
+  }
+
+  EntityId EntityIdGenerator::generate()
+  {
+    auto &state = t_state;
+    uint64_t now = now_timestamp();
+
+    if (!state.shared)
+    {
+      while (!advance(now, state.last_timestamp, state.sequence))
+      {
+        std::this_thread::yield();
+        now = now_timestamp();
+      }
+      return compose(state.last_timestamp, state.slot, state.sequence);
+    }
+
+    uint64_t old_state = s_shared_slot_state.load(std::memory_order_relaxed);
+    uint64_t timestamp = 0;
+    uint32_t sequence = 0;
+    do
+    {
+      timestamp = old_state >> ENTITY_ID_SEQUENCE_BITS;
+      sequence = static_cast<uint32_t>(old_state & ENTITY_ID_MAX_SEQUENCE);
+      if (!advance(now, timestamp, sequence))
+      {
+        std::this_thread::yield();
+        now = now_timestamp();
+        old_state = s_shared_slot_state.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (s_shared_slot_state.compare_exchange_weak(old_state, (timestamp << ENTITY_ID_SEQUENCE_BITS) | sequence, std::memory_order_relaxed))
+      {
+        break;
+      }
+    } while (true);
+
+    return compose(timestamp, state.slot, sequence);
+  }
+}
@@ -0,0 +1,45 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: 64 bit unique entity id, generated per thread without locks
+#pragma once
+
+#include <cstdint>
+
+// bit layout of an entity id from high to low: timestamp | node | thread slot | sequence
+#define ENTITY_ID_TIMESTAMP_BITS 41
+#define ENTITY_ID_NODE_BITS 10
+#define ENTITY_ID_THREAD_BITS 6
+#define ENTITY_ID_SEQUENCE_BITS 7
+// milliseconds of 2026-01-01 00:00:00 UTC, timestamps count from it and last about 69 years
+#define ENTITY_ID_EPOCH_MS 1767225600000ULL
+// max milliseconds a thread may borrow ahead of the clock when its sequence runs out, then it waits for the clock
+#define ENTITY_ID_MAX_BORROW_MS 1000
+
+namespace multiplayer_server
+{
+  using EntityId = uint64_t;
+
+  // no entity has id 0
+  constexpr EntityId kInvalidEntityId = 0;
+
+  // snowflake style generator
+  // every thread takes a free thread slot on first use, so threads never share a sequence
+  // the slot is freed when the thread exits, the next owner continues after the last timestamp of the slot
+  // threads beyond the slot count share the last slot through an atomic compare exchange
+  // when a thread runs out of sequence within one millisecond, it borrows the next millisecond
+  // it borrows at most ENTITY_ID_MAX_BORROW_MS ahead of the clock, so ids of a restarted process don't collide
+  class EntityIdGenerator
+  {
+  public:
+    // set once at start up, before any id is generated
+    static bool set_node_id(int node_id);
+    static int get_node_id();
+
+    // thread safe and lock free
+    static EntityId generate();
+
+    // parts of an id, for logs and debugging
+    static uint64_t get_timestamp(EntityId id) { return id >> (ENTITY_ID_NODE_BITS + ENTITY_ID_THREAD_BITS + ENTITY_ID_SEQUENCE_BITS); }
+    static int get_node_id(EntityId id) { return static_cast<int>((id >> (ENTITY_ID_THREAD_BITS + ENTITY_ID_SEQUENCE_BITS)) & ((1u << ENTITY_ID_NODE_BITS) - 1)); }
+  };
+}
@@ -0,0 +1,39 @@
+#include "mailbox.h"
+
+namespace multiplayer_server
+{
+  Mailbox::~Mailbox()
+  {
+    // messages of a destroyed entity are dropped
+    while (MpscNode *node = queue_.pop())
+    {
+      delete static_cast<EntityMessage *>(node);
+    }
+  }
+
+  bool Mailbox::push(std::unique_ptr<EntityMessage> message)
+  {
+    queue_.push(message.release());
+    return pending_count_.fetch_add(1, std::memory_order_acq_rel) == 0;
+  }
+
+  bool Mailbox::drain(size_t max_count, const Handler &handler)
+  {
+    size_t count = 0;
+    while (count < max_count)
+    {
+      // a half done push counts as pending but can't be popped yet, it's handled next time
+      MpscNode *node = queue_.pop();
+      if (!node)
+      {
+        break;
+      }
+
+      std::unique_ptr<EntityMessage> message(static_cast<EntityMessage *>(node));
+      count++;
+      handler(*message);
+    }
+
+    return pending_count_.fetch_sub(count, std::memory_order_acq_rel) != count;
+  }
+}
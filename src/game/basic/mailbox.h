@@ -0,0 +1,63 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: per entity mailbox, any thread sends messages to an entity and the tick thread handles them
+#pragma once
+
+#include "game/basic/entity_id.h"
+#include "game/basic/mpsc_queue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// max messages an entity handles in one tick, the rest wait for the next tick
+#define MAILBOX_DRAIN_BATCH 64
+
+namespace multiplayer_server
+{
+  struct EntityMessage : public MpscNode
+  {
+    EntityMessage(uint16_t message_id, EntityId sender, const char *data, size_t size)
+        : message_id(message_id), sender(sender), data(data, data + size) {}
+
+    uint16_t message_id = 0;
+    // kInvalidEntityId if the message doesn't come from an entity, for example a client
+    EntityId sender = kInvalidEntityId;
+    std::vector<char> data;
+  };
+
+  // messages of one entity in send order
+  // the mailbox counts pending messages, the push that makes the count leave 0 returns true
+  // and the caller schedules the entity, so a mailbox is scheduled once no matter how many threads send to it
+  // the scheduled mailbox stays scheduled until drain() empties it
+  class Mailbox
+  {
+  public:
+    using Handler = std::function<void(const EntityMessage &message)>;
+
+  public:
+    Mailbox() = default;
+    ~Mailbox();
+
+    // non-copyable
+    Mailbox(const Mailbox &) = delete;
+    Mailbox &operator=(const Mailbox &) = delete;
+    Mailbox(Mailbox &&) = delete;
+    Mailbox &operator=(Mailbox &&) = delete;
+
+    // thread safe, return true if the mailbox needs to be scheduled
+    bool push(std::unique_ptr<EntityMessage> message);
+
+    // only called by the thread that scheduled the mailbox
+    // handle up to max_count messages, return true if messages are left and the mailbox is still scheduled
+    bool drain(size_t max_count, const Handler &handler);
+
+    size_t get_pending_count() const { return pending_count_.load(std::memory_order_relaxed); }
+
+  private:
+    MpscQueue queue_;
+    std::atomic<size_t> pending_count_{0};
+  };
+}
@@ -0,0 +1,82 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: intrusive lock free queue of many producers and one consumer
+#pragma once
+
+#include <atomic>
+
+namespace multiplayer_server
+{
+  // derive queued objects from it, a node is in at most one queue at a time
+  struct MpscNode
+  {
+    std::atomic<MpscNode *> next{nullptr};
+  };
+
+  // push is wait free from any thread, pop is only called by the consumer thread
+  // a push is one atomic exchange, nodes are linked in place so the queue never allocates
+  // the queue doesn't own its nodes, pop them all before the queue is destructed
+  class MpscQueue
+  {
+  public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+    ~MpscQueue() = default;
+
+    // non-copyable
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+    MpscQueue(MpscQueue &&) = delete;
+    MpscQueue &operator=(MpscQueue &&) = delete;
+
+    void push(MpscNode *node)
+    {
+      node->next.store(nullptr, std::memory_order_relaxed);
+      MpscNode *prev = head_.exchange(node, std::memory_order_acq_rel);
+      // the node is unreachable by the consumer until this store, pop sees an empty queue meanwhile
+      prev->next.store(node, std::memory_order_release);
+    }
+
+    // nullptr if the queue is empty or a push is half done
+    MpscNode *pop()
+    {
+      MpscNode *tail = tail_;
+      MpscNode *next = tail->next.load(std::memory_order_acquire);
+      if (tail == &stub_)
+      {
+        if (!next)
+        {
+          return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+      }
+
+      if (next)
+      {
+        tail_ = next;
+        return tail;
+      }
+
+      // tail is the last node, put the stub behind it so tail can be returned
+      if (tail != head_.load(std::memory_order_acquire))
+      {
+        return nullptr;
+      }
+      push(&stub_);
+      next = tail->next.load(std::memory_order_acquire);
+      if (next)
+      {
+        tail_ = next;
+        return tail;
+      }
+      return nullptr;
+    }
+
+  private:
+    // producers and the consumer touch different ends, keep them on different cache lines
+    alignas(64) std::atomic<MpscNode *> head_;
+    alignas(64) MpscNode *tail_;
+    MpscNode stub_;
+  };
+}
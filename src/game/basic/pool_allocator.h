@@ -0,0 +1,224 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: slab pools of fixed size blocks and a std allocator on top of them
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// number of blocks carved from one slab
+#define SLAB_POOL_BLOCKS_PER_SLAB 256
+// max free blocks a thread keeps of one pool, it takes the shared lock once per half of it
+#define SLAB_POOL_THREAD_CACHE_SIZE 64
+
+namespace multiplayer_server
+{
+  // pool of blocks of one size and alignment, blocks are carved from big slabs and recycled through a free list
+  // slabs are never returned to the system, so churn of one object type doesn't fragment the heap
+  // every thread caches some free blocks, so most allocations don't touch the shared lock
+  template <size_t BlockSize, size_t BlockAlign>
+  class SlabPool final
+  {
+  public:
+    // the pool is never destructed, objects released during static destruction can still return blocks
+    static SlabPool &get_instance()
+    {
+      static SlabPool *instance = new SlabPool();
+      return *instance;
+    }
+
+    // non-copyable
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+    SlabPool(SlabPool &&) = delete;
+    SlabPool &operator=(SlabPool &&) = delete;
+
+    void *allocate()
+    {
+      ThreadCache &cache = get_thread_cache();
+      if (cache.closed)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pop_block();
+      }
+
+      if (cache.count == 0)
+      {
+        register_thread_cache(cache);
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (cache.count < SLAB_POOL_THREAD_CACHE_SIZE / 2)
+        {
+          cache.blocks[cache.count++] = pop_block();
+        }
+      }
+      return cache.blocks[--cache.count];
+    }
+
+    void deallocate(void *pointer)
+    {
+      FreeBlock *block = static_cast<FreeBlock *>(pointer);
+      ThreadCache &cache = get_thread_cache();
+      if (cache.closed)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        push_block(block);
+        return;
+      }
+
+      register_thread_cache(cache);
+      if (cache.count == SLAB_POOL_THREAD_CACHE_SIZE)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (cache.count > SLAB_POOL_THREAD_CACHE_SIZE / 2)
+        {
+          push_block(cache.blocks[--cache.count]);
+        }
+      }
+      cache.blocks[cache.count++] = block;
+    }
+
+  private:
+    SlabPool() = default;
+
+    struct FreeBlock
+    {
+      FreeBlock *next;
+    };
+
+    // blocks of one thread, moved from and to the shared free list half a cache at a time
+    // trivially destructible, so blocks freed after the thread cache closed still find it and go to the shared list
+    struct ThreadCache
+    {
+      FreeBlock *blocks[SLAB_POOL_THREAD_CACHE_SIZE];
+      size_t count;
+      bool registered;
+      bool closed;
+    };
+
+    // gives the cached blocks back when the thread exits
+    struct ThreadCacheCloser
+    {
+      ~ThreadCacheCloser()
+      {
+        ThreadCache &cache = get_thread_cache();
+        SlabPool &pool = get_instance();
+        std::lock_guard<std::mutex> lock(pool.mutex_);
+        while (cache.count > 0)
+        {
+          pool.push_block(cache.blocks[--cache.count]);
+        }
+        cache.closed = true;
+      }
+    };
+
+    static ThreadCache &get_thread_cache()
+    {
+      static thread_local ThreadCache cache;
+      return cache;
+    }
+
+    static void register_thread_cache(ThreadCache &cache)
+    {
+      if (!cache.registered)
+      {
+        cache.registered = true;
+        static thread_local ThreadCacheCloser closer;
+        (void)closer;
+      }
+    }
+
+    // a free block stores the next pointer in place
+    static constexpr size_t kBlockAlign = BlockAlign > alignof(FreeBlock) ? BlockAlign : alignof(FreeBlock);
+    static constexpr size_t kBlockSize = ((BlockSize > sizeof(FreeBlock) ? BlockSize : sizeof(FreeBlock)) + kBlockAlign - 1) / kBlockAlign * kBlockAlign;
+
+    struct alignas(kBlockAlign) Block
+    {
+      unsigned char data[kBlockSize];
+    };
+
+    // called with the lock held
+    FreeBlock *pop_block()
+    {
+      if (!free_list_)
+      {
+        grow();
+      }
+      FreeBlock *block = free_list_;
+      free_list_ = block->next;
+      return block;
+    }
+
+    // called with the lock held
+    void push_block(FreeBlock *block)
+    {
+      block->next = free_list_;
+      free_list_ = block;
+    }
+
+    void grow()
+    {
+      slabs_.emplace_back(new Block[SLAB_POOL_BLOCKS_PER_SLAB]);
+      Block *slab = slabs_.back().get();
+      // link blocks in address order, so new objects are allocated next to each other
+      for (size_t i = SLAB_POOL_BLOCKS_PER_SLAB; i > 0; i--)
+      {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(slab[i - 1].data);
+        block->next = free_list_;
+        free_list_ = block;
+      }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Block[]>> slabs_;
+    FreeBlock *free_list_ = nullptr;
+  };
+
+  // std allocator on slab pools, use it with std::allocate_shared
+  // allocate_shared rebinds it to its control block type, so the object and its control block share one pooled block
+  template <typename T>
+  class PoolAllocator
+  {
+  public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    T *allocate(size_t count)
+    {
+      // arrays are not pooled
+      if (count != 1)
+      {
+        return static_cast<T *>(::operator new(count * sizeof(T)));
+      }
+      return static_cast<T *>(SlabPool<sizeof(T), alignof(T)>::get_instance().allocate());
+    }
+
+    void deallocate(T *pointer, size_t count) noexcept
+    {
+      if (count != 1)
+      {
+        ::operator delete(pointer);
+        return;
+      }
+      SlabPool<sizeof(T), alignof(T)>::get_instance().deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const noexcept { return false; }
+  };
+
+  // create a shared object in a slab pool of its type
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make_pooled_shared(Args &&...args)
+  {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+  }
+}
@@ -1,11 +1,14 @@
 #include "server_entity.h"
 #include "log/logger.h"
+#include "game/basic/pool_allocator.h"
+#include "game/directory/entity_directory.h"
+#include "game/session/session_manager.h"
 
 namespace multiplayer_server
 {
-  ServerEntity::ServerEntity(const std::string &id, ServerEntityType type, const std::string &ip, int port) : Entity(id), type_(type)
+  ServerEntity::ServerEntity(EntityId id, ServerEntityType type, const std::string &ip, int port) : Entity(id), type_(type)
   {
-    proxy_ = std::make_shared<EntityProxy>(g_logger);
+    proxy_ = make_pooled_shared<EntityProxy>(g_logger);
     proxy_->set_proxy(id, ip, port);
   }
 
@@ -23,6 +26,45 @@ namespace multiplayer_server
     Entity::render();
   }
 
+  void ServerEntity::before_destruct()
+  {
+    unregister_from_directory();
+    // a mirror shares the id of the real entity, the session belongs to the real one
+    // an entity moving away detached its session, an entity taken back in the same tick owns it again
+    if (ServerEntityType::kMirrorEntity != type_)
+    {
+      SessionManager::get_instance().close(id_, get_handle());
+    }
+    Entity::before_destruct();
+  }
+
+  void ServerEntity::register_in_directory()
+  {
+    if (ServerEntityType::kMirrorEntity == type_)
+    {
+      return;
+    }
+
+    in_directory_ = true;
+    EntityDirectory::get_instance().register_entity(*proxy_);
+  }
+
+  void ServerEntity::unregister_from_directory()
+  {
+    if (!in_directory_)
+    {
+      return;
+    }
+
+    in_directory_ = false;
+    EntityDirectory::get_instance().unregister_entity(*proxy_);
+  }
+
+  void ServerEntity::on_message(uint16_t message_id, [[maybe_unused]] const char *data, size_t size)
+  {
+    logger_->debug("ServerEntity {} ignore message {}, size {}", id_, message_id, size);
+  }
+
   // entity is a local entity if the ip and port is the same
   bool ServerEntity::is_local(const std::string &ip, int port)
   {
@@ -30,7 +30,7 @@ namespace multiplayer_server
     };
 
   public:
-    ServerEntity(const std::string &id, ServerEntityType type, const std::string &ip, int port);
+    ServerEntity(EntityId id, ServerEntityType type, const std::string &ip, int port);
     virtual ~ServerEntity();
 
     virtual void update(float dt) override;
@@ -44,6 +44,23 @@ namespace multiplayer_server
     // if this entity is a local entity
     bool is_local(const std::string &ip, int port);
 
+    // work a service instance has in hand, least loaded routing picks the instance with the smallest load
+    virtual size_t get_load() const { return 0; }
+
+    // handle a message of the mailbox of this entity, messages are posted by EntityFactory::post_message
+    // or by MigrationService::route_message when the service is enabled, so they are buffered or forwarded while the entity moves
+    virtual void on_message(uint16_t message_id, const char *data, size_t size) override;
+
+    // point the proxy to the process the entity lives in
+    void set_proxy(const std::string &ip, int port) { proxy_->set_proxy(id_, ip, port); }
+
+    // publish the location of the entity to EntityDirectory, it is unregistered when the entity is destroyed
+    // mirror entities are never registered, the directory points to the process the real entity lives in
+    void register_in_directory();
+    void unregister_from_directory();
+
+    virtual void before_destruct() override;
+
     // get entity type from string
     static ServerEntityType get_type_from_string(const std::string &type);
 
@@ -53,5 +70,8 @@ namespace multiplayer_server
 
     // proxy of the entity, use shared_ptr to avoid the entity destruct before the proxy
     std::shared_ptr<EntityProxy> proxy_ = nullptr;
+
+    // registered in EntityDirectory
+    bool in_directory_ = false;
   };
 }
\ No newline at end of file
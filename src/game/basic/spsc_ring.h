@@ -0,0 +1,88 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: bounded lock free ring of one producer and one consumer
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace multiplayer_server
+{
+  // capacity is rounded up to a power of 2, slots are allocated once
+  // try_push is only called by the producer thread and try_pop by the consumer thread
+  // every side caches the index of the other side, so it only touches the shared cache line when the cached one runs out
+  template <typename T>
+  class SpscRing
+  {
+  public:
+    explicit SpscRing(size_t capacity)
+    {
+      size_t size = 2;
+      while (size < capacity)
+      {
+        size <<= 1;
+      }
+      mask_ = size - 1;
+      slots_ = std::make_unique<T[]>(size);
+    }
+    ~SpscRing() = default;
+
+    // non-copyable
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+    SpscRing(SpscRing &&) = delete;
+    SpscRing &operator=(SpscRing &&) = delete;
+
+    // return false and keep value if the ring is full
+    bool try_push(T &&value)
+    {
+      size_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail - cached_head_ > mask_)
+      {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ > mask_)
+        {
+          return false;
+        }
+      }
+
+      slots_[tail & mask_] = std::move(value);
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    // return false if the ring is empty, the slot is reset so it doesn't keep resources alive
+    bool try_pop(T &value)
+    {
+      size_t head = head_.load(std::memory_order_relaxed);
+      if (head == cached_tail_)
+      {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_)
+        {
+          return false;
+        }
+      }
+
+      value = std::move(slots_[head & mask_]);
+      slots_[head & mask_] = T();
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    size_t get_capacity() const { return mask_ + 1; }
+
+  private:
+    size_t mask_ = 0;
+    std::unique_ptr<T[]> slots_;
+
+    // consumer side
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+    // producer side
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+  };
+}
@@ -0,0 +1,112 @@
+#include "aoi_component.h"
+#include "game/basic/entity.h"
+#include "game/basic/component_registry.h"
+
+namespace multiplayer_server
+{
+  // after components that move the owner
+  REGISTER_COMPONENT(AoiComponent, 100);
+
+  AoiComponent::AoiComponent(Entity *owner) :
+    AoiComponent(owner, AoiGrid::get_instance().get_default_view_radius())
+  {
+  }
+
+  AoiComponent::AoiComponent(Entity *owner, float view_radius) :
+    Component(owner)
+  {
+    set_name("AoiComponent");
+    view_radius_ = view_radius;
+  }
+
+  AoiComponent::~AoiComponent()
+  {
+  }
+
+  void AoiComponent::update([[maybe_unused]]float dt)
+  {
+  }
+
+  void AoiComponent::render()
+  {
+  }
+
+  // leave the grid before the owner is gone
+  void AoiComponent::before_destruct()
+  {
+    if (in_grid_)
+    {
+      AoiGrid::get_instance().remove(get_owner_id());
+      in_grid_ = false;
+    }
+  }
+
+  EntityId AoiComponent::get_owner_id() const
+  {
+    Entity *owner = get_owner();
+    return owner ? owner->get_id() : kInvalidEntityId;
+  }
+
+  void AoiComponent::set_position(float x, float z)
+  {
+    x_ = x;
+    z_ = z;
+
+    EntityId id = get_owner_id();
+    if (id == kInvalidEntityId)
+    {
+      return;
+    }
+
+    AoiGrid &grid = AoiGrid::get_instance();
+    if (in_grid_)
+    {
+      grid.move(id, x, z);
+      return;
+    }
+
+    in_grid_ = grid.add(id, x, z, view_radius_.get());
+    if (in_grid_ && handler_)
+    {
+      grid.set_event_handler(id, handler_);
+    }
+  }
+
+  void AoiComponent::on_state_loaded()
+  {
+    if (!in_grid_.get())
+    {
+      return;
+    }
+    in_grid_ = false;
+    set_position(x_.get(), z_.get());
+  }
+
+  void AoiComponent::set_view_radius(float view_radius)
+  {
+    view_radius_ = view_radius;
+    if (in_grid_)
+    {
+      AoiGrid::get_instance().set_view_radius(get_owner_id(), view_radius);
+    }
+  }
+
+  void AoiComponent::set_event_handler(AoiGrid::EventHandler handler)
+  {
+    handler_ = std::move(handler);
+    if (in_grid_)
+    {
+      AoiGrid::get_instance().set_event_handler(get_owner_id(), handler_);
+    }
+  }
+
+  std::vector<EntityId> AoiComponent::get_visible() const
+  {
+    return in_grid_ ? AoiGrid::get_instance().get_visible(get_owner_id()) : std::vector<EntityId>();
+  }
+
+  std::vector<EntityId> AoiComponent::get_observers() const
+  {
+    return in_grid_ ? AoiGrid::get_instance().get_observers(get_owner_id()) : std::vector<EntityId>();
+  }
+}
@@ -0,0 +1,62 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: area of interest component, puts its owner into the aoi grid of the world
+#pragma once
+
+#include "game/aoi/aoi_grid.h"
+#include "game/basic/component.h"
+#include <vector>
+
+namespace multiplayer_server
+{
+  // the owner joins the grid on the first set_position() and leaves it when the component is destroyed
+  class AoiComponent : public Component
+  {
+  public:
+    // use the default view radius of the grid
+    AoiComponent(Entity *owner);
+    AoiComponent(Entity *owner, float view_radius);
+    virtual ~AoiComponent();
+
+    // non-copyable
+    AoiComponent(const AoiComponent&) = delete;
+    AoiComponent& operator=(const AoiComponent&) = delete;
+    AoiComponent(AoiComponent&&) = delete;
+    AoiComponent& operator=(AoiComponent&&) = delete;
+
+  public:
+    void set_position(float x, float z);
+    float get_x() const { return x_.get(); }
+    float get_z() const { return z_.get(); }
+
+    void set_view_radius(float view_radius);
+    float get_view_radius() const { return view_radius_.get(); }
+
+    // enter, leave and move events of entities in view, called once per tick during the replicate phase
+    void set_event_handler(AoiGrid::EventHandler handler);
+
+    bool is_in_grid() const { return in_grid_.get(); }
+    std::vector<EntityId> get_visible() const;
+    std::vector<EntityId> get_observers() const;
+
+    virtual void update(float dt);
+    virtual void render();
+
+    virtual void before_destruct();
+
+    // join the grid again at the restored position
+    virtual void on_state_loaded();
+
+  private:
+    EntityId get_owner_id() const;
+
+  private:
+    // position is replicated to observers, view radius stays on the server
+    Property<float> x_{properties_, "x", PropertyScope::kAllObservers};
+    Property<float> z_{properties_, "z", PropertyScope::kAllObservers};
+    Property<float> view_radius_{properties_, "view_radius", PropertyScope::kServerOnly, AOI_DEFAULT_VIEW_RADIUS};
+    // restored with the position, the entity joins the grid again only if it was in the grid
+    Property<bool> in_grid_{properties_, "in_grid", PropertyScope::kServerOnly, false};
+    AoiGrid::EventHandler handler_;
+  };
+}
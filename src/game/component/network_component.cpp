@@ -1,16 +1,112 @@
 #include "network_component.h"
 #include "game/basic/entity.h"
+#include "game/basic/component_registry.h"
+#include "game/io/io_bridge.h"
 
 namespace multiplayer_server
 {
-  NetworkComponent::NetworkComponent(std::shared_ptr<Entity> owner, std::shared_ptr<Connection> connection) : 
-    Component(owner), connection_(connection)
+  // connection state is settled before gameplay components update
+  REGISTER_COMPONENT(NetworkComponent, -100);
+
+  NetworkComponent::NetworkComponent(Entity *owner, std::shared_ptr<Connection> connection) : 
+    Component(owner)
   {
     set_name("NetworkComponent");
+    set_connection(connection);
   }
 
   NetworkComponent::~NetworkComponent()
   {
+    unindex_connection();
+  }
+
+  std::unordered_map<uint64_t, NetworkComponent *> &NetworkComponent::get_connection_index()
+  {
+    static std::unordered_map<uint64_t, NetworkComponent *> index;
+    return index;
+  }
+
+  NetworkComponent *NetworkComponent::find_by_connection(uint64_t connection_id)
+  {
+    auto &index = get_connection_index();
+    auto iter = index.find(connection_id);
+    return iter != index.end() ? iter->second : nullptr;
+  }
+
+  void NetworkComponent::set_connection(std::shared_ptr<Connection> connection)
+  {
+    unindex_connection();
+    connection_ = connection;
+    if (connection_)
+    {
+      // the latest holder wins, for example a mirror takes the connection of an entity moving away
+      get_connection_index()[connection_->get_connection_id()] = this;
+    }
+
+    if (!suspended_ || !connection_)
+    {
+      return;
+    }
+
+    // the client is back, it gets what it missed in the original order of each lane
+    suspended_ = false;
+    overflowed_ = false;
+    std::vector<PendingMessage> pending;
+    pending.swap(pending_messages_);
+    for (auto &message : pending)
+    {
+      IoBridge::get_instance().send(connection_, message.message_id, message.payload.data(), message.payload.size(), message.lane);
+    }
+  }
+
+  bool NetworkComponent::send(uint16_t message_id, const void *data, size_t size, SendLane lane)
+  {
+    if (connection_)
+    {
+      return IoBridge::get_instance().send(connection_, message_id, data, size, lane);
+    }
+
+    if (!suspended_ || overflowed_)
+    {
+      return false;
+    }
+
+    if (pending_messages_.size() >= max_pending_messages_)
+    {
+      // a gap can't be replayed, the client has to login again
+      overflowed_ = true;
+      pending_messages_.clear();
+      return false;
+    }
+
+    const char *bytes = static_cast<const char *>(data);
+    pending_messages_.push_back(PendingMessage{message_id, lane, std::vector<char>(bytes, bytes + size)});
+    return true;
+  }
+
+  void NetworkComponent::suspend(size_t max_buffered_messages)
+  {
+    unindex_connection();
+    connection_.reset();
+    suspended_ = true;
+    overflowed_ = false;
+    max_pending_messages_ = max_buffered_messages;
+    pending_messages_.clear();
+  }
+
+  void NetworkComponent::unindex_connection()
+  {
+    if (!connection_)
+    {
+      return;
+    }
+
+    auto &index = get_connection_index();
+    auto iter = index.find(connection_->get_connection_id());
+    if (iter != index.end() && iter->second == this)
+    {
+      index.erase(iter);
+    }
   }
 
   void NetworkComponent::update([[maybe_unused]]float dt)
@@ -24,12 +120,17 @@ namespace multiplayer_server
   // abstract method for before destruct
   void NetworkComponent::before_destruct()
   {
+    // release without closing, a mirror may have taken the connection over
+    unindex_connection();
+    connection_.reset();
+    disconnect_handlers_.clear();
+    pending_messages_.clear();
   }
 
   void NetworkComponent::handle_disconnect()
   {
     // if owner is nullptr, return
-    auto owner = get_owner();
+    Entity *owner = get_owner();
 
     if (!owner)
     {
@@ -38,13 +139,13 @@ namespace multiplayer_server
 
     for (auto &handler : disconnect_handlers_)
     {
-      const std::string &id = owner->get_id();
+      EntityId id = owner->get_id();
       handler.second(id);
     }
   }
 
   // register disconnect handler
-  bool NetworkComponent::register_disconnect_handler(const std::string &name, std::function<void(const std::string &id)> handler)
+  bool NetworkComponent::register_disconnect_handler(const std::string &name, std::function<void(EntityId id)> handler)
   {
     if (disconnect_handlers_.find(name) != disconnect_handlers_.end())
     {
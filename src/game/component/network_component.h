@@ -4,9 +4,13 @@
 #pragma once
 
 #include "game/basic/component.h"
+#include "game/basic/entity_id.h"
 #include "network/connection.h"
+#include "network/message_frame.h"
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <functional>
 
 namespace multiplayer_server
@@ -14,7 +18,7 @@ namespace multiplayer_server
   class NetworkComponent : public Component
   {
   public:
-    NetworkComponent(std::shared_ptr<Entity> owner, std::shared_ptr<Connection> connection = nullptr);
+    NetworkComponent(Entity *owner, std::shared_ptr<Connection> connection = nullptr);
     virtual ~NetworkComponent();
 
     // non-copyable
@@ -26,21 +30,53 @@ namespace multiplayer_server
   public:
     // get connection
     std::shared_ptr<Connection> get_connection() const { return connection_; }
-    // set connection
-    void set_connection(std::shared_ptr<Connection> connection) { connection_ = connection; }
+    // set connection, the entity can be found by the id of the connection afterwards
+    // messages kept while suspended are sent to the new connection first
+    void set_connection(std::shared_ptr<Connection> connection);
 
-    // handle disconnect when connection is disconnected
+    // queue a message to the client through the io bridge, called by the tick thread
+    // while suspended the message is kept for the next connection, return false if it's dropped
+    bool send(uint16_t message_id, const void *data, size_t size, SendLane lane = SendLane::kRealtime);
+    // the client may come back, drop the connection and keep at most max_buffered_messages sent until it's back
+    void suspend(size_t max_buffered_messages);
+    bool is_suspended() const { return suspended_; }
+    // more messages were sent while suspended than could be kept, the client can't resume
+    bool is_overflowed() const { return overflowed_; }
+    // connected, or suspended and still keeping messages
+    bool can_send() const { return connection_ || (suspended_ && !overflowed_); }
+
+    // component holding the connection, nullptr if no entity holds it, only used by the tick thread
+    static NetworkComponent *find_by_connection(uint64_t connection_id);
+
+    // call disconnect handlers on the tick thread, the owner is destroyed right after them
     void handle_disconnect();
-    bool register_disconnect_handler(const std::string &name, std::function<void(const std::string &id)> handler);
+    bool register_disconnect_handler(const std::string &name, std::function<void(EntityId id)> handler);
 
     virtual void update(float dt);
     virtual void render();
 
     virtual void before_destruct();
 
+  private:
+    // connection id -> component holding the connection
+    static std::unordered_map<uint64_t, NetworkComponent *> &get_connection_index();
+    void unindex_connection();
+
   private:
     // connection
     std::shared_ptr<Connection> connection_;
-    std::map<std::string, std::function<void(const std::string &id)>> disconnect_handlers_;
+    std::map<std::string, std::function<void(EntityId id)>> disconnect_handlers_;
+
+    // a message sent while suspended
+    struct PendingMessage
+    {
+      uint16_t message_id = 0;
+      SendLane lane = SendLane::kRealtime;
+      std::vector<char> payload;
+    };
+    bool suspended_ = false;
+    bool overflowed_ = false;
+    size_t max_pending_messages_ = 0;
+    std::vector<PendingMessage> pending_messages_;
   };
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "directory_backend.h"
+
+namespace multiplayer_server
+{
+  static bool is_same_location(const EntityProxy &left, const EntityProxy &right)
+  {
+    return left.get_port() == right.get_port() && left.get_ip() == right.get_ip();
+  }
+
+  void LocalDirectoryBackend::register_entities(const std::vector<EntityProxy> &proxies)
+  {
+    std::vector<EntityId> moved;
+    for (const auto &proxy : proxies)
+    {
+      Shard &shard = shards_[get_shard_index(proxy.get_entity_id())];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      auto &entry = shard.entries[proxy.get_entity_id()];
+      if (entry && is_same_location(*entry, proxy))
+      {
+        continue;
+      }
+      if (entry)
+      {
+        moved.push_back(proxy.get_entity_id());
+      }
+      entry = std::make_shared<const EntityProxy>(proxy);
+    }
+
+    notify(moved);
+  }
+
+  void LocalDirectoryBackend::unregister_entities(const std::vector<EntityProxy> &proxies)
+  {
+    std::vector<EntityId> removed;
+    for (const auto &proxy : proxies)
+    {
+      Shard &shard = shards_[get_shard_index(proxy.get_entity_id())];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      auto iter = shard.entries.find(proxy.get_entity_id());
+      if (iter == shard.entries.end() || !is_same_location(*iter->second, proxy))
+      {
+        continue;
+      }
+      shard.entries.erase(iter);
+      removed.push_back(proxy.get_entity_id());
+    }
+
+    notify(removed);
+  }
+
+  std::shared_ptr<const EntityProxy> LocalDirectoryBackend::lookup(EntityId id)
+  {
+    Shard &shard = shards_[get_shard_index(id)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto iter = shard.entries.find(id);
+    return iter != shard.entries.end() ? iter->second : nullptr;
+  }
+
+  void LocalDirectoryBackend::subscribe(InvalidateHandler handler)
+  {
+    std::lock_guard<std::mutex> lock(subscriber_mutex_);
+    subscribers_.push_back(std::move(handler));
+  }
+
+  size_t LocalDirectoryBackend::size() const
+  {
+    size_t count = 0;
+    for (const auto &shard : shards_)
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      count += shard.entries.size();
+    }
+    return count;
+  }
+
+  void LocalDirectoryBackend::notify(const std::vector<EntityId> &ids)
+  {
+    if (ids.empty())
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(subscriber_mutex_);
+    for (const auto &handler : subscribers_)
+    {
+      handler(ids);
+    }
+  }
+}
@@ -0,0 +1,78 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: authoritative store of entity locations, entity id -> proxy of the process the entity lives in
+#pragma once
+
+#include "game/basic/entity.h"
+#include "game/basic/entity_id.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// number of shards of the local directory, must be a power of 2
+#define DIRECTORY_SHARD_COUNT 64
+
+namespace multiplayer_server
+{
+  // the backend may live in another process, all calls take batches so one call is one round trip
+  class DirectoryBackend
+  {
+  public:
+    // ids whose location changed or that are gone, cached locations of them are stale
+    using InvalidateHandler = std::function<void(const std::vector<EntityId> &ids)>;
+
+  public:
+    virtual ~DirectoryBackend() = default;
+
+    // add or move entities, moving an entity invalidates it in every subscriber
+    virtual void register_entities(const std::vector<EntityProxy> &proxies) = 0;
+    // remove entities still registered at the location of the proxy
+    // an entity moved to another process in the meantime is kept
+    virtual void unregister_entities(const std::vector<EntityProxy> &proxies) = 0;
+    // nullptr if the entity is not registered
+    virtual std::shared_ptr<const EntityProxy> lookup(EntityId id) = 0;
+
+    // handlers may be called from any thread
+    virtual void subscribe(InvalidateHandler handler) = 0;
+  };
+
+  // directory in this process, stand-in for a directory process and the backend of single process deployments
+  // entries are sharded by id, every shard has its own shared_mutex
+  class LocalDirectoryBackend : public DirectoryBackend
+  {
+  public:
+    LocalDirectoryBackend() = default;
+    virtual ~LocalDirectoryBackend() = default;
+
+    // non-copyable
+    LocalDirectoryBackend(const LocalDirectoryBackend &) = delete;
+    LocalDirectoryBackend &operator=(const LocalDirectoryBackend &) = delete;
+
+    virtual void register_entities(const std::vector<EntityProxy> &proxies) override;
+    virtual void unregister_entities(const std::vector<EntityProxy> &proxies) override;
+    virtual std::shared_ptr<const EntityProxy> lookup(EntityId id) override;
+    virtual void subscribe(InvalidateHandler handler) override;
+
+    size_t size() const;
+
+  private:
+    struct alignas(64) Shard
+    {
+      mutable std::shared_mutex mutex;
+      std::unordered_map<EntityId, std::shared_ptr<const EntityProxy>> entries;
+    };
+
+    static size_t get_shard_index(EntityId id) { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 32) & (DIRECTORY_SHARD_COUNT - 1); }
+    void notify(const std::vector<EntityId> &ids);
+
+  private:
+    std::array<Shard, DIRECTORY_SHARD_COUNT> shards_;
+
+    std::mutex subscriber_mutex_;
+    std::vector<InvalidateHandler> subscribers_;
+  };
+}
@@ -0,0 +1,107 @@
+#include "entity_directory.h"
+
+namespace multiplayer_server
+{
+  EntityDirectory &EntityDirectory::get_instance()
+  {
+    static EntityDirectory instance;
+    return instance;
+  }
+
+  void EntityDirectory::set_backend(std::shared_ptr<DirectoryBackend> backend)
+  {
+    backend_ = backend;
+    if (backend_)
+    {
+      backend_->subscribe([this](const std::vector<EntityId> &ids)
+                          { invalidate(ids); });
+    }
+  }
+
+  void EntityDirectory::register_entity(const EntityProxy &proxy)
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_calls_.insert_or_assign(proxy.get_entity_id(), PendingCall{proxy, true});
+  }
+
+  void EntityDirectory::unregister_entity(const EntityProxy &proxy)
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_calls_.insert_or_assign(proxy.get_entity_id(), PendingCall{proxy, false});
+  }
+
+  void EntityDirectory::flush()
+  {
+    std::unordered_map<EntityId, PendingCall> calls;
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex_);
+      calls.swap(pending_calls_);
+    }
+    if (calls.empty() || !backend_)
+    {
+      return;
+    }
+
+    std::vector<EntityProxy> registers;
+    std::vector<EntityProxy> unregisters;
+    for (auto &[id, call] : calls)
+    {
+      (call.is_register ? registers : unregisters).push_back(std::move(call.proxy));
+    }
+
+    if (!unregisters.empty())
+    {
+      backend_->unregister_entities(unregisters);
+    }
+    if (!registers.empty())
+    {
+      backend_->register_entities(registers);
+    }
+  }
+
+  std::shared_ptr<const EntityProxy> EntityDirectory::lookup(EntityId id)
+  {
+    CacheShard &shard = cache_[get_shard_index(id)];
+    uint64_t epoch = 0;
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto iter = shard.entries.find(id);
+      if (iter != shard.entries.end())
+      {
+        hit_count_.fetch_add(1, std::memory_order_relaxed);
+        return iter->second;
+      }
+      epoch = shard.epoch;
+    }
+
+    miss_count_.fetch_add(1, std::memory_order_relaxed);
+    if (!backend_)
+    {
+      return nullptr;
+    }
+
+    // misses are not cached, the entity may be registered soon
+    auto proxy = backend_->lookup(id);
+    if (proxy)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      // invalidated while reading the backend, the result may be stale
+      if (shard.epoch == epoch)
+      {
+        shard.entries.emplace(id, proxy);
+      }
+    }
+    return proxy;
+  }
+
+  void EntityDirectory::invalidate(const std::vector<EntityId> &ids)
+  {
+    for (EntityId id : ids)
+    {
+      CacheShard &shard = cache_[get_shard_index(id)];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      shard.entries.erase(id);
+      shard.epoch++;
+    }
+  }
+}
@@ -0,0 +1,86 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: find the process of any entity by id, through a local cache in front of the directory backend
+#pragma once
+
+#include "game/directory/directory_backend.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// number of shards of the location cache, must be a power of 2
+#define DIRECTORY_CACHE_SHARD_COUNT 64
+
+namespace multiplayer_server
+{
+  // lookup() reads through a sharded cache, a hit is one hash lookup under a shared lock
+  // the backend pushes invalidations when an entity moves or is gone, so cached locations never go stale for long
+  // register and unregister are queued and sent to the backend in one batch at the tick boundary
+  // entities of this process are found by EntityFactory first, the directory is for entities elsewhere
+  class EntityDirectory
+  {
+  public:
+    EntityDirectory() = default;
+    ~EntityDirectory() = default;
+
+    // non-copyable
+    EntityDirectory(const EntityDirectory &) = delete;
+    EntityDirectory &operator=(const EntityDirectory &) = delete;
+    EntityDirectory(EntityDirectory &&) = delete;
+    EntityDirectory &operator=(EntityDirectory &&) = delete;
+
+    static EntityDirectory &get_instance();
+
+    // set once before the world tick starts
+    void set_backend(std::shared_ptr<DirectoryBackend> backend);
+    const std::shared_ptr<DirectoryBackend> &get_backend() const { return backend_; }
+
+    // thread safe, the last call of an entity in a batch wins
+    void register_entity(const EntityProxy &proxy);
+    void unregister_entity(const EntityProxy &proxy);
+
+    // send queued calls to the backend, called at the tick boundary
+    void flush();
+
+    // thread safe, nullptr if the entity is not registered
+    std::shared_ptr<const EntityProxy> lookup(EntityId id);
+
+    // thread safe, drop cached locations
+    void invalidate(const std::vector<EntityId> &ids);
+
+    uint64_t get_hit_count() const { return hit_count_.load(std::memory_order_relaxed); }
+    uint64_t get_miss_count() const { return miss_count_.load(std::memory_order_relaxed); }
+
+  private:
+    struct alignas(64) CacheShard
+    {
+      mutable std::shared_mutex mutex;
+      std::unordered_map<EntityId, std::shared_ptr<const EntityProxy>> entries;
+      // changed by every invalidation, a fill started before it is dropped
+      uint64_t epoch = 0;
+    };
+
+    static size_t get_shard_index(EntityId id) { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 32) & (DIRECTORY_CACHE_SHARD_COUNT - 1); }
+
+    struct PendingCall
+    {
+      EntityProxy proxy;
+      bool is_register = true;
+    };
+
+  private:
+    std::shared_ptr<DirectoryBackend> backend_;
+    std::array<CacheShard, DIRECTORY_CACHE_SHARD_COUNT> cache_;
+
+    std::mutex pending_mutex_;
+    std::unordered_map<EntityId, PendingCall> pending_calls_;
+
+    std::atomic<uint64_t> hit_count_{0};
+    std::atomic<uint64_t> miss_count_{0};
+  };
+}
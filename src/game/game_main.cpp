@@ -1,8 +1,17 @@
 #include "game_main.h"
 #include "game/basic/entity.h"
 #include "game/basic/entity_factory.h"
+#include "game/basic/entity_blueprint.h"
+#include "game/aoi/aoi_grid.h"
+#include "game/directory/entity_directory.h"
+#include "game/property/property_replicator.h"
 #include "game/service/login_service.h"
+#include "game/service/migration_service.h"
+#include "game/session/session_manager.h"
+#include "game/component/network_component.h"
+#include "network/connection.h"
 #include "config/game_config.h"
+#include <algorithm>
 #include <tuple>
 
 namespace multiplayer_server
@@ -12,6 +21,29 @@ namespace multiplayer_server
     // get config value, especially for ip and port
     game_config_ = std::make_unique<GameConfig>(config_file_path);
 
+    // create world tick before services, services may register tick handlers
+    auto tick_config = game_config_->get<TickConfig>(TICK_CONFIG_STR, std::make_shared<TickConfig>());
+    tick_scheduler_ = std::make_unique<TickScheduler>(tick_config->rate, tick_config->max_catch_up_ticks);
+    tick_scheduler_->set_stats_interval(tick_config->stats_interval);
+    // one slot of the world timer wheel is one tick
+    TimerWheel::get_instance().set_tick_interval(tick_scheduler_->get_tick_delta());
+    register_tick_handlers();
+
+    auto job_config = game_config_->get<JobSystemConfig>(JOB_CONFIG_STR, std::make_shared<JobSystemConfig>());
+    job_system_ = std::make_unique<JobSystem>(job_config->worker_count);
+    room_manager_ = std::make_unique<RoomManager>(*job_system_);
+
+    // set before any entity joins the grid
+    auto aoi_config = game_config_->get<AoiConfig>(AOI_CONFIG_STR, std::make_shared<AoiConfig>());
+    AoiGrid::get_instance().set_cell_size(static_cast<float>(aoi_config->cell_size));
+    AoiGrid::get_instance().set_default_view_radius(static_cast<float>(aoi_config->default_view_radius));
+
+    auto session_config = game_config_->get<SessionConfig>(SESSION_CONFIG_STR, std::make_shared<SessionConfig>());
+    SessionManager::get_instance().configure(*session_config);
+
+    // single process deployment, the directory lives in this process
+    EntityDirectory::get_instance().set_backend(std::make_shared<LocalDirectoryBackend>());
+
     auto ptr = game_config_->get_server_ip_port();
     if (!ptr)
     {
@@ -21,37 +53,65 @@ namespace multiplayer_server
     ip_ = ptr->ip;
     port_ = ptr->port;
     concurrency_ = ptr->concurrency;
+    idle_read_mode_ = ptr->idle_read_mode;
 
+    // entity ids carry the node id, set it before any entity is created
+    if (!EntityIdGenerator::set_node_id(ptr->node_id))
+    {
+      g_logger->error("GameMain: invalid node id {}", ptr->node_id);
+      throw std::runtime_error("GameMain: invalid node id " + std::to_string(ptr->node_id));
+    }
+
+    compile_entity_blueprints();
     preload_services_create_handler();
   }
 
+  void GameMain::compile_entity_blueprints()
+  {
+    // strings of the config are resolved here once, not on every login
+    if (auto login_config = game_config_->get<LoginEntityConfig>(LOGIN_CONFIG_STR))
+    {
+      EntityBlueprintCache::get_instance().add(EntityBlueprint::compile(LOGIN_BLUEPRINT_NAME, login_config->entity_class_name,
+                                                                        login_config->entity_type, login_config->entity_components));
+    }
+  }
+
   GameMain::~GameMain()
   {
   }
 
-  void GameMain::init_game_service(const std::string &name)
+  void GameMain::init_game_service(const GameServiceConfig &config)
   {
+    const std::string &name = config.service_name;
     if (name.empty())
     {
       return;
     }
 
-    if (game_services_create_handler_.find(name) != game_services_create_handler_.end())
-    {
-      // create a game service
-      std::shared_ptr<ServerEntity> game_service = game_services_create_handler_[name]();
-      if (game_service)
-      {
-        // add to game services
-        record_game_service(name, game_service);
-      }
-    }
-    else
+    auto iter = game_services_create_handler_.find(name);
+    if (iter == game_services_create_handler_.end())
     {
       // log error
       g_logger->error("GameMain::init_game_service: can't find service create handler for {}", name);
       throw std::runtime_error("GameMain::init_game_service: can't find service create handler for " + name);
     }
+
+    ServiceGroup &group = service_locator_.get_group(iter->second.slot);
+    group.set_routing(ServiceGroup::get_routing_from_string(config.routing));
+    for (int i = 0; i < std::max(config.instances, 1); i++)
+    {
+      // create a game service
+      std::shared_ptr<ServerEntity> game_service = iter->second.create();
+      if (!game_service)
+      {
+        continue;
+      }
+
+      // add to game services
+      group.add(game_service);
+      record_game_service(name, game_service);
+    }
+    g_logger->info("GameMain::init_game_service: {} instances of {}, routing {}", group.get_instances().size(), name, config.routing);
   }
 
   std::shared_ptr<ServerEntity> GameMain::get_game_service(const std::string &service_name)
@@ -65,7 +125,7 @@ namespace multiplayer_server
   }
 
   // get game service by id
-  std::shared_ptr<ServerEntity> GameMain::get_game_service(const std::string &service_name, const std::string &id)
+  std::shared_ptr<ServerEntity> GameMain::get_game_service(const std::string &service_name, EntityId id)
   {
     auto iter = game_services_.find(service_name);
     if (iter != game_services_.end())
@@ -111,34 +171,167 @@ namespace multiplayer_server
 
     for (auto &service : *services)
     {
-      init_game_service(service.service_name);
+      init_game_service(service);
     }
   }
 
   bool GameMain::on_client_connected(std::shared_ptr<Connection> connection)
   {
-    // get login service
-    std::shared_ptr<LoginService> login_service = std::dynamic_pointer_cast<LoginService>(get_game_service("LoginService"));
-    if (login_service)
+    // services are only created before the world tick starts, so it's safe to find it on io threads
+    if (!service_locator_.has<LoginService>())
+    {
+      return false;
+    }
+
+    // the connection and all its messages are handed to the world tick, game logic never runs on io threads
+    IoBridge::get_instance().attach(connection);
+    return true;
+  }
+
+  void GameMain::start_io_bridge(std::shared_ptr<boost::asio::io_context> io_context)
+  {
+    IoBridge::get_instance().start(io_context, concurrency_);
+  }
+
+  void GameMain::handle_io_event(IoEvent &event)
+  {
+    switch (event.type)
+    {
+    case IoEventType::kConnected:
+    {
+      // the same connection id always picks the same instance with consistent hash
+      LoginService *login_service = service_locator_.route<LoginService>(event.connection_id);
+      if (!login_service || !login_service->on_client_connected(event.connection))
+      {
+        event.connection->close();
+      }
+      break;
+    }
+    case IoEventType::kMessage:
+    {
+      NetworkComponent *network_component = NetworkComponent::find_by_connection(event.connection_id);
+      Entity *entity = network_component ? network_component->get_owner() : nullptr;
+      if (!entity)
+      {
+        break;
+      }
+
+      // a reconnecting client asks for its old entity by the first message of the new connection
+      // later on the connection belongs to an entity already, the message is dropped
+      if (event.message_id == SESSION_RESUME_MESSAGE_ID)
+      {
+        if (event.sequence == IoEvent::kFirstMessageSequence)
+        {
+          SessionManager::get_instance().resume(event.data.data(), event.data.size(), *network_component);
+        }
+        break;
+      }
+
+      // entities handle client messages from their mailbox, in the same tick after the io bridge is drained
+      if (migration_service_)
+      {
+        migration_service_->route_message(entity->get_id(), event.message_id, event.data.data(), event.data.size());
+      }
+      else
+      {
+        entity_factory_.post_message(entity->get_id(), event.message_id, kInvalidEntityId, event.data.data(), event.data.size());
+      }
+      break;
+    }
+    case IoEventType::kDisconnected:
+    {
+      NetworkComponent *network_component = NetworkComponent::find_by_connection(event.connection_id);
+      Entity *entity = network_component ? network_component->get_owner() : nullptr;
+      if (!entity)
+      {
+        break;
+      }
+
+      // a resumable session keeps the entity for the grace period, handlers run when the period ends
+      if (SessionManager::get_instance().suspend(*network_component))
+      {
+        break;
+      }
+
+      // handlers see the entity alive, then the connection, components and directory entry
+      // are released with all entities destroyed in this tick at the boundary
+      network_component->handle_disconnect();
+      entity_factory_.destroy_entity(entity->get_id());
+      break;
+    }
+    }
+  }
+
+  void GameMain::run_game_loop()
+  {
+    // services are created before the world tick starts
+    migration_service_ = service_locator_.get<MigrationService>();
+
+    tick_scheduler_->run();
+
+    // links post to the world tick, stop them while it still exists
+    if (migration_service_)
     {
-      return login_service->on_client_connected(connection);
+      migration_service_->stop();
     }
-    return false;
+  }
+
+  void GameMain::register_tick_handlers()
+  {
+    // connection events and client messages handed over by io threads since the last tick
+    tick_scheduler_->register_phase_handler(TickPhase::kInput, "IoBridge", [this]([[maybe_unused]] float dt)
+                                            { IoBridge::get_instance().drain_inbound([this](IoEvent &event)
+                                                                                     { handle_io_event(event); }); });
+    // after posted tasks, messages sent to entities from any thread are handled on the tick thread
+    tick_scheduler_->register_phase_handler(TickPhase::kInput, "EntityMailbox", [this]([[maybe_unused]] float dt)
+                                            { entity_factory_.dispatch_messages(MAILBOX_DRAIN_BATCH); });
+    // timers due in this tick fire in one batch before entities update
+    tick_scheduler_->register_phase_handler(TickPhase::kSimulate, "TimerWheel", []([[maybe_unused]] float dt)
+                                            { TimerWheel::get_instance().advance(); });
+    tick_scheduler_->register_phase_handler(TickPhase::kSimulate, "EntityFactory", [this](float dt)
+                                            { entity_factory_.update_entities(dt); });
+    // rooms with due ticks run in parallel on the workers, the world tick waits for them
+    tick_scheduler_->register_phase_handler(TickPhase::kSimulate, "RoomManager", [this](float dt)
+                                            { room_manager_->update(dt); });
+    // entities moved during simulate, aoi events of the whole tick are produced in one batch
+    tick_scheduler_->register_phase_handler(TickPhase::kReplicate, "AoiGrid", []([[maybe_unused]] float dt)
+                                            { AoiGrid::get_instance().update(); });
+    // after aoi, new observers get full state and the rest get deltas of this tick
+    tick_scheduler_->register_phase_handler(TickPhase::kReplicate, "PropertyReplicator", []([[maybe_unused]] float dt)
+                                            { PropertyReplicator::get_instance().replicate(); });
+    // wake io threads once to send everything queued in this tick
+    tick_scheduler_->register_phase_handler(TickPhase::kFlush, "IoBridge", []([[maybe_unused]] float dt)
+                                            { IoBridge::get_instance().flush_outbound(); });
+    tick_scheduler_->register_tick_boundary_handler("EntityFactory", [this]()
+                                                    { entity_factory_.flush_destroyed_entities(); });
+    // after destroyed entities queued their unregister, the directory gets all changes of a tick in one batch
+    tick_scheduler_->register_tick_boundary_handler("EntityDirectory", []()
+                                                    { EntityDirectory::get_instance().flush(); });
   }
 
   // record game service
   void GameMain::record_game_service(const std::string& name, std::shared_ptr<ServerEntity> game_service)
   {
-    auto [iter, inserted] = game_services_.insert_or_assign(name, std::list<std::shared_ptr<ServerEntity>>());
-    iter->second.emplace_back(std::move(game_service));
+    game_services_[name].emplace_back(std::move(game_service));
   }
 
   // preload services create handler
   void GameMain::preload_services_create_handler()
   {
-    game_services_create_handler_["LoginService"] = [this]() {
+    game_services_create_handler_["LoginService"] = {LoginService::kServiceSlot, [this]() {
       std::shared_ptr<LoginService> login_service = entity_factory_.create_entity<LoginService>(ip_, port_, game_config_);
-      return std::dynamic_pointer_cast<ServerEntity>(login_service);
-    };
+      return std::static_pointer_cast<ServerEntity>(login_service);
+    }};
+    game_services_create_handler_["MigrationService"] = {MigrationService::kServiceSlot, [this]() -> std::shared_ptr<ServerEntity> {
+      // one migration port per process
+      if (service_locator_.has<MigrationService>())
+      {
+        g_logger->error("GameMain: only one MigrationService instance is allowed");
+        return nullptr;
+      }
+      std::shared_ptr<MigrationService> migration_service = entity_factory_.create_entity<MigrationService>(ip_, port_, game_config_, std::ref(*tick_scheduler_));
+      migration_service->start();
+      return std::static_pointer_cast<ServerEntity>(migration_service);
+    }};
   }
 }
\ No newline at end of file
@@ -4,6 +4,11 @@
 #pragma once
 
 #include "game/basic/entity_factory.h"
+#include "game/tick_scheduler.h"
+#include "game/job/job_system.h"
+#include "game/room/room_manager.h"
+#include "game/io/io_bridge.h"
+#include "game/service/service_locator.h"
 #include <map>
 #include <string>
 #include <memory>
@@ -17,6 +22,8 @@ namespace multiplayer_server
   class ServerEntity;
   class Connection;
   class GameConfig;
+  class MigrationService;
+  struct GameServiceConfig;
 
   // global game interfaces and data
   class GameMain
@@ -37,19 +44,36 @@ namespace multiplayer_server
 
     // get game service
     std::shared_ptr<ServerEntity> get_game_service(const std::string &service_name);
-    std::shared_ptr<ServerEntity> get_game_service(const std::string &service_name, const std::string &id);
+    std::shared_ptr<ServerEntity> get_game_service(const std::string &service_name, EntityId id);
     std::shared_ptr<ServerEntity> get_local_game_service(const std::string &service_name);
+    // typed lookup and routing of local services, use it instead of names on hot paths
+    ServiceLocator &get_service_locator() { return service_locator_; }
 
     // In spide of the fact that there are varities of connection type
     // game only need to know the connection is connected and use the abstract connection type
+    // called by io threads, the connection is handed to the world tick
     bool on_client_connected(std::shared_ptr<Connection> connection);
 
+    // outbound messages of the world tick are sent by the io threads of the server
+    void start_io_bridge(std::shared_ptr<boost::asio::io_context> io_context);
+
+    // run the world tick on the calling thread until stop_game_loop() is called
+    void run_game_loop();
+    // thread safe and async signal safe
+    void stop_game_loop() { tick_scheduler_->stop(); }
+    TickScheduler &get_tick_scheduler() { return *tick_scheduler_; }
+    // game systems spread work across cores through it, don't create threads
+    JobSystem &get_job_system() { return *job_system_; }
+    // small isolated simulations, each with its own entities, tick rate and timers, run on the job system
+    RoomManager &get_room_manager() { return *room_manager_; }
+
     // return game ip and port
     std::string get_ip() const { return ip_; }
     int get_port() const { return port_; }
     // return ip and port as tuple
     std::tuple<std::string, int> get_ip_port() const { return std::make_tuple(ip_, port_); }
     int get_concurrency() const { return concurrency_; }
+    bool get_idle_read_mode() const { return idle_read_mode_; }
 
     // get game config shared_ptr
     std::shared_ptr<GameConfig> get_game_config() const { return game_config_; }
@@ -58,8 +82,17 @@ namespace multiplayer_server
     // preload services create handler
     void preload_services_create_handler();
 
-    // init a game service
-    void init_game_service(const std::string &name);
+    // build blueprints of entities from config, services find them when they are created
+    void compile_entity_blueprints();
+
+    // register game systems into tick phases
+    void register_tick_handlers();
+
+    // handle a connection event handed over by io threads, called by the tick thread
+    void handle_io_event(IoEvent &event);
+
+    // init all instances of a game service
+    void init_game_service(const GameServiceConfig &config);
 
     // record a game service
     void record_game_service(const std::string &name, std::shared_ptr<ServerEntity> service);
@@ -69,6 +102,7 @@ namespace multiplayer_server
     std::string ip_ = "127.0.0.1";
     int port_ = 8080;
     int concurrency_ = 2;
+    bool idle_read_mode_ = false;
 
     // game config file parser
     std::shared_ptr<GameConfig> game_config_;
@@ -76,10 +110,27 @@ namespace multiplayer_server
     // game entity factory
     EntityFactory& entity_factory_ = EntityFactory::get_instance();
 
+    // world tick, all game logic runs on its thread
+    std::unique_ptr<TickScheduler> tick_scheduler_;
+    // workers shared by all game systems
+    std::unique_ptr<JobSystem> job_system_;
+    // rooms run on the workers of job_system_, declared after it so it's destructed first
+    std::unique_ptr<RoomManager> room_manager_;
+
     // save all services, maybe not in a same process
     std::map<std::string, std::list<std::shared_ptr<ServerEntity>>> game_services_;
-
+    // local services by slot
+    ServiceLocator service_locator_;
+    // client messages go through it when it exists, so they follow entities moving between processes
+    MigrationService *migration_service_ = nullptr;
+
+    // create one instance of a service, the instance is put into the slot of its class
+    struct ServiceCreator
+    {
+      ServiceSlot slot;
+      std::function<std::shared_ptr<ServerEntity>()> create;
+    };
     // save all services create handler
-    std::map<std::string, std::function<std::shared_ptr<ServerEntity>()>> game_services_create_handler_;
+    std::map<std::string, ServiceCreator> game_services_create_handler_;
   };
 }
\ No newline at end of file
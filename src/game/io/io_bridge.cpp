@@ -0,0 +1,306 @@
+#include "io_bridge.h"
+#include "network/connection.h"
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  namespace
+  {
+    // set by the disconnect, events after it are dropped so the disconnect is always the last event
+    constexpr uint64_t kDisconnectedBit = 1ULL << 63;
+
+    // sequence of the next event of a connection, shared by its callbacks
+    struct ConnectionSequence
+    {
+      std::atomic<uint64_t> value{0};
+    };
+
+    // ring of the calling io thread
+    thread_local void *t_inbox = nullptr;
+  }
+
+  IoBridge::IoBridge()
+  {
+    for (auto &inbox : inboxes_)
+    {
+      inbox.store(nullptr, std::memory_order_relaxed);
+    }
+    logger_ = g_logger_manager.create_logger("IoBridge", LoggerLevel::Debug, "log/IoBridge.log");
+  }
+
+  IoBridge::~IoBridge()
+  {
+    for (auto &inbox : inboxes_)
+    {
+      delete inbox.load(std::memory_order_relaxed);
+    }
+  }
+
+  IoBridge &IoBridge::get_instance()
+  {
+    static IoBridge instance;
+    return instance;
+  }
+
+  void IoBridge::start(std::shared_ptr<boost::asio::io_context> io_context, int io_thread_count)
+  {
+    io_context_ = io_context;
+    outboxes_.clear();
+    for (int i = 0; i < std::max(io_thread_count, 1); i++)
+    {
+      outboxes_.push_back(std::make_unique<Outbox>());
+    }
+    logger_->info("io bridge started, {} outboxes", outboxes_.size());
+  }
+
+  void IoBridge::reset()
+  {
+    IoEvent event;
+    size_t count = inbox_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+      Inbox *inbox = inboxes_[i].load(std::memory_order_acquire);
+      while (inbox->ring.try_pop(event))
+      {
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      overflow_events_.clear();
+      has_overflow_.store(false, std::memory_order_relaxed);
+    }
+    connection_orders_.clear();
+
+    outboxes_.clear();
+    io_context_.reset();
+  }
+
+  void IoBridge::attach(std::shared_ptr<Connection> connection)
+  {
+    uint64_t connection_id = connection->get_connection_id();
+    auto sequence = std::make_shared<ConnectionSequence>();
+
+    IoEvent connected;
+    connected.type = IoEventType::kConnected;
+    connected.connection_id = connection_id;
+    connected.sequence = sequence->value.fetch_add(1, std::memory_order_relaxed);
+    connected.connection = connection;
+    push_inbound(std::move(connected));
+
+    // callbacks don't hold the connection, the connection owns them
+    connection->set_receive_callback([this, connection_id, sequence](uint16_t message_id, const void *data, size_t size)
+                                     {
+                                       uint64_t value = sequence->value.fetch_add(1, std::memory_order_relaxed);
+                                       if (value & kDisconnectedBit)
+                                       {
+                                         return;
+                                       }
+
+                                       IoEvent event;
+                                       event.type = IoEventType::kMessage;
+                                       event.connection_id = connection_id;
+                                       event.sequence = value;
+                                       event.message_id = message_id;
+                                       event.data.assign(static_cast<const char *>(data), static_cast<const char *>(data) + size);
+                                       push_inbound(std::move(event)); });
+
+    // close() may call it from the tick thread, and again from an io thread
+    connection->set_disconnected_callback([this, connection_id, sequence]()
+                                          {
+                                            uint64_t value = sequence->value.fetch_or(kDisconnectedBit, std::memory_order_relaxed);
+                                            if (value & kDisconnectedBit)
+                                            {
+                                              return;
+                                            }
+
+                                            IoEvent event;
+                                            event.type = IoEventType::kDisconnected;
+                                            event.connection_id = connection_id;
+                                            event.sequence = value;
+                                            push_inbound(std::move(event)); });
+  }
+
+  IoBridge::Inbox *IoBridge::get_thread_inbox()
+  {
+    if (t_inbox)
+    {
+      return static_cast<Inbox *>(t_inbox);
+    }
+
+    std::lock_guard<std::mutex> lock(inbox_mutex_);
+    size_t count = inbox_count_.load(std::memory_order_relaxed);
+    if (count >= IO_BRIDGE_MAX_THREADS)
+    {
+      return nullptr;
+    }
+
+    Inbox *inbox = new Inbox();
+    inboxes_[count].store(inbox, std::memory_order_release);
+    inbox_count_.store(count + 1, std::memory_order_release);
+    t_inbox = inbox;
+    return inbox;
+  }
+
+  void IoBridge::push_inbound(IoEvent &&event)
+  {
+    Inbox *inbox = get_thread_inbox();
+    if (inbox && inbox->ring.try_push(std::move(event)))
+    {
+      return;
+    }
+
+    // sequences keep the order of the connection, so spilled events can be handed out in any order
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_events_.emplace_back(std::move(event));
+    has_overflow_.store(true, std::memory_order_release);
+    overflow_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void IoBridge::drain_inbound(const EventHandler &handler)
+  {
+    IoEvent event;
+    size_t count = inbox_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+      Inbox *inbox = inboxes_[i].load(std::memory_order_acquire);
+      // events pushed while draining wait for the next tick, so a busy io thread can't hold the tick
+      size_t capacity = inbox->ring.get_capacity();
+      for (size_t n = 0; n < capacity && inbox->ring.try_pop(event); n++)
+      {
+        draining_events_.emplace_back(std::move(event));
+      }
+    }
+
+    if (has_overflow_.load(std::memory_order_acquire))
+    {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      for (auto &overflow_event : overflow_events_)
+      {
+        draining_events_.emplace_back(std::move(overflow_event));
+      }
+      overflow_events_.clear();
+      has_overflow_.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto &draining_event : draining_events_)
+    {
+      dispatch_inbound(draining_event, handler);
+    }
+    draining_events_.clear();
+  }
+
+  void IoBridge::dispatch_inbound(IoEvent &event, const EventHandler &handler)
+  {
+    auto &order = connection_orders_[event.connection_id];
+    if (event.sequence != order.next_sequence)
+    {
+      // an earlier event is still in the ring of another io thread
+      order.held.emplace(event.sequence, std::move(event));
+      return;
+    }
+
+    uint64_t connection_id = event.connection_id;
+    bool disconnected = event.type == IoEventType::kDisconnected;
+    handler(event);
+    order.next_sequence++;
+
+    while (!disconnected && !order.held.empty() && order.held.begin()->first == order.next_sequence)
+    {
+      IoEvent held = std::move(order.held.begin()->second);
+      order.held.erase(order.held.begin());
+      disconnected = held.type == IoEventType::kDisconnected;
+      handler(held);
+      order.next_sequence++;
+    }
+
+    // the disconnect is the last event of a connection
+    if (disconnected)
+    {
+      connection_orders_.erase(connection_id);
+    }
+  }
+
+  bool IoBridge::send(const std::shared_ptr<Connection> &connection, uint16_t message_id, const void *data, size_t size, SendLane lane)
+  {
+    if (!connection)
+    {
+      return false;
+    }
+    if (!io_context_ || outboxes_.empty())
+    {
+      return connection->async_send(message_id, data, size, lane);
+    }
+
+    OutboundMessage message;
+    message.connection = connection;
+    message.message_id = message_id;
+    message.lane = lane;
+    message.payload.assign(static_cast<const char *>(data), static_cast<const char *>(data) + size);
+
+    // messages of one connection always use the same outbox, so they keep their order
+    // outboxes only spread the work of the tick thread, any io thread may drain one
+    Outbox &outbox = *outboxes_[connection->get_connection_id() % outboxes_.size()];
+    outbox.pending = true;
+    if (!outbox.backlog.empty() || !outbox.ring.try_push(std::move(message)))
+    {
+      outbox.backlog.emplace_back(std::move(message));
+    }
+    return true;
+  }
+
+  void IoBridge::flush_outbound()
+  {
+    for (auto &outbox : outboxes_)
+    {
+      if (!outbox->pending)
+      {
+        continue;
+      }
+
+      // the ring has room again once the last send task finished
+      size_t moved = 0;
+      while (moved < outbox->backlog.size() && outbox->ring.try_push(std::move(outbox->backlog[moved])))
+      {
+        moved++;
+      }
+      outbox->backlog.erase(outbox->backlog.begin(), outbox->backlog.begin() + moved);
+      outbox->pending = !outbox->backlog.empty();
+
+      // a running task may miss messages pushed at its end, they are sent by the task of the next flush
+      if (outbox->scheduled.exchange(true, std::memory_order_acq_rel))
+      {
+        outbox->pending = true;
+        continue;
+      }
+
+      Outbox *target = outbox.get();
+      boost::asio::post(*io_context_, [this, target]()
+                        { send_outbox(target); });
+    }
+  }
+
+  // any io thread drains the ring, the messages of every connection are sent by one task on its strand
+  void IoBridge::send_outbox(Outbox *outbox)
+  {
+    std::unordered_map<Connection *, std::vector<OutboundMessage>> batches;
+    OutboundMessage message;
+    while (outbox->ring.try_pop(message))
+    {
+      batches[message.connection.get()].emplace_back(std::move(message));
+    }
+
+    for (auto &[raw_connection, messages] : batches)
+    {
+      std::shared_ptr<Connection> connection = messages.front().connection;
+      connection->post([connection, messages = std::move(messages)]()
+                       {
+        for (auto &message : messages)
+        {
+          connection->async_send(message.message_id, message.payload.data(), message.payload.size(), message.lane);
+        } });
+    }
+
+    // tasks of the next flush are posted after these, so messages of a connection keep their order
+    outbox->scheduled.store(false, std::memory_order_release);
+  }
+}
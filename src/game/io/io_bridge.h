@@ -0,0 +1,157 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: hand connection events from io threads to the tick thread, and outbound messages back, through lock free rings
+#pragma once
+
+#include "game/basic/spsc_ring.h"
+#include "network/message_frame.h"
+#include "log/logger.h"
+#include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// events one io thread can hand over before it spills into the shared overflow list
+#define IO_BRIDGE_INBOUND_RING_SIZE 4096
+// outbound messages of one outbox per flush before they wait in the backlog
+#define IO_BRIDGE_OUTBOUND_RING_SIZE 4096
+// max io threads with their own ring, other threads use the overflow list
+#define IO_BRIDGE_MAX_THREADS 64
+
+namespace multiplayer_server
+{
+  class Connection;
+
+  enum class IoEventType : uint8_t
+  {
+    kConnected,
+    kMessage,
+    kDisconnected,
+  };
+
+  struct IoEvent
+  {
+    IoEventType type = IoEventType::kMessage;
+    uint64_t connection_id = 0;
+    // order of the event in its connection, a connection may hop between io threads
+    // kConnected is 0, the first message of the connection is kFirstMessageSequence
+    static constexpr uint64_t kFirstMessageSequence = 1;
+    uint64_t sequence = 0;
+    uint16_t message_id = 0;
+    // only set by kConnected
+    std::shared_ptr<Connection> connection;
+    std::vector<char> data;
+  };
+
+  // inbound: every io thread pushes into its own single producer ring, the tick thread drains all rings once per tick
+  // events of one connection carry a sequence and are handed out in order even if they come from different io threads
+  // outbound: the tick thread pushes messages into as many rings as io threads, a connection always uses the same ring
+  // flush_outbound() posts one task per ring per tick instead of one per message, the task runs on any io thread
+  // and hands every connection its messages in one task on the strand of the connection
+  class IoBridge
+  {
+  public:
+    using EventHandler = std::function<void(IoEvent &event)>;
+
+  public:
+    IoBridge();
+    ~IoBridge();
+
+    // non-copyable
+    IoBridge(const IoBridge &) = delete;
+    IoBridge &operator=(const IoBridge &) = delete;
+    IoBridge(IoBridge &&) = delete;
+    IoBridge &operator=(IoBridge &&) = delete;
+
+    static IoBridge &get_instance();
+
+    // outbound messages are sent by the io threads of io_context, call it before the world tick starts
+    // without an io context send() calls async_send at once
+    void start(std::shared_ptr<boost::asio::io_context> io_context, int io_thread_count);
+    // drop everything left, call it after io threads and the world tick are stopped
+    void reset();
+
+    // called by the io thread that accepts the connection, before the connection starts receiving
+    // hand the connection over and route its messages and disconnect through the bridge
+    void attach(std::shared_ptr<Connection> connection);
+
+    // handle events handed over so far, called by the tick thread
+    void drain_inbound(const EventHandler &handler);
+
+    // queue a message to the connection, called by the tick thread
+    bool send(const std::shared_ptr<Connection> &connection, uint16_t message_id, const void *data, size_t size, SendLane lane = SendLane::kRealtime);
+    // wake io threads to send messages queued in this tick, called by the tick thread
+    void flush_outbound();
+
+    uint64_t get_overflow_count() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Inbox
+    {
+      Inbox() : ring(IO_BRIDGE_INBOUND_RING_SIZE) {}
+      SpscRing<IoEvent> ring;
+    };
+
+    struct OutboundMessage
+    {
+      std::shared_ptr<Connection> connection;
+      uint16_t message_id = 0;
+      SendLane lane = SendLane::kRealtime;
+      std::vector<char> payload;
+    };
+
+    struct Outbox
+    {
+      Outbox() : ring(IO_BRIDGE_OUTBOUND_RING_SIZE) {}
+      SpscRing<OutboundMessage> ring;
+      // messages that didn't fit the ring, they go first in the next flush
+      std::vector<OutboundMessage> backlog;
+      // pushed since the last flush
+      bool pending = false;
+      // a send task is posted to the io context and not finished, only one task drains the ring
+      std::atomic<bool> scheduled{false};
+    };
+
+    // events of one connection that came too early
+    struct ConnectionOrder
+    {
+      uint64_t next_sequence = 0;
+      std::map<uint64_t, IoEvent> held;
+    };
+
+    // called by io threads
+    void push_inbound(IoEvent &&event);
+    Inbox *get_thread_inbox();
+    void dispatch_inbound(IoEvent &event, const EventHandler &handler);
+
+    // called by an io thread
+    void send_outbox(Outbox *outbox);
+
+  private:
+    // inboxes are created by io threads on their first event and live until the bridge is destructed
+    std::array<std::atomic<Inbox *>, IO_BRIDGE_MAX_THREADS> inboxes_;
+    std::atomic<size_t> inbox_count_{0};
+    std::mutex inbox_mutex_;
+
+    // events of threads without a ring or with a full ring
+    std::mutex overflow_mutex_;
+    std::vector<IoEvent> overflow_events_;
+    std::atomic<bool> has_overflow_{false};
+    std::atomic<uint64_t> overflow_count_{0};
+
+    // tick thread only
+    std::vector<IoEvent> draining_events_;
+    std::unordered_map<uint64_t, ConnectionOrder> connection_orders_;
+
+    std::shared_ptr<boost::asio::io_context> io_context_;
+    std::vector<std::unique_ptr<Outbox>> outboxes_;
+
+    std::shared_ptr<LoggerImp> logger_;
+  };
+}
@@ -0,0 +1,224 @@
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+
+namespace multiplayer_server
+{
+  // identify the worker of the calling thread
+  static thread_local const JobSystem *t_job_system = nullptr;
+  static thread_local size_t t_worker_index = 0;
+
+  JobSystem::JobSystem(int worker_count)
+  {
+    logger_ = g_logger_manager.create_logger("JobSystem", LoggerLevel::Debug, "log/JobSystem.log");
+
+    if (worker_count <= 0)
+    {
+      // the calling thread executes jobs while waiting, leave one core for it
+      worker_count = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    }
+
+    for (int i = 0; i <= worker_count; i++)
+    {
+      queues_.emplace_back(std::make_unique<JobQueue>());
+    }
+
+    for (int i = 0; i < worker_count; i++)
+    {
+      workers_.emplace_back(&JobSystem::worker_loop, this, static_cast<size_t>(i));
+    }
+    logger_->info("job system start {} workers", worker_count);
+  }
+
+  JobSystem::~JobSystem()
+  {
+    stop_.store(true, std::memory_order_relaxed);
+    idle_condition_.notify_all();
+    for (auto &worker : workers_)
+    {
+      if (worker.joinable())
+      {
+        worker.join();
+      }
+    }
+  }
+
+  JobHandle JobSystem::create_job(Job::JobFunction function, const JobHandle &parent)
+  {
+    if (parent)
+    {
+      parent->unfinished_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::make_shared<Job>(std::move(function), parent);
+  }
+
+  void JobSystem::run(const JobHandle &job)
+  {
+    auto &queue = *queues_[get_queue_index()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(job);
+    }
+
+    pending_count_.fetch_add(1, std::memory_order_release);
+    idle_condition_.notify_one();
+  }
+
+  void JobSystem::wait(const JobHandle &job)
+  {
+    size_t queue_index = get_queue_index();
+    while (!job->is_finished())
+    {
+      if (auto other = get_job(queue_index))
+      {
+        execute(other);
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void JobSystem::run_and_wait(Job::JobFunction function)
+  {
+    auto job = create_job(std::move(function));
+    run(job);
+    wait(job);
+  }
+
+  void JobSystem::parallel_for(size_t begin, size_t end, size_t grain_size, const std::function<void(size_t, size_t)> &function)
+  {
+    if (begin >= end)
+    {
+      return;
+    }
+
+    grain_size = std::max<size_t>(grain_size, 1);
+    // small range, not worth a job
+    if (end - begin <= grain_size)
+    {
+      function(begin, end);
+      return;
+    }
+
+    // root job does nothing, it finishes after all ranges finished
+    auto root = create_job([]() {});
+    for (size_t range_begin = begin; range_begin < end; range_begin += grain_size)
+    {
+      size_t range_end = std::min(range_begin + grain_size, end);
+      run(create_job([&function, range_begin, range_end]()
+                     { function(range_begin, range_end); },
+                     root));
+    }
+    run(root);
+    wait(root);
+  }
+
+  void JobSystem::worker_loop(size_t worker_index)
+  {
+    t_job_system = this;
+    t_worker_index = worker_index;
+
+    while (!stop_.load(std::memory_order_relaxed))
+    {
+      if (auto job = get_job(worker_index))
+      {
+        execute(job);
+        continue;
+      }
+
+      // nothing to do, sleep until a job is pushed
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      idle_condition_.wait_for(lock, std::chrono::milliseconds(JOB_WORKER_IDLE_WAIT_MS), [this]()
+                               { return stop_.load(std::memory_order_relaxed) || pending_count_.load(std::memory_order_acquire) > 0; });
+    }
+
+    t_job_system = nullptr;
+  }
+
+  size_t JobSystem::get_queue_index() const
+  {
+    if (t_job_system == this)
+    {
+      return t_worker_index;
+    }
+    return workers_.size();
+  }
+
+  JobHandle JobSystem::get_job(size_t queue_index)
+  {
+    if (pending_count_.load(std::memory_order_acquire) <= 0)
+    {
+      return nullptr;
+    }
+
+    if (auto job = pop_job(queue_index))
+    {
+      return job;
+    }
+    return steal_job(queue_index);
+  }
+
+  JobHandle JobSystem::pop_job(size_t queue_index)
+  {
+    auto &queue = *queues_[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+    {
+      return nullptr;
+    }
+
+    // newest job first, its data is still in cache
+    JobHandle job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    pending_count_.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+  }
+
+  JobHandle JobSystem::steal_job(size_t queue_index)
+  {
+    // start from the next deque, so thieves spread over victims
+    for (size_t i = 1; i < queues_.size(); i++)
+    {
+      auto &queue = *queues_[(queue_index + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.jobs.empty())
+      {
+        continue;
+      }
+
+      JobHandle job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      pending_count_.fetch_sub(1, std::memory_order_relaxed);
+      stolen_count_.fetch_add(1, std::memory_order_relaxed);
+      return job;
+    }
+    return nullptr;
+  }
+
+  void JobSystem::execute(const JobHandle &job)
+  {
+    if (job->function_)
+    {
+      job->function_();
+    }
+    finish(job.get());
+  }
+
+  void JobSystem::finish(Job *job)
+  {
+    if (job->unfinished_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+      return;
+    }
+
+    // release captures early, waiters may hold the handle for a while
+    job->function_ = nullptr;
+    if (job->parent_)
+    {
+      auto parent = std::move(job->parent_);
+      finish(parent.get());
+    }
+  }
+}
@@ -0,0 +1,139 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: work stealing job system, spread game work across cores without creating threads
+#pragma once
+
+#include "log/logger.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// default grain size of parallel_for, number of items in one job
+#define DEFAULT_PARALLEL_FOR_GRAIN_SIZE 64
+// milliseconds an idle worker sleeps before looking for jobs again
+#define JOB_WORKER_IDLE_WAIT_MS 1
+
+namespace multiplayer_server
+{
+  class JobSystem;
+
+  // a job finishes when its function and all its children finished
+  class Job
+  {
+  public:
+    using JobFunction = std::function<void()>;
+
+  public:
+    Job(JobFunction function, std::shared_ptr<Job> parent) : function_(std::move(function)), parent_(std::move(parent)) {}
+
+    // non-copyable
+    Job(const Job &) = delete;
+    Job &operator=(const Job &) = delete;
+    Job(Job &&) = delete;
+    Job &operator=(Job &&) = delete;
+
+    bool is_finished() const { return unfinished_.load(std::memory_order_acquire) == 0; }
+
+  private:
+    friend class JobSystem;
+
+    JobFunction function_;
+    std::shared_ptr<Job> parent_;
+    // own function plus unfinished children
+    std::atomic<int> unfinished_{1};
+  };
+
+  using JobHandle = std::shared_ptr<Job>;
+
+  // every worker owns a deque, it pushes and pops jobs at the back
+  // idle workers steal from the front of other deques, so old and usually bigger jobs move between threads
+  // threads that are not workers share one extra deque and help executing jobs while they wait
+  class JobSystem
+  {
+  public:
+    // worker_count 0 means one worker per core except the calling thread
+    JobSystem(int worker_count = 0);
+    ~JobSystem();
+
+    // non-copyable
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+    JobSystem(JobSystem &&) = delete;
+    JobSystem &operator=(JobSystem &&) = delete;
+
+  public:
+    // create a job, it doesn't run until run() is called
+    // a child must be created before its parent is run, the parent finishes after all its children
+    JobHandle create_job(Job::JobFunction function, const JobHandle &parent = nullptr);
+
+    // push the job into the deque of the calling thread
+    void run(const JobHandle &job);
+
+    // execute other jobs until the job finished
+    void wait(const JobHandle &job);
+
+    // create and run a job, then wait for it
+    void run_and_wait(Job::JobFunction function);
+
+    // split [begin, end) into jobs of grain_size items, function(begin, end) runs once per range
+    // return after all ranges finished, the calling thread executes jobs too
+    void parallel_for(size_t begin, size_t end, size_t grain_size, const std::function<void(size_t, size_t)> &function);
+
+    // parallel_for over all elements of a vector
+    template <typename T, typename Function>
+    void parallel_for_each(std::vector<T> &items, Function &&function, size_t grain_size = DEFAULT_PARALLEL_FOR_GRAIN_SIZE)
+    {
+      parallel_for(0, items.size(), grain_size, [&items, &function](size_t range_begin, size_t range_end)
+                   {
+                     for (size_t index = range_begin; index < range_end; index++)
+                     {
+                       function(items[index]);
+                     } });
+    }
+
+    int get_worker_count() const { return static_cast<int>(workers_.size()); }
+    // number of jobs executed by a thread other than the one that pushed them
+    uint64_t get_stolen_count() const { return stolen_count_.load(std::memory_order_relaxed); }
+
+  private:
+    struct JobQueue
+    {
+      std::mutex mutex;
+      std::deque<JobHandle> jobs;
+    };
+
+    void worker_loop(size_t worker_index);
+
+    // deque index of the calling thread
+    size_t get_queue_index() const;
+
+    // pop from own deque first, then steal from others
+    JobHandle get_job(size_t queue_index);
+    JobHandle pop_job(size_t queue_index);
+    JobHandle steal_job(size_t queue_index);
+
+    void execute(const JobHandle &job);
+    void finish(Job *job);
+
+  private:
+    // workers_.size() + 1 deques, the last one is shared by all non-worker threads
+    std::vector<std::unique_ptr<JobQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<bool> stop_{false};
+    // jobs in all deques, idle workers sleep when it's 0
+    std::atomic<int64_t> pending_count_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_condition_;
+
+    std::atomic<uint64_t> stolen_count_{0};
+
+    std::shared_ptr<LoggerImp> logger_;
+  };
+}
@@ -0,0 +1,15 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: messages between two server processes moving an entity, all fields are little endian
+#pragma once
+
+// source -> target: uint64 entity id | uint8 server entity type | uint32 session generation, 0 without session | entity state written by Entity::save_state
+#define MIGRATION_TRANSFER_MESSAGE_ID 0x0200
+// target -> source: uint64 entity id | uint8 accepted | uint32 length + bytes game ip | int32 game port of the target, the source finds entities of the target by the address
+#define MIGRATION_ACK_MESSAGE_ID 0x0201
+// mirror -> entity: uint64 entity id | uint16 message id | payload, a message sent to the entity
+#define MIGRATION_FORWARD_MESSAGE_ID 0x0202
+// entity -> mirror: uint64 entity id | uint16 message id | uint8 lane | payload, a message sent to the client of the entity
+#define MIGRATION_RELAY_MESSAGE_ID 0x0203
+// source -> target: uint64 entity id, the entity is acked after the source took it back, the target drops it
+#define MIGRATION_CANCEL_MESSAGE_ID 0x0204
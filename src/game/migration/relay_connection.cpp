@@ -0,0 +1,38 @@
+#include "relay_connection.h"
+#include "migration_protocol.h"
+#include "game/property/property.h"
+
+namespace multiplayer_server
+{
+  RelayConnection::RelayConnection(EntityId entity_id, std::shared_ptr<Connection> link)
+    : Connection(link ? link->get_ip() : "", link ? link->get_port() : 0), entity_id_(entity_id), link_(link)
+  {
+    status_ = link_ ? ConnectionStatus::kConnected : ConnectionStatus::kClosed;
+  }
+
+  bool RelayConnection::send(uint16_t message_id, const void *data, size_t size)
+  {
+    return async_send(message_id, data, size, SendLane::kControl);
+  }
+
+  bool RelayConnection::async_send(uint16_t message_id, const void *data, size_t size, SendLane lane)
+  {
+    if (status_ != ConnectionStatus::kConnected)
+    {
+      return false;
+    }
+
+    PropertyWriter writer;
+    writer.write(entity_id_);
+    writer.write(message_id);
+    writer.write(static_cast<uint8_t>(lane));
+    writer.write_bytes(data, size);
+    return link_->async_send(MIGRATION_RELAY_MESSAGE_ID, writer.data(), writer.size(), lane);
+  }
+
+  // the link is shared by all entities moved between the two processes, keep it open
+  void RelayConnection::close()
+  {
+    status_ = ConnectionStatus::kClosed;
+  }
+}
@@ -0,0 +1,48 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: client connection of a migrated entity, messages go back to the mirror that holds the real connection
+#pragma once
+
+#include "network/connection.h"
+#include "game/basic/entity_id.h"
+#include <memory>
+
+namespace multiplayer_server
+{
+  // the client stays connected to the process the entity came from
+  // async_send wraps the message and sends it over the link between the two processes
+  // the mirror entity there sends it to the client
+  class RelayConnection : public Connection
+  {
+  public:
+    RelayConnection(EntityId entity_id, std::shared_ptr<Connection> link);
+    virtual ~RelayConnection() = default;
+
+    virtual ConnectionStatus get_status() const override { return status_; }
+
+    // the real connection is connected already
+    virtual bool connect() override { return true; }
+    virtual bool async_connect() override { return true; }
+    virtual void on_connected([[maybe_unused]] bool result) override {}
+
+    virtual bool send(uint16_t message_id, const void *data, size_t size) override;
+    virtual bool async_send(uint16_t message_id, const void *data, size_t size, SendLane lane = SendLane::kRealtime) override;
+
+    // messages from the client arrive as forward messages of the link, never read from here
+    virtual bool receive([[maybe_unused]] void *data, [[maybe_unused]] size_t size) override { return false; }
+    virtual void on_received([[maybe_unused]] const void *data, [[maybe_unused]] size_t size) override {}
+    virtual void start_receive() override {}
+
+    virtual void close() override;
+
+    virtual void set_keep_alive([[maybe_unused]] bool enable) override {}
+    virtual void heartbeat() override {}
+
+    const std::shared_ptr<Connection> &get_link() const { return link_; }
+
+  private:
+    EntityId entity_id_ = kInvalidEntityId;
+    // link to the process of the mirror
+    std::shared_ptr<Connection> link_;
+  };
+}
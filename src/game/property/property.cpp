@@ -0,0 +1,66 @@
+#include "property.h"
+#include "game/basic/entity.h"
+#include <stdexcept>
+
+namespace multiplayer_server
+{
+  uint32_t PropertySet::add(PropertyBase *property, const char *name, PropertyScope scope)
+  {
+    if (fields_.size() >= PROPERTY_MAX_FIELDS)
+    {
+      throw std::runtime_error(std::string("PropertySet::add: too many properties, can't add ") + name);
+    }
+
+    uint32_t index = static_cast<uint32_t>(fields_.size());
+    fields_.push_back(Field{property, name, scope});
+
+    uint64_t bit = 1ULL << index;
+    if (scope != PropertyScope::kServerOnly)
+    {
+      replicated_mask_ |= bit;
+    }
+    if (scope == PropertyScope::kAllObservers)
+    {
+      observer_mask_ |= bit;
+    }
+    return index;
+  }
+
+  void PropertySet::notify_owner()
+  {
+    if (owner_)
+    {
+      owner_->on_property_dirty();
+    }
+  }
+
+  void PropertySet::serialize(PropertyWriter &writer, uint64_t mask) const
+  {
+    writer.write(mask);
+    for (uint32_t index = 0; index < fields_.size(); index++)
+    {
+      if (mask & (1ULL << index))
+      {
+        fields_[index].property->serialize(writer);
+      }
+    }
+  }
+
+  bool PropertySet::deserialize(PropertyReader &reader)
+  {
+    uint64_t mask = 0;
+    if (!reader.read(mask) || (mask & ~get_all_mask()))
+    {
+      return false;
+    }
+
+    for (uint32_t index = 0; index < fields_.size(); index++)
+    {
+      if ((mask & (1ULL << index)) && !fields_[index].property->deserialize(reader))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
@@ -0,0 +1,352 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: replicated properties of entities and components, every field has a dirty bit
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// max fields of one property set, dirty bits of a set fit in one uint64_t
+#define PROPERTY_MAX_FIELDS 64
+
+namespace multiplayer_server
+{
+  class Entity;
+
+  // who can see a property
+  enum class PropertyScope : uint8_t
+  {
+    // never leaves the server
+    kServerOnly,
+    // only the client who owns the entity
+    kOwnerOnly,
+    // the owner and every observer of the entity
+    kAllObservers,
+  };
+
+  // append values to a byte buffer, little endian
+  class PropertyWriter
+  {
+  public:
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type write(T value)
+    {
+      auto bits = static_cast<typename std::make_unsigned<T>::type>(value);
+      for (size_t i = 0; i < sizeof(T); i++)
+      {
+        buffer_.push_back(static_cast<char>((bits >> (i * 8)) & 0xff));
+      }
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type write(T value)
+    {
+      write(static_cast<typename std::underlying_type<T>::type>(value));
+    }
+
+    void write(bool value) { buffer_.push_back(value ? 1 : 0); }
+    void write(float value) { write(bit_cast<uint32_t>(value)); }
+    void write(double value) { write(bit_cast<uint64_t>(value)); }
+
+    // uint32 size followed by the bytes
+    void write(const std::string &value)
+    {
+      write(static_cast<uint32_t>(value.size()));
+      write_bytes(value.data(), value.size());
+    }
+
+    void write_bytes(const void *data, size_t size)
+    {
+      const char *bytes = static_cast<const char *>(data);
+      buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    // overwrite one byte already written, used to fill counts known only after writing
+    void patch(size_t offset, uint8_t value) { buffer_[offset] = static_cast<char>(value); }
+    // drop everything after size
+    void truncate(size_t size) { buffer_.resize(size); }
+    void clear() { buffer_.clear(); }
+
+    const char *data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    bool empty() const { return buffer_.empty(); }
+
+  private:
+    template <typename To, typename From>
+    static To bit_cast(From value)
+    {
+      static_assert(sizeof(To) == sizeof(From), "size mismatch");
+      To result;
+      std::memcpy(&result, &value, sizeof(To));
+      return result;
+    }
+
+  private:
+    std::vector<char> buffer_;
+  };
+
+  // read values written by PropertyWriter, every read fails once the data runs out
+  class PropertyReader
+  {
+  public:
+    PropertyReader(const char *data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, bool>::type read(T &value)
+    {
+      if (!check(sizeof(T)))
+      {
+        return false;
+      }
+      typename std::make_unsigned<T>::type bits = 0;
+      for (size_t i = 0; i < sizeof(T); i++)
+      {
+        bits |= static_cast<typename std::make_unsigned<T>::type>(static_cast<uint8_t>(data_[offset_ + i])) << (i * 8);
+      }
+      offset_ += sizeof(T);
+      value = static_cast<T>(bits);
+      return true;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value, bool>::type read(T &value)
+    {
+      typename std::underlying_type<T>::type raw;
+      if (!read(raw))
+      {
+        return false;
+      }
+      value = static_cast<T>(raw);
+      return true;
+    }
+
+    bool read(bool &value)
+    {
+      uint8_t raw = 0;
+      if (!read(raw))
+      {
+        return false;
+      }
+      value = raw != 0;
+      return true;
+    }
+
+    bool read(float &value) { return read_bits<uint32_t>(value); }
+    bool read(double &value) { return read_bits<uint64_t>(value); }
+
+    bool read(std::string &value)
+    {
+      uint32_t size = 0;
+      if (!read(size) || !check(size))
+      {
+        return false;
+      }
+      value.assign(data_ + offset_, size);
+      offset_ += size;
+      return true;
+    }
+
+    // move forward without reading
+    bool skip(size_t size)
+    {
+      if (!check(size))
+      {
+        return false;
+      }
+      offset_ += size;
+      return true;
+    }
+
+    const char *current() const { return data_ + offset_; }
+    size_t remaining() const { return size_ - offset_; }
+    bool is_failed() const { return failed_; }
+
+  private:
+    bool check(size_t size)
+    {
+      if (failed_ || size > size_ - offset_)
+      {
+        failed_ = true;
+        return false;
+      }
+      return true;
+    }
+
+    template <typename Bits, typename T>
+    bool read_bits(T &value)
+    {
+      Bits bits = 0;
+      if (!read(bits))
+      {
+        return false;
+      }
+      std::memcpy(&value, &bits, sizeof(T));
+      return true;
+    }
+
+  private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    bool failed_ = false;
+  };
+
+  class PropertyBase
+  {
+  public:
+    PropertyBase() = default;
+    virtual ~PropertyBase() = default;
+
+    // non-copyable, the property set keeps its address
+    PropertyBase(const PropertyBase &) = delete;
+    PropertyBase &operator=(const PropertyBase &) = delete;
+
+    virtual void serialize(PropertyWriter &writer) const = 0;
+    virtual bool deserialize(PropertyReader &reader) = 0;
+  };
+
+  // properties of one entity or component in declaration order
+  // a set changes dirty bits only, the replicator collects them into the change mask once per tick
+  class PropertySet
+  {
+  public:
+    PropertySet() = default;
+    ~PropertySet() = default;
+
+    // non-copyable, properties keep a reference of their set
+    PropertySet(const PropertySet &) = delete;
+    PropertySet &operator=(const PropertySet &) = delete;
+
+    // return the field index, throw if the set is full
+    uint32_t add(PropertyBase *property, const char *name, PropertyScope scope);
+
+    // entity notified on the first dirty bit of a tick
+    void set_owner(Entity *owner) { owner_ = owner; }
+
+    void mark_dirty(uint32_t index)
+    {
+      uint64_t bit = 1ULL << index;
+      // server only fields are never sent, don't track them
+      if (!(replicated_mask_ & bit) || (dirty_mask_ & bit))
+      {
+        return;
+      }
+
+      bool first = dirty_mask_ == 0;
+      dirty_mask_ |= bit;
+      if (first)
+      {
+        notify_owner();
+      }
+    }
+
+    // move dirty bits into the change mask of this tick
+    void collect_changes()
+    {
+      changed_mask_ = dirty_mask_;
+      dirty_mask_ = 0;
+    }
+
+    uint64_t get_dirty_mask() const { return dirty_mask_; }
+    uint64_t get_changed_mask() const { return changed_mask_; }
+    // fields the owner or observers can see
+    uint64_t get_visible_mask(bool to_owner) const { return to_owner ? replicated_mask_ : observer_mask_; }
+
+    // write the mask and then the value of every field in the mask
+    void serialize(PropertyWriter &writer, uint64_t mask) const;
+    // read what serialize() writes, fields read are marked dirty
+    bool deserialize(PropertyReader &reader);
+
+    // mask of all fields, server only fields included
+    uint64_t get_all_mask() const { return fields_.size() >= 64 ? ~0ULL : (1ULL << fields_.size()) - 1; }
+
+    size_t size() const { return fields_.size(); }
+    const char *get_name(uint32_t index) const { return fields_[index].name; }
+    PropertyScope get_scope(uint32_t index) const { return fields_[index].scope; }
+
+  private:
+    void notify_owner();
+
+  private:
+    struct Field
+    {
+      PropertyBase *property;
+      const char *name;
+      PropertyScope scope;
+    };
+
+    std::vector<Field> fields_;
+    Entity *owner_ = nullptr;
+
+    // fields of owner only and all observers scope
+    uint64_t replicated_mask_ = 0;
+    // fields of all observers scope
+    uint64_t observer_mask_ = 0;
+
+    uint64_t dirty_mask_ = 0;
+    uint64_t changed_mask_ = 0;
+  };
+
+  // a typed field, declare it as a member of an entity or a component
+  //   Property<int32_t> hp_{properties_, "hp", PropertyScope::kAllObservers, 100};
+  template <typename T>
+  class Property : public PropertyBase
+  {
+  public:
+    Property(PropertySet &set, const char *name, PropertyScope scope, const T &value = T())
+      : set_(set), value_(value)
+    {
+      index_ = set_.add(this, name, scope);
+    }
+
+    const T &get() const { return value_; }
+    operator const T &() const { return value_; }
+
+    // mark dirty only if the value changes
+    void set(const T &value)
+    {
+      if (value_ == value)
+      {
+        return;
+      }
+      value_ = value;
+      set_.mark_dirty(index_);
+    }
+
+    Property &operator=(const T &value)
+    {
+      set(value);
+      return *this;
+    }
+
+    // change the value in place, always marks dirty
+    template <typename Fn>
+    void modify(Fn &&fn)
+    {
+      fn(value_);
+      set_.mark_dirty(index_);
+    }
+
+    uint32_t get_index() const { return index_; }
+
+    virtual void serialize(PropertyWriter &writer) const override { writer.write(value_); }
+
+    virtual bool deserialize(PropertyReader &reader) override
+    {
+      if (!reader.read(value_))
+      {
+        return false;
+      }
+      set_.mark_dirty(index_);
+      return true;
+    }
+
+  private:
+    PropertySet &set_;
+    uint32_t index_ = 0;
+    T value_;
+  };
+}
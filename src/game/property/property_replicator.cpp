@@ -0,0 +1,165 @@
+#include "property_replicator.h"
+#include "game/aoi/aoi_grid.h"
+#include "game/basic/entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/component/aoi_component.h"
+#include "game/component/network_component.h"
+
+namespace multiplayer_server
+{
+  PropertyReplicator &PropertyReplicator::get_instance()
+  {
+    static PropertyReplicator instance;
+    return instance;
+  }
+
+  PropertyReplicator::Outbound *PropertyReplicator::get_outbound(Entity *entity)
+  {
+    auto iter = outbounds_.find(entity->get_id());
+    if (iter == outbounds_.end())
+    {
+      Outbound outbound;
+      auto network_component = entity->get_component<NetworkComponent>();
+      if (network_component && network_component->can_send())
+      {
+        outbound.network = network_component;
+      }
+      iter = outbounds_.emplace(entity->get_id(), std::move(outbound)).first;
+    }
+    return iter->second.network ? &iter->second : nullptr;
+  }
+
+  PropertyReplicator::Outbound *PropertyReplicator::get_outbound(EntityId id)
+  {
+    auto iter = outbounds_.find(id);
+    if (iter != outbounds_.end())
+    {
+      return iter->second.network ? &iter->second : nullptr;
+    }
+
+    auto entity = EntityFactory::get_instance().get_entity(id);
+    if (!entity)
+    {
+      // remember it, don't look it up again in this tick
+      outbounds_.emplace(id, Outbound());
+      return nullptr;
+    }
+    return get_outbound(entity.get());
+  }
+
+  void PropertyReplicator::apply_aoi_events()
+  {
+    for (const auto &event : AoiGrid::get_instance().get_events())
+    {
+      if (event.type == AoiEventType::kMove)
+      {
+        continue;
+      }
+
+      Outbound *outbound = get_outbound(event.watcher);
+      if (!outbound)
+      {
+        continue;
+      }
+
+      if (event.type == AoiEventType::kLeave)
+      {
+        outbound->writer.write(static_cast<uint8_t>(ReplicationRecord::kLeave));
+        outbound->writer.write(event.target);
+        continue;
+      }
+
+      // full state on enter, later deltas are based on it
+      auto target = EntityFactory::get_instance().get_entity(event.target);
+      if (!target)
+      {
+        continue;
+      }
+      size_t start = outbound->writer.size();
+      outbound->writer.write(static_cast<uint8_t>(ReplicationRecord::kEnter));
+      if (!target->serialize_properties(outbound->writer, false, true))
+      {
+        // nothing to replicate, the client still needs to know the entity
+        outbound->writer.truncate(start);
+        outbound->writer.write(static_cast<uint8_t>(ReplicationRecord::kEnter));
+        outbound->writer.write(event.target);
+        outbound->writer.write(static_cast<uint8_t>(0));
+      }
+    }
+  }
+
+  void PropertyReplicator::replicate_entity(Entity *entity)
+  {
+    entity->collect_property_changes();
+
+    // owner
+    owner_writer_.clear();
+    Outbound *owner = get_outbound(entity);
+    if (owner && entity->serialize_properties(owner_writer_, true, false))
+    {
+      owner->writer.write(static_cast<uint8_t>(ReplicationRecord::kDelta));
+      owner->writer.write_bytes(owner_writer_.data(), owner_writer_.size());
+    }
+
+    // observers share one serialized record
+    auto aoi_component = entity->get_component<AoiComponent>();
+    if (!aoi_component || !aoi_component->is_in_grid())
+    {
+      return;
+    }
+
+    observer_writer_.clear();
+    if (!entity->serialize_properties(observer_writer_, false, false))
+    {
+      return;
+    }
+
+    for (EntityId observer_id : aoi_component->get_observers())
+    {
+      Outbound *observer = get_outbound(observer_id);
+      if (observer)
+      {
+        observer->writer.write(static_cast<uint8_t>(ReplicationRecord::kDelta));
+        observer->writer.write_bytes(observer_writer_.data(), observer_writer_.size());
+      }
+    }
+  }
+
+  void PropertyReplicator::send_all()
+  {
+    for (auto &[id, outbound] : outbounds_)
+    {
+      if (!outbound.network || outbound.writer.empty())
+      {
+        continue;
+      }
+      outbound.network->send(REPLICATION_MESSAGE_ID, outbound.writer.data(), outbound.writer.size(), SendLane::kRealtime);
+      sent_bytes_ += outbound.writer.size();
+    }
+    outbounds_.clear();
+  }
+
+  void PropertyReplicator::replicate()
+  {
+    replicated_entity_count_ = 0;
+    sent_bytes_ = 0;
+
+    apply_aoi_events();
+
+    // entities may get dirty again while replicating, they go to the next tick
+    replicating_entities_.swap(dirty_entities_);
+    for (EntityHandle handle : replicating_entities_)
+    {
+      Entity *entity = EntityFactory::get_instance().get_entity(handle);
+      if (!entity)
+      {
+        continue;
+      }
+      replicate_entity(entity);
+      replicated_entity_count_++;
+    }
+    replicating_entities_.clear();
+
+    send_all();
+  }
+}
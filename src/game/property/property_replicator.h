@@ -0,0 +1,92 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: send changed properties of entities to their owners and observers once per tick
+#pragma once
+
+#include "game/basic/entity_handle.h"
+#include "game/basic/entity_id.h"
+#include "game/property/property.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// message carrying all replication records of one tick for one client
+#define REPLICATION_MESSAGE_ID 0x0100
+
+namespace multiplayer_server
+{
+  class Entity;
+  class NetworkComponent;
+
+  // record types inside a replication message
+  //   kEnter: uint8 type | entity properties with all fields the receiver can see
+  //   kDelta: uint8 type | entity properties with changed fields only
+  //   kLeave: uint8 type | uint64 entity id
+  // entity properties: uint64 entity id | uint8 set count | (uint8 set index | uint64 mask | values) * count
+  enum class ReplicationRecord : uint8_t
+  {
+    kEnter,
+    kDelta,
+    kLeave,
+  };
+
+  // runs in the replicate phase after the aoi grid
+  // observers come from the aoi grid, they get full state on enter and deltas afterwards
+  // the owner is the client connected to the entity, it also gets owner only fields
+  // every changed entity is serialized once for its owner and once for all observers
+  // and all records of one client in one tick are sent as one message
+  // not thread safe, only used by the tick thread
+  class PropertyReplicator
+  {
+  public:
+    PropertyReplicator() = default;
+    ~PropertyReplicator() = default;
+
+    // non-copyable
+    PropertyReplicator(const PropertyReplicator &) = delete;
+    PropertyReplicator &operator=(const PropertyReplicator &) = delete;
+    PropertyReplicator(PropertyReplicator &&) = delete;
+    PropertyReplicator &operator=(PropertyReplicator &&) = delete;
+
+    static PropertyReplicator &get_instance();
+
+    // called by Entity::on_property_dirty, at most once per entity per tick
+    void add_dirty_entity(EntityHandle handle) { dirty_entities_.push_back(handle); }
+
+    // collect changes of this tick and send them
+    void replicate();
+
+    // stats of the last replicate()
+    size_t get_replicated_entity_count() const { return replicated_entity_count_; }
+    size_t get_sent_bytes() const { return sent_bytes_; }
+
+  private:
+    struct Outbound
+    {
+      // component of the receiver, it keeps messages while its client is away
+      NetworkComponent *network = nullptr;
+      PropertyWriter writer;
+    };
+
+    // buffer of the client connected to entity id, nullptr if the entity has no client
+    Outbound *get_outbound(EntityId id);
+    Outbound *get_outbound(Entity *entity);
+
+    void apply_aoi_events();
+    void replicate_entity(Entity *entity);
+    void send_all();
+
+  private:
+    std::vector<EntityHandle> dirty_entities_;
+    std::vector<EntityHandle> replicating_entities_;
+
+    // receivers of this tick, entities without client are kept as empty outbound so they are resolved once
+    std::unordered_map<EntityId, Outbound> outbounds_;
+
+    PropertyWriter owner_writer_;
+    PropertyWriter observer_writer_;
+
+    size_t replicated_entity_count_ = 0;
+    size_t sent_bytes_ = 0;
+  };
+}
@@ -0,0 +1,128 @@
+#include "room.h"
+#include <algorithm>
+#include <chrono>
+
+namespace multiplayer_server
+{
+  Room::Room(RoomId id, int tick_rate)
+    : id_(id), tick_delta_(1.0f / (tick_rate > 0 ? tick_rate : ROOM_DEFAULT_TICK_RATE)), timer_wheel_(tick_delta_)
+  {
+  }
+
+  Room::~Room()
+  {
+    // release entities before the timer wheel
+    for (auto &item : entities_)
+    {
+      destroyed_entities_.emplace_back(std::move(item.second));
+    }
+    entities_.clear();
+    flush_destroyed_entities();
+  }
+
+  void Room::post(Task task)
+  {
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    tasks_.emplace_back(std::move(task));
+  }
+
+  Entity *Room::get_entity(EntityId id) const
+  {
+    auto iter = entities_.find(id);
+    return iter != entities_.end() ? iter->second.get() : nullptr;
+  }
+
+  void Room::destroy_entity(EntityId id)
+  {
+    auto iter = entities_.find(id);
+    if (iter == entities_.end())
+    {
+      return;
+    }
+
+    iter->second->set_validate(false);
+    destroyed_entities_.emplace_back(std::move(iter->second));
+    entities_.erase(iter);
+  }
+
+  int Room::add_time(float dt)
+  {
+    accumulator_ += dt;
+    int tick_count = static_cast<int>(accumulator_ / tick_delta_);
+    if (tick_count <= 0)
+    {
+      return 0;
+    }
+
+    accumulator_ -= tick_count * tick_delta_;
+    if (tick_count > ROOM_MAX_CATCH_UP_TICKS)
+    {
+      stats_.skipped_count += tick_count - ROOM_MAX_CATCH_UP_TICKS;
+      tick_count = ROOM_MAX_CATCH_UP_TICKS;
+    }
+    return tick_count;
+  }
+
+  void Room::run(int tick_count)
+  {
+    for (int i = 0; i < tick_count && !closed_; i++)
+    {
+      auto start = std::chrono::steady_clock::now();
+      tick();
+      int64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+      stats_.tick_count++;
+      stats_.last_duration = duration;
+      stats_.max_duration = std::max(stats_.max_duration, duration);
+      stats_.total_duration += duration;
+    }
+  }
+
+  void Room::tick()
+  {
+    {
+      std::lock_guard<std::mutex> lock(task_mutex_);
+      running_tasks_.swap(tasks_);
+    }
+    for (auto &task : running_tasks_)
+    {
+      task();
+    }
+    running_tasks_.clear();
+
+    timer_wheel_.advance();
+
+    component_storage_.update_all(tick_delta_);
+
+    for (auto &item : entities_)
+    {
+      update_entities_.push_back(item.second.get());
+    }
+    for (Entity *entity : update_entities_)
+    {
+      if (entity->is_valid())
+      {
+        entity->update(tick_delta_);
+      }
+    }
+    update_entities_.clear();
+
+    if (tick_handler_)
+    {
+      tick_handler_(*this, tick_delta_);
+    }
+
+    flush_destroyed_entities();
+  }
+
+  void Room::flush_destroyed_entities()
+  {
+    // before_destruct may destroy more entities, they are released in the same loop
+    for (size_t i = 0; i < destroyed_entities_.size(); i++)
+    {
+      std::shared_ptr<Entity> entity = destroyed_entities_[i];
+      entity->before_destruct();
+    }
+    destroyed_entities_.clear();
+  }
+}
@@ -0,0 +1,143 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: a small isolated simulation with its own entities, tick rate and timers
+#pragma once
+
+#include "game/basic/component_storage.h"
+#include "game/basic/entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/basic/pool_allocator.h"
+#include "game/basic/server_entity.h"
+#include "game/timer/timer_wheel.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// default ticks per second of a room
+#define ROOM_DEFAULT_TICK_RATE 20
+// max ticks a room runs back to back when it falls behind, the rest are skipped
+#define ROOM_MAX_CATCH_UP_TICKS 3
+
+namespace multiplayer_server
+{
+  using RoomId = uint64_t;
+
+  // durations are in microseconds, time spent by workers running the ticks of the room
+  struct RoomStats
+  {
+    uint64_t tick_count = 0;
+    uint64_t skipped_count = 0;
+    int64_t last_duration = 0;
+    int64_t max_duration = 0;
+    int64_t total_duration = 0;
+
+    int64_t get_average_duration() const { return tick_count ? total_duration / static_cast<int64_t>(tick_count) : 0; }
+  };
+
+  // a room never touches another room, so rooms tick on different workers at the same time without locks
+  // components of room entities live in pools of the room, never in the world pools
+  // entities of a room are not in the entity factory, they are only updated, found and destroyed by their room
+  // components using world systems, for example AoiComponent and NetworkComponent, don't belong in rooms
+  // every tick: posted tasks, timers, component pools, entity update, tick handler, then destroyed entities are released
+  // only post() is thread safe, the rest is used by the worker running the room
+  // or by the world tick while rooms are not running, for example right after create_room
+  class Room
+  {
+  public:
+    using Task = std::function<void()>;
+    using TickHandler = std::function<void(Room &room, float dt)>;
+
+  public:
+    Room(RoomId id, int tick_rate);
+    ~Room();
+
+    // non-copyable
+    Room(const Room &) = delete;
+    Room &operator=(const Room &) = delete;
+    Room(Room &&) = delete;
+    Room &operator=(Room &&) = delete;
+
+  public:
+    RoomId get_id() const { return id_; }
+    float get_tick_delta() const { return tick_delta_; }
+    const RoomStats &get_stats() const { return stats_; }
+
+    // game logic of the room, runs after entities updated
+    void set_tick_handler(TickHandler handler) { tick_handler_ = std::move(handler); }
+
+    // run task at the beginning of the next tick of the room, thread safe
+    void post(Task task);
+
+    // server entities belong to the world, they are known by the directory and sessions of the process
+    // the entity uses the timer wheel and component pools of the room, don't keep it after the room is destroyed
+    // components added by the constructor of T would go to the world pools, add them after create_entity
+    template <typename T, typename... Args>
+    std::shared_ptr<T> create_entity(Args &&...args)
+    {
+      static_assert(std::is_base_of<Entity, T>::value, "T must be derived from Entity");
+      static_assert(!std::is_base_of<ServerEntity, T>::value, "server entities can't live in a room");
+
+      std::shared_ptr<T> entity = make_pooled_shared<T>(EntityFactory::get_instance().generate_id(), std::forward<Args>(args)...);
+      if (!entity)
+      {
+        return nullptr;
+      }
+      entity->set_timer_wheel(timer_wheel_);
+      entity->set_component_storage(component_storage_);
+      entities_.emplace(entity->get_id(), entity);
+      return entity;
+    }
+
+    // nullptr if the entity is not in this room
+    Entity *get_entity(EntityId id) const;
+    size_t get_entity_count() const { return entities_.size(); }
+
+    // the entity stops at once and is released at the end of the tick
+    void destroy_entity(EntityId id);
+
+    // the manager destroys the room after the current ticks of all rooms
+    void close() { closed_ = true; }
+    bool is_closed() const { return closed_; }
+
+    TimerWheel &get_timer_wheel() { return timer_wheel_; }
+    ComponentStorage &get_component_storage() { return component_storage_; }
+
+  private:
+    friend class RoomManager;
+
+    // called by the manager on the world tick, return the number of ticks due
+    int add_time(float dt);
+    // run the ticks due, called by a worker
+    void run(int tick_count);
+    void tick();
+    void flush_destroyed_entities();
+
+  private:
+    RoomId id_ = 0;
+    float tick_delta_ = 1.0f / ROOM_DEFAULT_TICK_RATE;
+    // time not consumed by ticks yet
+    float accumulator_ = 0.0f;
+    bool closed_ = false;
+
+    // declared before entities, entities cancel their timers and release their components when they are released
+    TimerWheel timer_wheel_;
+    ComponentStorage component_storage_;
+    std::unordered_map<EntityId, std::shared_ptr<Entity>> entities_;
+    // entities of the running update, entities may be created or destroyed during update
+    // destroyed ones are kept alive until the end of the tick, so the pointers stay valid
+    std::vector<Entity *> update_entities_;
+    std::vector<std::shared_ptr<Entity>> destroyed_entities_;
+
+    TickHandler tick_handler_;
+
+    std::mutex task_mutex_;
+    std::vector<Task> tasks_;
+    std::vector<Task> running_tasks_;
+
+    RoomStats stats_;
+  };
+}
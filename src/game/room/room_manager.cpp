@@ -0,0 +1,95 @@
+#include "room_manager.h"
+#include "game/job/job_system.h"
+#include <chrono>
+
+namespace multiplayer_server
+{
+  RoomManager::RoomManager(JobSystem &job_system) : job_system_(job_system)
+  {
+    logger_ = g_logger_manager.create_logger("RoomManager", LoggerLevel::Debug, "log/RoomManager.log");
+  }
+
+  RoomManager::~RoomManager()
+  {
+  }
+
+  Room &RoomManager::create_room(int tick_rate)
+  {
+    RoomId id = next_room_id_++;
+    auto room = std::make_unique<Room>(id, tick_rate);
+    Room &result = *room;
+    rooms_.emplace(id, std::move(room));
+    logger_->debug("RoomManager: create room {}, tick rate {}", id, tick_rate);
+    return result;
+  }
+
+  Room *RoomManager::get_room(RoomId id) const
+  {
+    auto iter = rooms_.find(id);
+    if (iter == rooms_.end() || iter->second->is_closed())
+    {
+      return nullptr;
+    }
+    return iter->second.get();
+  }
+
+  void RoomManager::destroy_room(RoomId id)
+  {
+    auto iter = rooms_.find(id);
+    if (iter != rooms_.end())
+    {
+      iter->second->close();
+    }
+  }
+
+  void RoomManager::update(float dt)
+  {
+    // rooms closed since the last update, including rooms that closed themselves while running
+    remove_closed_rooms();
+
+    int64_t busy_before = 0;
+    for (auto &item : rooms_)
+    {
+      Room *room = item.second.get();
+      int tick_count = room->add_time(dt);
+      if (tick_count > 0)
+      {
+        running_rooms_.emplace_back(room, tick_count);
+        busy_before += room->get_stats().total_duration;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    job_system_.parallel_for_each(running_rooms_, [](std::pair<Room *, int> &item)
+                                  { item.first->run(item.second); }, ROOM_JOB_GRAIN_SIZE);
+
+    int64_t busy_after = 0;
+    for (auto &item : running_rooms_)
+    {
+      busy_after += item.first->get_stats().total_duration;
+    }
+
+    stats_.room_count = rooms_.size();
+    stats_.running_count = running_rooms_.size();
+    stats_.last_duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    stats_.last_busy = busy_after - busy_before;
+    running_rooms_.clear();
+  }
+
+  void RoomManager::remove_closed_rooms()
+  {
+    for (auto iter = rooms_.begin(); iter != rooms_.end();)
+    {
+      if (iter->second->is_closed())
+      {
+        logger_->debug("RoomManager: destroy room {}, {} ticks, average tick {} us", iter->first,
+                       iter->second->get_stats().tick_count, iter->second->get_stats().get_average_duration());
+        iter = rooms_.erase(iter);
+      }
+      else
+      {
+        ++iter;
+      }
+    }
+  }
+}
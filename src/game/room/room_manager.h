@@ -0,0 +1,75 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: create, schedule and destroy rooms, rooms due in a world tick run in parallel on the job system
+#pragma once
+
+#include "game/room/room.h"
+#include "log/logger.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// rooms run by one job, small rooms are cheaper to run in batches than one job each
+#define ROOM_JOB_GRAIN_SIZE 8
+
+namespace multiplayer_server
+{
+  class JobSystem;
+
+  // durations are in microseconds
+  struct RoomManagerStats
+  {
+    size_t room_count = 0;
+    // rooms that ran at least one tick in the last update
+    size_t running_count = 0;
+    // time of the last update on the world tick, from the first room started to the last room finished
+    int64_t last_duration = 0;
+    // sum of the time workers spent in rooms in the last update, last_busy / last_duration is the parallelism
+    int64_t last_busy = 0;
+  };
+
+  // rooms are created and destroyed on the world tick
+  // update() gives every room the time of the world tick and runs the rooms with due ticks across the workers
+  // a room is run by one job at a time, so it needs no lock, and update() returns after all rooms finished
+  class RoomManager
+  {
+  public:
+    RoomManager(JobSystem &job_system);
+    ~RoomManager();
+
+    // non-copyable
+    RoomManager(const RoomManager &) = delete;
+    RoomManager &operator=(const RoomManager &) = delete;
+    RoomManager(RoomManager &&) = delete;
+    RoomManager &operator=(RoomManager &&) = delete;
+
+  public:
+    // the room runs from the next update, set it up before that
+    Room &create_room(int tick_rate = ROOM_DEFAULT_TICK_RATE);
+    // nullptr if not found or closed
+    Room *get_room(RoomId id) const;
+    // the room is destroyed in the next update
+    void destroy_room(RoomId id);
+
+    // called by the world tick
+    void update(float dt);
+
+    size_t get_room_count() const { return rooms_.size(); }
+    const RoomManagerStats &get_stats() const { return stats_; }
+
+  private:
+    // destroy closed rooms, called while no room is running
+    void remove_closed_rooms();
+
+  private:
+    JobSystem &job_system_;
+    RoomId next_room_id_ = 1;
+
+    std::unordered_map<RoomId, std::unique_ptr<Room>> rooms_;
+    // rooms with due ticks in this update and the number of ticks
+    std::vector<std::pair<Room *, int>> running_rooms_;
+
+    RoomManagerStats stats_;
+    std::shared_ptr<LoggerImp> logger_;
+  };
+}
@@ -3,13 +3,15 @@
 #include "log/logger.h"
 #include "config/game_config.h"
 #include "game/component/network_component.h"
+#include "game/session/session_manager.h"
 
 namespace multiplayer_server
 {
-  LoginService::LoginService(const std::string &id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config) : 
+  LoginService::LoginService(EntityId id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config) : 
     ServerEntity(id, ServerEntityType::kServiceEntity, ip, port),
     game_config_(game_config)
   {
+    login_blueprint_ = EntityBlueprintCache::get_instance().find(LOGIN_BLUEPRINT_NAME);
   }
 
   LoginService::~LoginService()
@@ -30,58 +32,58 @@ namespace multiplayer_server
   {
     logger_->debug("LoginService::on_client_connected");
 
-    // create entity for this connection use configuration data from game config
-    // first, find witch entity class should be created
-    auto data_ptr = game_config_->get<LoginEntityConfig>(LOGIN_CONFIG_STR);
-    if (!data_ptr)
+    // create entity for this connection from the login blueprint
+    if (!login_blueprint_)
     {
-      logger_->error("LoginService::on_client_connected, can not find login entity config data");
+      logger_->error("LoginService::on_client_connected, can not find login entity blueprint");
       return false;
     }
-    auto entity_class_name = data_ptr->entity_class_name;
 
-    // second, create entity
-    if (entity_class_name == "ServerEntity")
+    auto entity = login_blueprint_->spawn(entity_factory_, proxy_->get_ip(), proxy_->get_port());
+    if (!entity)
     {
-      auto entity_type = ServerEntity::get_type_from_string(data_ptr->entity_type);
-
-      auto entity = entity_factory_.create_entity<ServerEntity>(entity_type, proxy_->get_ip(), proxy_->get_port());
+      return false;
+    }
 
-      if (data_ptr->entity_components.size() > 0)
-      {
-        entity->init_components(data_ptr->entity_components);
-      }
+    // get network component and set connection
+    auto network_component = entity->get_component<NetworkComponent>();
+    if (network_component)
+    {
+      network_component->set_connection(connection);
+      network_component->register_disconnect_handler("LoginService", std::bind(&LoginService::on_client_disconnected, this, std::placeholders::_1));
+      // released by on_client_disconnected
+      client_count_++;
+      // the client can come back to this entity with the token after it disconnects
+      SessionManager::get_instance().open(*network_component);
+    }
 
-      // get network component and set connection
-      auto network_component = entity->get_component<NetworkComponent>();
-      if (network_component)
-      {
-        network_component->set_connection(connection);
-        network_component->register_disconnect_handler("LoginService", std::bind(&LoginService::on_client_disconnected, this, std::placeholders::_1));
-      }
+    // any other entity can find this entity by id wherever it is and which process it is
+    entity->register_in_directory();
 
-      // TODO:
-      // 1. authorize the entity
-      // 2. check if the entity is already in the game or already in global entity manager
-      // 3. register entity to global entity manager so that any other entity can find this entity by id wherever it is and which process it is
-    }
+    // TODO:
+    // 1. authorize the entity
+    // 2. check if the entity is already in the game or already in global entity manager
 
     return true;
   }
 
-  void LoginService::on_client_disconnected(const std::string &id)
+  void LoginService::on_client_disconnected(EntityId id)
   {
+    if (client_count_ > 0)
+    {
+      client_count_--;
+    }
+
     auto entity = entity_factory_.get_entity(id);
     if (!entity)
     {
       return;
     }
 
-    logger_->debug("LoginService::on_client_disconnected");
-
-    // TODO:
-    // unregister entity from global entity manager
+    // the entity is destroyed by the caller, its directory entry is removed when it's destructed at the tick boundary
+    logger_->debug("LoginService::on_client_disconnected, entity {}", id);
 
+    // TODO: save the entity before it's destroyed
     return;
   }
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "game/basic/server_entity.h"
 #include "game/basic/entity_factory.h"
+#include "game/basic/entity_blueprint.h"
+#include "game/service/service_locator.h"
 #include <memory>
 
 namespace multiplayer_server
@@ -16,7 +18,10 @@ namespace multiplayer_server
   class LoginService final: public ServerEntity
   {
   public:
-    LoginService(const std::string &id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config);
+    static constexpr ServiceSlot kServiceSlot = ServiceSlot::kLoginService;
+
+  public:
+    LoginService(EntityId id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config);
     virtual ~LoginService();
 
     void update(float dt) override;
@@ -27,12 +32,18 @@ namespace multiplayer_server
     bool on_client_connected(std::shared_ptr<Connection> connection);
 
     // game only need to know the entity is disconnected
-    void on_client_disconnected(const std::string &id);
+    void on_client_disconnected(EntityId id);
+
+    // clients logged in through this instance and still connected
+    size_t get_load() const override { return client_count_; }
 
   private:
     // game config
     std::shared_ptr<GameConfig> game_config_;
+    // blueprint of entities created for new clients, compiled from the login config
+    std::shared_ptr<const EntityBlueprint> login_blueprint_;
     // entity factory
     EntityFactory &entity_factory_ = EntityFactory::get_instance();
+    size_t client_count_ = 0;
   };
 }
\ No newline at end of file
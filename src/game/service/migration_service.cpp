@@ -0,0 +1,622 @@
+#include "migration_service.h"
+#include "config/game_config.h"
+#include "game/component/network_component.h"
+#include "game/directory/entity_directory.h"
+#include "game/migration/migration_protocol.h"
+#include "game/migration/relay_connection.h"
+#include "game/property/property.h"
+#include "game/session/session_manager.h"
+#include "game/tick_scheduler.h"
+#include "network/asio_server.h"
+#include "network/asio_tcp_connection.h"
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  MigrationService::MigrationService(EntityId id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config, TickScheduler &tick_scheduler)
+    : ServerEntity(id, ServerEntityType::kServiceEntity, ip, port),
+      game_config_(game_config),
+      tick_scheduler_(tick_scheduler)
+  {
+    auto config = game_config_->get<MigrationConfig>(MIGRATION_CONFIG_STR, std::make_shared<MigrationConfig>());
+    listen_port_ = config->port;
+    handoff_timeout_ = std::chrono::milliseconds(config->handoff_timeout);
+    max_buffered_messages_ = static_cast<size_t>(std::max(config->max_buffered_messages, 0));
+  }
+
+  MigrationService::~MigrationService()
+  {
+    stop();
+  }
+
+  void MigrationService::render()
+  {
+  }
+
+  void MigrationService::before_destruct()
+  {
+    stop();
+    ServerEntity::before_destruct();
+  }
+
+  bool MigrationService::start()
+  {
+    if (server_)
+    {
+      return true;
+    }
+
+    if (listen_port_ <= 0)
+    {
+      logger_->info("MigrationService: migration is disabled");
+      return false;
+    }
+
+    auto server = std::make_unique<AsioServer>(proxy_->get_ip(), listen_port_, true, false);
+    server->set_io_context_thread_count(1);
+    std::function<bool(std::shared_ptr<Connection>)> callback = std::bind(&MigrationService::on_link_accepted, this, std::placeholders::_1);
+    server->regist_on_client_connected(callback);
+
+    try
+    {
+      server->start();
+    }
+    catch (const std::exception &e)
+    {
+      logger_->error("MigrationService: listen on {}:{} failed, error: {}", proxy_->get_ip(), listen_port_, e.what());
+      return false;
+    }
+
+    server_ = std::move(server);
+    logger_->info("MigrationService: accept entities on {}:{}", proxy_->get_ip(), listen_port_);
+    return true;
+  }
+
+  // io threads stop first, nothing is posted to the world tick after it
+  void MigrationService::stop()
+  {
+    if (!server_)
+    {
+      return;
+    }
+
+    server_->stop();
+    server_.reset();
+    outbound_links_.clear();
+    inbound_links_.clear();
+    process_links_.clear();
+  }
+
+  void MigrationService::update(float dt)
+  {
+    ServerEntity::update(dt);
+
+    if (handoffs_.empty())
+    {
+      return;
+    }
+
+    // take back entities the target doesn't accept in time
+    auto now = std::chrono::steady_clock::now();
+    std::vector<EntityId> expired;
+    for (const auto &[id, handoff] : handoffs_)
+    {
+      if (now >= handoff.deadline)
+      {
+        expired.push_back(id);
+      }
+    }
+    for (EntityId id : expired)
+    {
+      logger_->warn("MigrationService: entity {} handoff to {}:{} timeout", id, handoffs_[id].target_ip, handoffs_[id].target_port);
+      finish_handoff(id, false);
+    }
+  }
+
+  bool MigrationService::on_link_accepted(std::shared_ptr<Connection> connection)
+  {
+    auto link = std::make_shared<Link>();
+    link->connection = connection;
+    link->connected = true;
+    watch_link(link);
+
+    tick_scheduler_.post([this, link]()
+                         { inbound_links_.push_back(link); });
+    return true;
+  }
+
+  void MigrationService::watch_link(const std::shared_ptr<Link> &link)
+  {
+    // the link owns the connection and the connection owns the callbacks, only keep a weak pointer
+    std::weak_ptr<Link> weak_link = link;
+    link->connection->set_receive_callback([this, weak_link](uint16_t message_id, const void *data, size_t size)
+                                           {
+      auto link = weak_link.lock();
+      if (!link)
+      {
+        return;
+      }
+      const char *bytes = static_cast<const char *>(data);
+      std::vector<char> payload(bytes, bytes + size);
+      tick_scheduler_.post([this, link, message_id, payload = std::move(payload)]()
+                           { on_link_message(link, message_id, payload); }); });
+
+    link->connection->set_disconnected_callback([this, weak_link]()
+                                                {
+      auto link = weak_link.lock();
+      if (!link)
+      {
+        return;
+      }
+      tick_scheduler_.post([this, link]()
+                           { on_link_connected(link, false); }); });
+  }
+
+  std::shared_ptr<MigrationService::Link> MigrationService::get_outbound_link(const std::string &ip, int port)
+  {
+    std::string key = get_link_key(ip, port);
+    auto iter = outbound_links_.find(key);
+    if (iter != outbound_links_.end())
+    {
+      return iter->second;
+    }
+
+    auto link = std::make_shared<Link>();
+    link->connection = std::make_shared<AsioTcpConnection>(ip, port, server_->get_io_context());
+    watch_link(link);
+
+    std::weak_ptr<Link> weak_link = link;
+    link->connection->set_connected_callback([this, weak_link](bool success)
+                                             {
+      auto link = weak_link.lock();
+      if (!link)
+      {
+        return;
+      }
+      tick_scheduler_.post([this, link, success]()
+                           { on_link_connected(link, success); }); });
+
+    try
+    {
+      link->connection->async_connect();
+    }
+    catch (const std::exception &e)
+    {
+      logger_->error("MigrationService: connect to {}:{} failed, error: {}", ip, port, e.what());
+      return nullptr;
+    }
+
+    outbound_links_[key] = link;
+    return link;
+  }
+
+  void MigrationService::send_to_link(const std::shared_ptr<Link> &link, uint16_t message_id, std::vector<char> payload)
+  {
+    if (!link->connected)
+    {
+      link->pending.emplace_back(message_id, std::move(payload));
+      return;
+    }
+    link->connection->async_send(message_id, payload.data(), payload.size(), SendLane::kRealtime);
+  }
+
+  void MigrationService::on_link_connected(const std::shared_ptr<Link> &link, bool success)
+  {
+    if (success)
+    {
+      link->connected = true;
+      for (auto &[message_id, payload] : link->pending)
+      {
+        link->connection->async_send(message_id, payload.data(), payload.size(), SendLane::kRealtime);
+      }
+      link->pending.clear();
+      return;
+    }
+
+    // connect failed or the link is closed, next migrate() connects again
+    logger_->warn("MigrationService: link to {}:{} is closed", link->connection->get_ip(), link->connection->get_port());
+    link->connected = false;
+    link->pending.clear();
+    for (auto iter = outbound_links_.begin(); iter != outbound_links_.end(); ++iter)
+    {
+      if (iter->second == link)
+      {
+        outbound_links_.erase(iter);
+        break;
+      }
+    }
+    inbound_links_.erase(std::remove(inbound_links_.begin(), inbound_links_.end(), link), inbound_links_.end());
+    for (auto iter = process_links_.begin(); iter != process_links_.end();)
+    {
+      iter = iter->second == link ? process_links_.erase(iter) : std::next(iter);
+    }
+
+    std::vector<EntityId> failed;
+    for (const auto &[id, handoff] : handoffs_)
+    {
+      if (handoff.link == link)
+      {
+        failed.push_back(id);
+      }
+    }
+    for (EntityId id : failed)
+    {
+      finish_handoff(id, false);
+    }
+  }
+
+  bool MigrationService::migrate(EntityId id, const std::string &ip, int port, MigrationCallback callback)
+  {
+    if (!server_)
+    {
+      logger_->error("MigrationService: migration is not started, can't move entity {}", id);
+      return false;
+    }
+
+    if (handoffs_.find(id) != handoffs_.end() || id == id_)
+    {
+      return false;
+    }
+
+    auto entity = std::dynamic_pointer_cast<ServerEntity>(entity_factory_.get_entity(id));
+    if (!entity || entity->get_server_type() == ServerEntityType::kMirrorEntity)
+    {
+      logger_->error("MigrationService: entity {} is not a local server entity", id);
+      return false;
+    }
+
+    // its client is gone, it waits here for the client to come back or for the grace period to end
+    if (SessionManager::get_instance().is_suspended(id))
+    {
+      logger_->error("MigrationService: entity {} is suspended, can't move it", id);
+      return false;
+    }
+
+    auto link = get_outbound_link(ip, port);
+    if (!link)
+    {
+      return false;
+    }
+
+    Handoff handoff;
+    handoff.id = id;
+    handoff.type = entity->get_server_type();
+    handoff.target_ip = ip;
+    handoff.target_port = port;
+    handoff.link = link;
+    handoff.deadline = std::chrono::steady_clock::now() + handoff_timeout_;
+    handoff.callback = std::move(callback);
+    if (auto network_component = entity->get_component<NetworkComponent>())
+    {
+      handoff.client_connection = network_component->get_connection();
+    }
+
+    // the session moves with the entity, destroying the entity below doesn't close it
+    handoff.session_generation = SessionManager::get_instance().detach(id);
+
+    PropertyWriter writer;
+    writer.write(id);
+    writer.write(static_cast<uint8_t>(handoff.type));
+    writer.write(handoff.session_generation);
+    entity->save_state(writer);
+    handoff.state.assign(writer.data(), writer.data() + writer.size());
+
+    // messages waiting in the mailbox would be dropped with the entity, they go to the target first
+    entity->get_mailbox().drain(entity->get_mailbox().get_pending_count(), [&handoff](const EntityMessage &message)
+                                { handoff.buffered.emplace_back(message.message_id, message.data); });
+
+    // the entity stops here, the mirror holds the client until the target takes over
+    entity.reset();
+    entity_factory_.destroy_entity(id);
+    if (!create_mirror(id, ip, port, handoff.client_connection))
+    {
+      logger_->error("MigrationService: create mirror of entity {} failed", id);
+    }
+
+    send_to_link(link, MIGRATION_TRANSFER_MESSAGE_ID, handoff.state);
+    handoffs_.emplace(id, std::move(handoff));
+    logger_->info("MigrationService: move entity {} to {}:{}, state size {}", id, ip, port, writer.size());
+    return true;
+  }
+
+  bool MigrationService::route_message(EntityId id, uint16_t message_id, const char *data, size_t size)
+  {
+    // in handoff, keep it until the target takes over
+    auto handoff_iter = handoffs_.find(id);
+    if (handoff_iter != handoffs_.end())
+    {
+      Handoff &handoff = handoff_iter->second;
+      if (handoff.buffered.size() >= max_buffered_messages_)
+      {
+        handoff.dropped++;
+        return false;
+      }
+      handoff.buffered.emplace_back(message_id, std::vector<char>(data, data + size));
+      return true;
+    }
+
+    // local, the entity handles it when the mailbox is dispatched in this tick
+    auto entity = std::dynamic_pointer_cast<ServerEntity>(entity_factory_.get_entity(id));
+    if (entity && entity->get_server_type() != ServerEntityType::kMirrorEntity)
+    {
+      return entity_factory_.post_message(id, message_id, kInvalidEntityId, data, size);
+    }
+    entity.reset();
+
+    // lives in another process, forward it over the link to that process
+    std::shared_ptr<Link> link;
+    auto proxy = EntityDirectory::get_instance().lookup(id);
+    if (proxy && (proxy->get_ip() != proxy_->get_ip() || proxy->get_port() != proxy_->get_port()))
+    {
+      auto process_iter = process_links_.find(get_link_key(proxy->get_ip(), proxy->get_port()));
+      if (process_iter != process_links_.end())
+      {
+        link = process_iter->second;
+      }
+    }
+
+    // the target registers the entity at its tick boundary, until then the directory doesn't know it moved
+    if (!link)
+    {
+      auto mirror_iter = mirror_links_.find(id);
+      if (mirror_iter == mirror_links_.end())
+      {
+        return false;
+      }
+      link = mirror_iter->second;
+    }
+
+    PropertyWriter writer;
+    writer.write(id);
+    writer.write(message_id);
+    writer.write_bytes(data, size);
+    send_to_link(link, MIGRATION_FORWARD_MESSAGE_ID, std::vector<char>(writer.data(), writer.data() + writer.size()));
+    return true;
+  }
+
+  void MigrationService::on_link_message(const std::shared_ptr<Link> &link, uint16_t message_id, const std::vector<char> &payload)
+  {
+    switch (message_id)
+    {
+    case MIGRATION_TRANSFER_MESSAGE_ID:
+      on_transfer(link, payload);
+      break;
+    case MIGRATION_ACK_MESSAGE_ID:
+      on_ack(link, payload);
+      break;
+    case MIGRATION_FORWARD_MESSAGE_ID:
+      on_forward(payload);
+      break;
+    case MIGRATION_RELAY_MESSAGE_ID:
+      on_relay(payload);
+      break;
+    case MIGRATION_CANCEL_MESSAGE_ID:
+      on_cancel(payload);
+      break;
+    default:
+      logger_->error("MigrationService: unknown link message {}", message_id);
+      break;
+    }
+  }
+
+  void MigrationService::on_transfer(const std::shared_ptr<Link> &link, const std::vector<char> &payload)
+  {
+    PropertyReader reader(payload.data(), payload.size());
+    EntityId id = kInvalidEntityId;
+    uint8_t type = 0;
+    uint32_t session_generation = 0;
+    if (!reader.read(id) || !reader.read(type) || !reader.read(session_generation))
+    {
+      logger_->error("MigrationService: broken transfer message, size {}", payload.size());
+      return;
+    }
+
+    // the client may still be connected to this process through the mirror, give it back to the entity
+    std::shared_ptr<Connection> client_connection;
+    bool accepted = false;
+    auto exists = std::dynamic_pointer_cast<ServerEntity>(entity_factory_.get_entity(id));
+    if (exists && exists->get_server_type() != ServerEntityType::kMirrorEntity)
+    {
+      logger_->error("MigrationService: entity {} already lives in this process", id);
+    }
+    else
+    {
+      if (exists)
+      {
+        if (auto network_component = exists->get_component<NetworkComponent>())
+        {
+          client_connection = network_component->get_connection();
+        }
+        exists.reset();
+        entity_factory_.destroy_entity(id);
+        mirror_links_.erase(id);
+      }
+
+      // nothing to take back, the client is connected to the source
+      if (!client_connection)
+      {
+        client_connection = std::make_shared<RelayConnection>(id, link->connection);
+      }
+
+      accepted = restore_entity(id, static_cast<ServerEntityType>(type), session_generation, reader.current(), reader.remaining(), client_connection) != nullptr;
+      logger_->info("MigrationService: {} entity {} from {}:{}", accepted ? "accept" : "refuse", id, link->connection->get_ip(), link->connection->get_port());
+    }
+
+    PropertyWriter writer;
+    writer.write(id);
+    writer.write(static_cast<uint8_t>(accepted ? 1 : 0));
+    writer.write(proxy_->get_ip());
+    writer.write(static_cast<int32_t>(proxy_->get_port()));
+    send_to_link(link, MIGRATION_ACK_MESSAGE_ID, std::vector<char>(writer.data(), writer.data() + writer.size()));
+  }
+
+  void MigrationService::on_ack(const std::shared_ptr<Link> &link, const std::vector<char> &payload)
+  {
+    PropertyReader reader(payload.data(), payload.size());
+    EntityId id = kInvalidEntityId;
+    uint8_t accepted = 0;
+    std::string target_ip;
+    int32_t target_port = 0;
+    if (!reader.read(id) || !reader.read(accepted) || !reader.read(target_ip) || !reader.read(target_port))
+    {
+      logger_->error("MigrationService: broken ack message, size {}", payload.size());
+      return;
+    }
+
+    // entities the directory finds in the target process are forwarded over this link
+    process_links_[get_link_key(target_ip, target_port)] = link;
+
+    if (handoffs_.find(id) == handoffs_.end())
+    {
+      // the entity is taken back already, the copy in the target must go
+      if (accepted)
+      {
+        logger_->warn("MigrationService: entity {} is acked after taken back, cancel it in the target", id);
+        send_to_link(link, MIGRATION_CANCEL_MESSAGE_ID, std::vector<char>(payload.data(), payload.data() + sizeof(EntityId)));
+      }
+      return;
+    }
+    finish_handoff(id, accepted != 0);
+  }
+
+  void MigrationService::on_forward(const std::vector<char> &payload)
+  {
+    PropertyReader reader(payload.data(), payload.size());
+    EntityId id = kInvalidEntityId;
+    uint16_t message_id = 0;
+    if (!reader.read(id) || !reader.read(message_id))
+    {
+      logger_->error("MigrationService: broken forward message, size {}", payload.size());
+      return;
+    }
+    route_message(id, message_id, reader.current(), reader.remaining());
+  }
+
+  void MigrationService::on_relay(const std::vector<char> &payload)
+  {
+    PropertyReader reader(payload.data(), payload.size());
+    EntityId id = kInvalidEntityId;
+    uint16_t message_id = 0;
+    uint8_t lane = 0;
+    if (!reader.read(id) || !reader.read(message_id) || !reader.read(lane) || lane >= kSendLaneCount)
+    {
+      logger_->error("MigrationService: broken relay message, size {}", payload.size());
+      return;
+    }
+
+    // the mirror or the entity moved back holds the client connection
+    auto entity = entity_factory_.get_entity(id);
+    auto network_component = entity ? entity->get_component<NetworkComponent>() : nullptr;
+    if (!network_component)
+    {
+      return;
+    }
+    network_component->send(message_id, reader.current(), reader.remaining(), static_cast<SendLane>(lane));
+  }
+
+  void MigrationService::on_cancel(const std::vector<char> &payload)
+  {
+    PropertyReader reader(payload.data(), payload.size());
+    EntityId id = kInvalidEntityId;
+    if (!reader.read(id))
+    {
+      return;
+    }
+
+    auto entity = std::dynamic_pointer_cast<ServerEntity>(entity_factory_.get_entity(id));
+    if (entity && entity->get_server_type() != ServerEntityType::kMirrorEntity)
+    {
+      logger_->warn("MigrationService: drop entity {}, the source took it back", id);
+      entity.reset();
+      entity_factory_.destroy_entity(id);
+    }
+  }
+
+  void MigrationService::finish_handoff(EntityId id, bool success)
+  {
+    auto iter = handoffs_.find(id);
+    if (iter == handoffs_.end())
+    {
+      return;
+    }
+    Handoff handoff = std::move(iter->second);
+    handoffs_.erase(iter);
+
+    if (success)
+    {
+      // buffered messages go first, the link keeps the order
+      mirror_links_[id] = handoff.link;
+      for (auto &[message_id, data] : handoff.buffered)
+      {
+        route_message(id, message_id, data.data(), data.size());
+      }
+      logger_->info("MigrationService: entity {} moved to {}:{}, {} messages forwarded, {} dropped",
+                    id, handoff.target_ip, handoff.target_port, handoff.buffered.size(), handoff.dropped);
+    }
+    else
+    {
+      // take the entity back from the saved state
+      entity_factory_.destroy_entity(id);
+      size_t header_size = sizeof(EntityId) + sizeof(uint8_t) + sizeof(uint32_t);
+      auto entity = restore_entity(id, handoff.type, handoff.session_generation, handoff.state.data() + header_size, handoff.state.size() - header_size, handoff.client_connection);
+      if (entity)
+      {
+        for (auto &[message_id, data] : handoff.buffered)
+        {
+          entity_factory_.post_message(id, message_id, kInvalidEntityId, data.data(), data.size());
+        }
+      }
+      logger_->warn("MigrationService: entity {} failed to move to {}:{}, {}", id, handoff.target_ip, handoff.target_port, entity ? "taken back" : "lost");
+    }
+
+    if (handoff.callback)
+    {
+      handoff.callback(id, success);
+    }
+  }
+
+  std::shared_ptr<ServerEntity> MigrationService::restore_entity(EntityId id, ServerEntityType type, uint32_t session_generation, const char *data, size_t size, std::shared_ptr<Connection> client_connection)
+  {
+    auto entity = entity_factory_.create_entity_with_id<ServerEntity>(id, type, proxy_->get_ip(), proxy_->get_port());
+    if (!entity)
+    {
+      return nullptr;
+    }
+
+    PropertyReader reader(data, size);
+    if (!entity->load_state(reader))
+    {
+      logger_->error("MigrationService: load state of entity {} failed", id);
+      entity.reset();
+      entity_factory_.destroy_entity(id);
+      return nullptr;
+    }
+
+    auto network_component = entity->get_component<NetworkComponent>();
+    if (network_component && client_connection)
+    {
+      network_component->set_connection(client_connection);
+    }
+    if (network_component)
+    {
+      SessionManager::get_instance().attach(*network_component, session_generation);
+    }
+
+    // the directory now points to this process
+    entity->register_in_directory();
+    return entity;
+  }
+
+  std::shared_ptr<ServerEntity> MigrationService::create_mirror(EntityId id, const std::string &ip, int port, std::shared_ptr<Connection> client_connection)
+  {
+    auto mirror = entity_factory_.create_entity_with_id<ServerEntity>(id, ServerEntityType::kMirrorEntity, ip, port);
+    if (mirror && client_connection)
+    {
+      auto network_component = mirror->add_component<NetworkComponent>(client_connection);
+      // the client left, the mirror is destroyed and nothing is forwarded for it any more
+      network_component->register_disconnect_handler("MigrationService", [this](EntityId mirror_id)
+                                                     { mirror_links_.erase(mirror_id); });
+    }
+    return mirror;
+  }
+}
@@ -0,0 +1,132 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: move live server entities between server processes without disconnecting their clients
+#pragma once
+
+#include "game/basic/server_entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/service/service_locator.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace multiplayer_server
+{
+  class AsioServer;
+  class Connection;
+  class GameConfig;
+  class TickScheduler;
+
+  // moving an entity from source to target:
+  //   1. source saves the entity state, destroys the entity and leaves a mirror with the same id
+  //      the mirror keeps the client connection and buffers messages sent to the entity
+  //   2. target creates the entity from the state, the client connection is a RelayConnection back to the mirror
+  //   3. target acks, source sends the buffered messages and forwards every later message to the target
+  //   4. if the target refuses or doesn't ack in time, source creates the entity again from the saved state
+  // moving back to the source replaces the mirror by the entity and gives it the real connection again
+  // processes talk through links to the migration port, all game logic runs on the tick thread
+  class MigrationService final : public ServerEntity
+  {
+  public:
+    static constexpr ServiceSlot kServiceSlot = ServiceSlot::kMigrationService;
+    using MigrationCallback = std::function<void(EntityId id, bool success)>;
+
+  public:
+    MigrationService(EntityId id, const std::string &ip, int port, std::shared_ptr<GameConfig> game_config, TickScheduler &tick_scheduler);
+    virtual ~MigrationService();
+
+    void update(float dt) override;
+    void render() override;
+    void before_destruct() override;
+
+    // listen on the migration port, return false if migration is disabled or listen failed
+    bool start();
+    void stop();
+    bool is_started() const { return server_ != nullptr; }
+
+    // move a local server entity to the process listening on ip:port
+    // return false if the entity can't move, otherwise callback tells the result later
+    bool migrate(EntityId id, const std::string &ip, int port, MigrationCallback callback = nullptr);
+
+    // deliver a message to an entity wherever it is
+    // local entities get it in their mailbox, entities in handoff buffer it
+    // entities of other processes are found by EntityDirectory, the link of a mirror is used until the directory knows the move
+    bool route_message(EntityId id, uint16_t message_id, const char *data, size_t size);
+
+    size_t get_migrating_count() const { return handoffs_.size(); }
+
+  private:
+    // link to another process, outbound links are created by migrate(), inbound ones are accepted
+    struct Link
+    {
+      std::shared_ptr<Connection> connection;
+      bool connected = false;
+      // messages waiting for the outbound link to connect
+      std::vector<std::pair<uint16_t, std::vector<char>>> pending;
+    };
+
+    // an entity on its way to the target process
+    struct Handoff
+    {
+      EntityId id = kInvalidEntityId;
+      ServerEntityType type = ServerEntityType::kPlayerEntity;
+      std::string target_ip;
+      int target_port = 0;
+      std::shared_ptr<Link> link;
+      // entity state sent to the target, used to take the entity back on failure
+      std::vector<char> state;
+      // session of the entity, moves with the state
+      uint32_t session_generation = 0;
+      // client connection of the entity, kept by the mirror
+      std::shared_ptr<Connection> client_connection;
+      std::vector<std::pair<uint16_t, std::vector<char>>> buffered;
+      size_t dropped = 0;
+      std::chrono::steady_clock::time_point deadline;
+      MigrationCallback callback;
+    };
+
+    // io thread callbacks, move the work to the tick thread
+    bool on_link_accepted(std::shared_ptr<Connection> connection);
+    void watch_link(const std::shared_ptr<Link> &link);
+
+    std::shared_ptr<Link> get_outbound_link(const std::string &ip, int port);
+    void send_to_link(const std::shared_ptr<Link> &link, uint16_t message_id, std::vector<char> payload);
+    void on_link_connected(const std::shared_ptr<Link> &link, bool success);
+
+    void on_link_message(const std::shared_ptr<Link> &link, uint16_t message_id, const std::vector<char> &payload);
+    void on_transfer(const std::shared_ptr<Link> &link, const std::vector<char> &payload);
+    void on_ack(const std::shared_ptr<Link> &link, const std::vector<char> &payload);
+    void on_forward(const std::vector<char> &payload);
+    void on_relay(const std::vector<char> &payload);
+    void on_cancel(const std::vector<char> &payload);
+
+    void finish_handoff(EntityId id, bool success);
+    // create the entity from saved state, return nullptr if the state is broken
+    std::shared_ptr<ServerEntity> restore_entity(EntityId id, ServerEntityType type, uint32_t session_generation, const char *data, size_t size, std::shared_ptr<Connection> client_connection);
+    std::shared_ptr<ServerEntity> create_mirror(EntityId id, const std::string &ip, int port, std::shared_ptr<Connection> client_connection);
+
+    static std::string get_link_key(const std::string &ip, int port) { return ip + ":" + std::to_string(port); }
+
+  private:
+    std::shared_ptr<GameConfig> game_config_;
+    TickScheduler &tick_scheduler_;
+    EntityFactory &entity_factory_ = EntityFactory::get_instance();
+
+    int listen_port_ = 0;
+    std::chrono::milliseconds handoff_timeout_{5000};
+    size_t max_buffered_messages_ = 1024;
+
+    std::unique_ptr<AsioServer> server_;
+    // outbound links by ip:port of the target
+    std::unordered_map<std::string, std::shared_ptr<Link>> outbound_links_;
+    std::vector<std::shared_ptr<Link>> inbound_links_;
+    // links by game ip:port of the process on the other side, learned from acks, matched against EntityDirectory
+    std::unordered_map<std::string, std::shared_ptr<Link>> process_links_;
+    // mirrors left in this process, their link to the target is used until the directory points to it
+    std::unordered_map<EntityId, std::shared_ptr<Link>> mirror_links_;
+    std::unordered_map<EntityId, Handoff> handoffs_;
+  };
+}
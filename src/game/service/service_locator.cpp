@@ -0,0 +1,94 @@
+#include "service_locator.h"
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  // splitmix64 finalizer, ids and sequential keys are spread over the whole ring
+  static uint64_t mix_service_key(uint64_t key)
+  {
+    key += 0x9E3779B97F4A7C15ULL;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+  }
+
+  void ServiceGroup::add(std::shared_ptr<ServerEntity> service)
+  {
+    if (!service)
+    {
+      return;
+    }
+
+    // points of an instance only depend on its id, so other instances keep their keys
+    uint32_t index = static_cast<uint32_t>(instances_.size());
+    for (uint64_t point = 0; point < SERVICE_HASH_RING_POINTS; point++)
+    {
+      ring_.emplace_back(mix_service_key(service->get_id() * SERVICE_HASH_RING_POINTS + point), index);
+    }
+    std::sort(ring_.begin(), ring_.end());
+    instances_.emplace_back(std::move(service));
+  }
+
+  ServerEntity *ServiceGroup::route(uint64_t key)
+  {
+    if (instances_.empty())
+    {
+      return nullptr;
+    }
+    if (instances_.size() == 1)
+    {
+      return instances_.front().get();
+    }
+
+    switch (routing_)
+    {
+    case ServiceRouting::kLeastLoaded:
+    {
+      auto iter = std::min_element(instances_.begin(), instances_.end(), [](const auto &a, const auto &b)
+                                   { return a->get_load() < b->get_load(); });
+      return iter->get();
+    }
+    case ServiceRouting::kConsistentHash:
+    {
+      auto iter = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(mix_service_key(key), uint32_t(0)));
+      if (iter == ring_.end())
+      {
+        iter = ring_.begin();
+      }
+      return instances_[iter->second].get();
+    }
+    case ServiceRouting::kRoundRobin:
+    default:
+    {
+      ServerEntity *service = instances_[next_].get();
+      next_ = (next_ + 1) % instances_.size();
+      return service;
+    }
+    }
+  }
+
+  ServerEntity *ServiceGroup::find(EntityId id) const
+  {
+    for (const auto &service : instances_)
+    {
+      if (service->get_id() == id)
+      {
+        return service.get();
+      }
+    }
+    return nullptr;
+  }
+
+  ServiceRouting ServiceGroup::get_routing_from_string(const std::string &routing)
+  {
+    if (routing == "least_loaded")
+    {
+      return ServiceRouting::kLeastLoaded;
+    }
+    else if (routing == "consistent_hash")
+    {
+      return ServiceRouting::kConsistentHash;
+    }
+    return ServiceRouting::kRoundRobin;
+  }
+}
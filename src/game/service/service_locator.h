@@ -0,0 +1,88 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: typed lookup of local game services and routing between instances of one service
+#pragma once
+
+#include "game/basic/server_entity.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// points of one instance on the consistent hash ring, more points spread keys more evenly
+#define SERVICE_HASH_RING_POINTS 64
+
+namespace multiplayer_server
+{
+  // every service class has a fixed slot, declare it as static constexpr ServiceSlot kServiceSlot
+  enum class ServiceSlot : uint8_t
+  {
+    kLoginService,
+    kMigrationService,
+    kCount,
+  };
+
+  // how requests are spread over instances of a service
+  enum class ServiceRouting : uint8_t
+  {
+    kRoundRobin,
+    kLeastLoaded,
+    // the same key goes to the same instance, adding an instance only moves a share of the keys
+    kConsistentHash,
+  };
+
+  // all local instances of one service, only used by the tick thread after services are created
+  class ServiceGroup
+  {
+  public:
+    void add(std::shared_ptr<ServerEntity> service);
+
+    void set_routing(ServiceRouting routing) { routing_ = routing; }
+    ServiceRouting get_routing() const { return routing_; }
+
+    // instance for the next request, the key is only used by consistent hash, nullptr if the group is empty
+    ServerEntity *route(uint64_t key);
+
+    // first instance, nullptr if the group is empty
+    ServerEntity *front() const { return instances_.empty() ? nullptr : instances_.front().get(); }
+    // nullptr if no instance has the id
+    ServerEntity *find(EntityId id) const;
+    const std::vector<std::shared_ptr<ServerEntity>> &get_instances() const { return instances_; }
+    bool empty() const { return instances_.empty(); }
+
+    // unknown names are round robin
+    static ServiceRouting get_routing_from_string(const std::string &routing);
+
+  private:
+    std::vector<std::shared_ptr<ServerEntity>> instances_;
+    ServiceRouting routing_ = ServiceRouting::kRoundRobin;
+    size_t next_ = 0;
+    // sorted hash points and the instance index of each point
+    std::vector<std::pair<uint64_t, uint32_t>> ring_;
+  };
+
+  // service lookup by type is one array index, no string and no dynamic_cast
+  // groups are filled before the world tick starts and read only afterwards, except routing state of the tick thread
+  class ServiceLocator
+  {
+  public:
+    ServiceGroup &get_group(ServiceSlot slot) { return groups_[static_cast<size_t>(slot)]; }
+    const ServiceGroup &get_group(ServiceSlot slot) const { return groups_[static_cast<size_t>(slot)]; }
+
+    template <typename T>
+    bool has() const { return !get_group(T::kServiceSlot).empty(); }
+
+    // first instance of the service, nullptr if it's not created
+    template <typename T>
+    T *get() const { return static_cast<T *>(get_group(T::kServiceSlot).front()); }
+
+    // instance picked by the routing of the service, nullptr if it's not created
+    template <typename T>
+    T *route(uint64_t key = 0) { return static_cast<T *>(get_group(T::kServiceSlot).route(key)); }
+
+  private:
+    std::array<ServiceGroup, static_cast<size_t>(ServiceSlot::kCount)> groups_;
+  };
+}
@@ -0,0 +1,320 @@
+#include "session_manager.h"
+#include "config/game_config.h"
+#include "game/basic/server_entity.h"
+#include "game/basic/entity_factory.h"
+#include "game/component/network_component.h"
+#include "game/io/io_bridge.h"
+#include "game/property/property.h"
+#include <boost/uuid/detail/sha1.hpp>
+#include <random>
+
+namespace multiplayer_server
+{
+  using Sha1Digest = std::array<uint8_t, 20>;
+
+  static Sha1Digest get_sha1_digest(boost::uuids::detail::sha1 &sha)
+  {
+    boost::uuids::detail::sha1::digest_type digest;
+    sha.get_digest(digest);
+
+    Sha1Digest result{};
+    constexpr size_t kWordCount = sizeof(digest) / sizeof(digest[0]);
+    if constexpr (kWordCount == 5)
+    {
+      // older boost gives five 32 bit words
+      for (size_t i = 0; i < 5; i++)
+      {
+        for (size_t j = 0; j < 4; j++)
+        {
+          result[i * 4 + j] = static_cast<uint8_t>((digest[i] >> (24 - j * 8)) & 0xff);
+        }
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < result.size(); i++)
+      {
+        result[i] = static_cast<uint8_t>(digest[i]);
+      }
+    }
+    return result;
+  }
+
+  // rfc 2104 with a 64 byte block
+  static Sha1Digest hmac_sha1(const std::vector<uint8_t> &key, const uint8_t *data, size_t size)
+  {
+    std::array<uint8_t, 64> block{};
+    if (key.size() > block.size())
+    {
+      boost::uuids::detail::sha1 sha;
+      sha.process_bytes(key.data(), key.size());
+      Sha1Digest hashed = get_sha1_digest(sha);
+      std::copy(hashed.begin(), hashed.end(), block.begin());
+    }
+    else
+    {
+      std::copy(key.begin(), key.end(), block.begin());
+    }
+
+    std::array<uint8_t, 64> pad;
+    for (size_t i = 0; i < block.size(); i++)
+    {
+      pad[i] = block[i] ^ 0x36;
+    }
+    boost::uuids::detail::sha1 inner;
+    inner.process_bytes(pad.data(), pad.size());
+    inner.process_bytes(data, size);
+    Sha1Digest inner_digest = get_sha1_digest(inner);
+
+    for (size_t i = 0; i < block.size(); i++)
+    {
+      pad[i] = block[i] ^ 0x5c;
+    }
+    boost::uuids::detail::sha1 outer;
+    outer.process_bytes(pad.data(), pad.size());
+    outer.process_bytes(inner_digest.data(), inner_digest.size());
+    return get_sha1_digest(outer);
+  }
+
+  static bool is_mirror(Entity *entity)
+  {
+    auto server_entity = dynamic_cast<ServerEntity *>(entity);
+    return server_entity && server_entity->get_server_type() == ServerEntity::ServerEntityType::kMirrorEntity;
+  }
+
+  // never destructed, entities destroyed during static destruction still close their sessions
+  SessionManager &SessionManager::get_instance()
+  {
+    static SessionManager *instance = new SessionManager();
+    return *instance;
+  }
+
+  SessionManager::SessionManager()
+  {
+    logger_ = g_logger_manager.create_logger("Session", LoggerLevel::Debug, "log/Session.log");
+  }
+
+  void SessionManager::configure(const SessionConfig &config)
+  {
+    grace_period_ = static_cast<float>(config.grace_period);
+    max_buffered_messages_ = static_cast<size_t>(config.max_buffered_messages);
+
+    secret_.assign(config.secret.begin(), config.secret.end());
+    if (secret_.empty())
+    {
+      std::random_device random;
+      secret_.resize(32);
+      for (auto &byte : secret_)
+      {
+        byte = static_cast<uint8_t>(random());
+      }
+    }
+  }
+
+  SessionManager::Token SessionManager::make_token(EntityId id, uint32_t generation) const
+  {
+    PropertyWriter writer;
+    writer.write(id);
+    writer.write(generation);
+
+    Token token{};
+    const uint8_t *fields = reinterpret_cast<const uint8_t *>(writer.data());
+    std::copy(fields, fields + writer.size(), token.begin());
+    Sha1Digest mac = hmac_sha1(secret_, fields, writer.size());
+    std::copy(mac.begin(), mac.end(), token.begin() + writer.size());
+    return token;
+  }
+
+  void SessionManager::send_token(NetworkComponent &network_component, Session &session)
+  {
+    Token token = make_token(network_component.get_owner()->get_id(), session.generation);
+    network_component.send(SESSION_TOKEN_MESSAGE_ID, token.data(), token.size(), SendLane::kControl);
+  }
+
+  void SessionManager::open(NetworkComponent &network_component)
+  {
+    Entity *entity = network_component.get_owner();
+    if (!is_enabled() || !entity || is_mirror(entity))
+    {
+      return;
+    }
+
+    Session &session = sessions_[entity->get_id()];
+    session.generation++;
+    session.owner = entity->get_handle();
+    send_token(network_component, session);
+  }
+
+  void SessionManager::close(EntityId id, EntityHandle owner)
+  {
+    auto iter = sessions_.find(id);
+    if (iter == sessions_.end() || (owner.is_valid() && iter->second.owner != owner))
+    {
+      return;
+    }
+
+    if (iter->second.suspended)
+    {
+      suspended_count_--;
+    }
+    sessions_.erase(iter);
+  }
+
+  bool SessionManager::is_suspended(EntityId id) const
+  {
+    auto iter = sessions_.find(id);
+    return iter != sessions_.end() && iter->second.suspended;
+  }
+
+  uint32_t SessionManager::detach(EntityId id)
+  {
+    auto iter = sessions_.find(id);
+    if (iter == sessions_.end())
+    {
+      return 0;
+    }
+
+    uint32_t generation = iter->second.generation;
+    close(id);
+    return generation;
+  }
+
+  void SessionManager::attach(NetworkComponent &network_component, uint32_t generation)
+  {
+    Entity *entity = network_component.get_owner();
+    if (!is_enabled() || !entity || is_mirror(entity) || generation == 0)
+    {
+      return;
+    }
+
+    Session &session = sessions_[entity->get_id()];
+    session.generation = generation;
+    session.owner = entity->get_handle();
+  }
+
+  bool SessionManager::suspend(NetworkComponent &network_component)
+  {
+    Entity *entity = network_component.get_owner();
+    auto iter = entity && !is_mirror(entity) ? sessions_.find(entity->get_id()) : sessions_.end();
+    if (iter == sessions_.end())
+    {
+      return false;
+    }
+
+    Session &session = iter->second;
+    if (session.suspended)
+    {
+      return true;
+    }
+
+    EntityId id = entity->get_id();
+    network_component.suspend(max_buffered_messages_);
+    session.suspended = true;
+    suspended_count_++;
+    // cancelled with the entity, so it never fires for a destroyed one
+    session.grace_timer = entity->add_timer(grace_period_, [this, id]()
+                                            { expire(id); });
+    logger_->debug("SessionManager: entity {} suspended for {} seconds", id, grace_period_);
+    return true;
+  }
+
+  void SessionManager::expire(EntityId id)
+  {
+    close(id);
+
+    auto &entity_factory = EntityFactory::get_instance();
+    auto entity = entity_factory.get_entity(id);
+    if (!entity)
+    {
+      return;
+    }
+
+    // the client is gone for good, same as a disconnect without session
+    if (auto network_component = entity->get_component<NetworkComponent>())
+    {
+      network_component->handle_disconnect();
+    }
+    entity_factory.destroy_entity(id);
+    logger_->debug("SessionManager: entity {} expired", id);
+  }
+
+  bool SessionManager::resume(const char *data, size_t size, NetworkComponent &holder)
+  {
+    Entity *holder_entity = holder.get_owner();
+    std::shared_ptr<Connection> connection = holder.get_connection();
+    if (!holder_entity || !connection)
+    {
+      return false;
+    }
+
+    auto refuse = [&holder](EntityId id)
+    {
+      PropertyWriter writer;
+      writer.write(static_cast<uint8_t>(0));
+      writer.write(id);
+      holder.send(SESSION_RESUME_RESULT_MESSAGE_ID, writer.data(), writer.size(), SendLane::kControl);
+      return false;
+    };
+
+    PropertyReader reader(data, size);
+    EntityId id = kInvalidEntityId;
+    uint32_t generation = 0;
+    if (!is_enabled() || size != kTokenSize || !reader.read(id) || !reader.read(generation))
+    {
+      return refuse(kInvalidEntityId);
+    }
+
+    // compare all bytes, the time taken doesn't tell how much of the mac is right
+    Token expected = make_token(id, generation);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < kTokenSize; i++)
+    {
+      difference |= static_cast<uint8_t>(expected[i] ^ static_cast<uint8_t>(data[i]));
+    }
+
+    auto iter = sessions_.find(id);
+    if (difference != 0 || iter == sessions_.end() || !iter->second.suspended || iter->second.generation != generation)
+    {
+      logger_->warn("SessionManager: refuse resume of entity {}", id);
+      return refuse(id);
+    }
+
+    auto &entity_factory = EntityFactory::get_instance();
+    auto entity = entity_factory.get_entity(id);
+    NetworkComponent *network_component = entity ? entity->get_component<NetworkComponent>() : nullptr;
+    if (!network_component || entity.get() == holder_entity || is_mirror(entity.get()))
+    {
+      return refuse(id);
+    }
+    if (network_component->is_overflowed())
+    {
+      // it missed too much to catch up, end it now instead of at the end of the grace period
+      expire(id);
+      return refuse(id);
+    }
+
+    Session &session = iter->second;
+    entity->cancel_timer(session.grace_timer);
+    session.suspended = false;
+    suspended_count_--;
+
+    // the entity created for the new connection leaves as if its client disconnected
+    holder.set_connection(nullptr);
+    holder.handle_disconnect();
+    entity_factory.destroy_entity(holder_entity->get_id());
+
+    // the result and a new token go first on the control lane, then the missed messages are replayed
+    // in their own lanes, control has priority so the client never sees a missed message before the result
+    PropertyWriter writer;
+    writer.write(static_cast<uint8_t>(1));
+    writer.write(id);
+    IoBridge::get_instance().send(connection, SESSION_RESUME_RESULT_MESSAGE_ID, writer.data(), writer.size(), SendLane::kControl);
+    session.generation++;
+    Token token = make_token(id, session.generation);
+    IoBridge::get_instance().send(connection, SESSION_TOKEN_MESSAGE_ID, token.data(), token.size(), SendLane::kControl);
+    network_component->set_connection(connection);
+
+    logger_->debug("SessionManager: entity {} resumed on connection {}", id, connection->get_connection_id());
+    return true;
+  }
+}
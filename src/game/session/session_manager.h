@@ -0,0 +1,99 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: resumable client sessions, a client reconnecting within the grace period gets its entity back
+#pragma once
+
+#include "game/basic/entity_handle.h"
+#include "game/basic/entity_id.h"
+#include "game/timer/timer_wheel.h"
+#include "log/logger.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// server -> client: resume token, send it back by SESSION_RESUME_MESSAGE_ID on a new connection
+#define SESSION_TOKEN_MESSAGE_ID 0x0300
+// client -> server: resume token, the first message of a new connection
+#define SESSION_RESUME_MESSAGE_ID 0x0301
+// server -> client: uint8 accepted | uint64 entity id, a new token and the missed messages follow if accepted
+#define SESSION_RESUME_RESULT_MESSAGE_ID 0x0302
+
+namespace multiplayer_server
+{
+  class NetworkComponent;
+  struct SessionConfig;
+
+  // token: uint64 entity id | uint32 generation | hmac-sha1 of the fields before, 32 bytes in all
+  // a token is accepted once, only within the grace period after its client disconnected
+  // every accepted token is replaced by a new one, so a leaked token is useless after the next resume
+  // not thread safe, only used by the tick thread
+  class SessionManager
+  {
+  public:
+    static constexpr size_t kTokenSize = sizeof(uint64_t) + sizeof(uint32_t) + 20;
+    using Token = std::array<uint8_t, kTokenSize>;
+
+  public:
+    static SessionManager &get_instance();
+
+    // call it before the world tick starts
+    void configure(const SessionConfig &config);
+    bool is_enabled() const { return grace_period_ > 0.0f; }
+
+    // start a session of a logged in entity and send its token to the client
+    void open(NetworkComponent &network_component);
+    // forget the session, called when the entity is destroyed
+    // with a valid owner, a session taken over by a newer entity of the same id is kept
+    void close(EntityId id, EntityHandle owner = EntityHandle());
+
+    // the entity moves to another process, take its session out and return the generation to send
+    // with the entity state, 0 if it has none. the processes must share the secret for the token to stay valid
+    uint32_t detach(EntityId id);
+    // the entity moved in, keep the session it had so the token its client holds still resumes it
+    void attach(NetworkComponent &network_component, uint32_t generation);
+
+    // the client of the entity is gone, keep the entity for the grace period
+    // return false if the entity has no session, the caller tears it down at once
+    // mirrors share the id of the real entity but never own its session
+    bool suspend(NetworkComponent &network_component);
+
+    // move the connection of holder to the entity of the token and send the messages it missed
+    // the entity created for the new connection is destroyed, return false if the token is refused
+    bool resume(const char *data, size_t size, NetworkComponent &holder);
+
+    bool is_suspended(EntityId id) const;
+
+    size_t get_session_count() const { return sessions_.size(); }
+    size_t get_suspended_count() const { return suspended_count_; }
+
+  private:
+    SessionManager();
+
+    struct Session
+    {
+      uint32_t generation = 0;
+      bool suspended = false;
+      // entity the session belongs to
+      EntityHandle owner;
+      TimerHandle grace_timer;
+    };
+
+    Token make_token(EntityId id, uint32_t generation) const;
+    void send_token(NetworkComponent &network_component, Session &session);
+    // the grace period ended before the client came back
+    void expire(EntityId id);
+
+  private:
+    std::shared_ptr<LoggerImp> logger_;
+    float grace_period_ = 0.0f;
+    size_t max_buffered_messages_ = 0;
+    std::vector<uint8_t> secret_;
+
+    std::unordered_map<EntityId, Session> sessions_;
+    size_t suspended_count_ = 0;
+  };
+}
@@ -0,0 +1,215 @@
+#include "tick_scheduler.h"
+#include <algorithm>
+#include <thread>
+
+namespace multiplayer_server
+{
+  static int64_t to_microseconds(std::chrono::steady_clock::duration duration)
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  }
+
+  // add one finished tick into stats
+  static void add_tick(TickStats &stats, int64_t duration, bool overrun, const std::array<int64_t, static_cast<size_t>(TickPhase::kCount)> &phase_durations)
+  {
+    stats.tick_count++;
+    stats.last_duration = duration;
+    stats.max_duration = std::max(stats.max_duration, duration);
+    stats.total_duration += duration;
+    stats.overrun_count += overrun ? 1 : 0;
+    for (size_t phase = 0; phase < phase_durations.size(); phase++)
+    {
+      stats.phase_durations[phase] += phase_durations[phase];
+    }
+  }
+
+  TickScheduler::TickScheduler(int tick_rate, int max_catch_up_ticks)
+      : tick_rate_(std::max(tick_rate, 1)),
+        max_catch_up_ticks_(std::max(max_catch_up_ticks, 1))
+  {
+    tick_interval_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / tick_rate_));
+    tick_delta_ = 1.0f / static_cast<float>(tick_rate_);
+    logger_ = g_logger_manager.create_logger("TickScheduler", LoggerLevel::Debug, "log/TickScheduler.log");
+  }
+
+  bool TickScheduler::register_phase_handler(TickPhase phase, const std::string &name, PhaseHandler handler)
+  {
+    auto &handlers = phase_handlers_[static_cast<size_t>(phase)];
+    for (const auto &item : handlers)
+    {
+      if (item.first == name)
+      {
+        return false;
+      }
+    }
+
+    handlers.emplace_back(name, std::move(handler));
+    return true;
+  }
+
+  bool TickScheduler::unregister_phase_handler(TickPhase phase, const std::string &name)
+  {
+    auto &handlers = phase_handlers_[static_cast<size_t>(phase)];
+    for (auto it = handlers.begin(); it != handlers.end(); ++it)
+    {
+      if (it->first == name)
+      {
+        handlers.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool TickScheduler::register_tick_boundary_handler(const std::string &name, Task handler)
+  {
+    for (const auto &item : boundary_handlers_)
+    {
+      if (item.first == name)
+      {
+        return false;
+      }
+    }
+
+    boundary_handlers_.emplace_back(name, std::move(handler));
+    return true;
+  }
+
+  void TickScheduler::post(Task task)
+  {
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    posted_tasks_.emplace_back(std::move(task));
+  }
+
+  TickStats TickScheduler::get_stats()
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+  }
+
+  void TickScheduler::run()
+  {
+    running_.store(true, std::memory_order_relaxed);
+    logger_->info("tick scheduler start, {} ticks per second", tick_rate_);
+
+    auto next_tick_time = std::chrono::steady_clock::now();
+    last_stats_time_ = next_tick_time;
+
+    while (!stop_requested_.load(std::memory_order_relaxed))
+    {
+      auto now = std::chrono::steady_clock::now();
+      if (now < next_tick_time)
+      {
+        std::this_thread::sleep_until(next_tick_time);
+        continue;
+      }
+
+      // run the due tick, then catch up if the loop is behind
+      int ticks = 0;
+      while (now >= next_tick_time && ticks < max_catch_up_ticks_ && !stop_requested_.load(std::memory_order_relaxed))
+      {
+        if (ticks > 0)
+        {
+          window_stats_.catch_up_count++;
+          std::lock_guard<std::mutex> lock(stats_mutex_);
+          stats_.catch_up_count++;
+        }
+        run_tick();
+        next_tick_time += tick_interval_;
+        ticks++;
+        now = std::chrono::steady_clock::now();
+      }
+
+      // too far behind, skip the missed ticks instead of spiraling
+      if (now >= next_tick_time)
+      {
+        auto skipped = (now - next_tick_time) / tick_interval_ + 1;
+        window_stats_.skipped_count += static_cast<uint64_t>(skipped);
+        {
+          std::lock_guard<std::mutex> lock(stats_mutex_);
+          stats_.skipped_count += static_cast<uint64_t>(skipped);
+        }
+        next_tick_time += tick_interval_ * skipped;
+        logger_->warn("tick {} fall behind, skip {} ticks", tick_count_, skipped);
+      }
+
+      if (stats_interval_.count() > 0 && now - last_stats_time_ >= stats_interval_)
+      {
+        log_stats(now);
+      }
+    }
+
+    // run the tasks posted before stop
+    run_posted_tasks();
+    running_.store(false, std::memory_order_relaxed);
+    logger_->info("tick scheduler stop after {} ticks", tick_count_);
+  }
+
+  void TickScheduler::run_tick()
+  {
+    std::array<int64_t, static_cast<size_t>(TickPhase::kCount)> phase_durations = {};
+    auto tick_start = std::chrono::steady_clock::now();
+    auto phase_start = tick_start;
+
+    for (size_t phase = 0; phase < phase_handlers_.size(); phase++)
+    {
+      if (phase == static_cast<size_t>(TickPhase::kInput))
+      {
+        run_posted_tasks();
+      }
+
+      for (auto &handler : phase_handlers_[phase])
+      {
+        handler.second(tick_delta_);
+      }
+
+      auto phase_end = std::chrono::steady_clock::now();
+      phase_durations[phase] = to_microseconds(phase_end - phase_start);
+      phase_start = phase_end;
+    }
+
+    for (auto &handler : boundary_handlers_)
+    {
+      handler.second();
+    }
+    auto tick_end = std::chrono::steady_clock::now();
+
+    tick_count_++;
+    auto duration = to_microseconds(tick_end - tick_start);
+    bool overrun = tick_end - tick_start > tick_interval_;
+    add_tick(window_stats_, duration, overrun, phase_durations);
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    add_tick(stats_, duration, overrun, phase_durations);
+  }
+
+  void TickScheduler::run_posted_tasks()
+  {
+    {
+      std::lock_guard<std::mutex> lock(task_mutex_);
+      running_tasks_.swap(posted_tasks_);
+    }
+
+    for (auto &task : running_tasks_)
+    {
+      task();
+    }
+    running_tasks_.clear();
+  }
+
+  void TickScheduler::log_stats(std::chrono::steady_clock::time_point now)
+  {
+    const auto &phases = window_stats_.phase_durations;
+    auto tick_count = std::max<int64_t>(static_cast<int64_t>(window_stats_.tick_count), 1);
+    logger_->info("tick stats: {} ticks, avg {}us, max {}us, overrun {}, catch up {}, skipped {}, phase avg input {}us simulate {}us replicate {}us flush {}us",
+                  window_stats_.tick_count, window_stats_.get_average_duration(), window_stats_.max_duration,
+                  window_stats_.overrun_count, window_stats_.catch_up_count, window_stats_.skipped_count,
+                  phases[static_cast<size_t>(TickPhase::kInput)] / tick_count,
+                  phases[static_cast<size_t>(TickPhase::kSimulate)] / tick_count,
+                  phases[static_cast<size_t>(TickPhase::kReplicate)] / tick_count,
+                  phases[static_cast<size_t>(TickPhase::kFlush)] / tick_count);
+
+    window_stats_ = TickStats();
+    last_stats_time_ = now;
+  }
+}
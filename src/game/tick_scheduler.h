@@ -0,0 +1,138 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: fixed timestep world tick scheduler, runs game logic on one thread beside the io threads
+#pragma once
+
+#include "log/logger.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// default ticks per second
+#define DEFAULT_TICK_RATE 30
+// max ticks to run back to back when the loop falls behind, the rest are skipped
+#define DEFAULT_MAX_CATCH_UP_TICKS 5
+// seconds between two tick stats logs
+#define DEFAULT_TICK_STATS_INTERVAL 10
+
+namespace multiplayer_server
+{
+  // every tick runs the phases in this order
+  enum class TickPhase
+  {
+    // apply work posted by io threads, for example new connections and messages
+    kInput,
+    // update entities and components
+    kSimulate,
+    // collect state changes for observers
+    kReplicate,
+    // send outbound data
+    kFlush,
+    kCount,
+  };
+
+  // durations are in microseconds
+  struct TickStats
+  {
+    uint64_t tick_count = 0;
+    // ticks that took longer than the tick interval
+    uint64_t overrun_count = 0;
+    // ticks run back to back to catch up
+    uint64_t catch_up_count = 0;
+    // ticks dropped because the loop fell too far behind
+    uint64_t skipped_count = 0;
+
+    int64_t last_duration = 0;
+    int64_t max_duration = 0;
+    int64_t total_duration = 0;
+    // total duration of every phase
+    std::array<int64_t, static_cast<size_t>(TickPhase::kCount)> phase_durations = {};
+
+    int64_t get_average_duration() const { return tick_count ? total_duration / static_cast<int64_t>(tick_count) : 0; }
+  };
+
+  // run() blocks the calling thread, game logic only runs on this thread
+  // other threads hand work to it through post()
+  class TickScheduler
+  {
+  public:
+    using PhaseHandler = std::function<void(float dt)>;
+    using Task = std::function<void()>;
+
+  public:
+    TickScheduler(int tick_rate = DEFAULT_TICK_RATE, int max_catch_up_ticks = DEFAULT_MAX_CATCH_UP_TICKS);
+    ~TickScheduler() = default;
+
+    // non-copyable
+    TickScheduler(const TickScheduler &) = delete;
+    TickScheduler &operator=(const TickScheduler &) = delete;
+    TickScheduler(TickScheduler &&) = delete;
+    TickScheduler &operator=(TickScheduler &&) = delete;
+
+  public:
+    // handlers of one phase run in register order, register before run() or from the tick thread
+    bool register_phase_handler(TickPhase phase, const std::string &name, PhaseHandler handler);
+    bool unregister_phase_handler(TickPhase phase, const std::string &name);
+
+    // boundary handlers run after all phases of a tick, for work deferred to the end of a tick such as destroying entities
+    bool register_tick_boundary_handler(const std::string &name, Task handler);
+
+    // thread safe, the task runs at the start of the next input phase
+    void post(Task task);
+
+    // run ticks until stop() is called
+    void run();
+    // thread safe and async signal safe, run() returns after the current tick
+    void stop() { stop_requested_.store(true, std::memory_order_relaxed); }
+    bool is_running() const { return running_.load(std::memory_order_relaxed); }
+
+    // log stats every interval seconds, 0 disables it
+    void set_stats_interval(int seconds) { stats_interval_ = std::chrono::seconds(seconds); }
+
+    int get_tick_rate() const { return tick_rate_; }
+    float get_tick_delta() const { return tick_delta_; }
+    uint64_t get_tick_count() const { return tick_count_; }
+    // stats since the scheduler started
+    TickStats get_stats();
+
+  private:
+    // run all phases once
+    void run_tick();
+    void run_posted_tasks();
+    void log_stats(std::chrono::steady_clock::time_point now);
+
+  private:
+    int tick_rate_ = DEFAULT_TICK_RATE;
+    int max_catch_up_ticks_ = DEFAULT_MAX_CATCH_UP_TICKS;
+    std::chrono::steady_clock::duration tick_interval_;
+    float tick_delta_ = 0.0f;
+    uint64_t tick_count_ = 0;
+
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> running_{false};
+
+    std::array<std::vector<std::pair<std::string, PhaseHandler>>, static_cast<size_t>(TickPhase::kCount)> phase_handlers_;
+    std::vector<std::pair<std::string, Task>> boundary_handlers_;
+
+    // tasks posted by other threads, swapped out once per tick
+    std::mutex task_mutex_;
+    std::vector<Task> posted_tasks_;
+    std::vector<Task> running_tasks_;
+
+    // stats are written once per tick
+    std::mutex stats_mutex_;
+    TickStats stats_;
+    // stats of the current log window
+    TickStats window_stats_;
+    std::chrono::steady_clock::duration stats_interval_ = std::chrono::seconds(DEFAULT_TICK_STATS_INTERVAL);
+    std::chrono::steady_clock::time_point last_stats_time_;
+
+    std::shared_ptr<LoggerImp> logger_;
+  };
+}
@@ -0,0 +1,296 @@
+#include "timer_wheel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace multiplayer_server
+{
+  TimerWheel::TimerWheel(float tick_interval)
+  {
+    set_tick_interval(tick_interval);
+    heads_.fill(kNil);
+  }
+
+  TimerWheel &TimerWheel::get_instance()
+  {
+    static TimerWheel instance;
+    return instance;
+  }
+
+  uint64_t TimerWheel::to_ticks(float seconds) const
+  {
+    if (seconds <= 0.0f)
+    {
+      return 0;
+    }
+    // a little tolerance, so 0.1 seconds at 10 ticks per second is 1 tick instead of 2
+    return static_cast<uint64_t>(std::ceil(seconds / tick_interval_ - 1e-4f));
+  }
+
+  TimerHandle TimerWheel::add_timer(float delay, Callback callback, float interval, TimerOwner *owner)
+  {
+    return add_tick_timer(to_ticks(delay), std::move(callback), to_ticks(interval), owner);
+  }
+
+  TimerHandle TimerWheel::add_tick_timer(uint64_t delay_ticks, Callback callback, uint64_t interval_ticks, TimerOwner *owner)
+  {
+    if (!callback)
+    {
+      return TimerHandle();
+    }
+
+    uint32_t index = allocate_node();
+    Node &node = nodes_[index];
+    // fire in the next tick at the earliest
+    node.expire_tick = current_tick_ + std::max<uint64_t>(delay_ticks, 1);
+    node.interval_ticks = interval_ticks;
+    node.callback = std::move(callback);
+
+    if (owner)
+    {
+      node.owner = owner;
+      node.owner_prev = kNil;
+      node.owner_next = owner->head;
+      if (owner->head != kNil)
+      {
+        nodes_[owner->head].owner_prev = index;
+      }
+      owner->head = index;
+      owner->count++;
+    }
+
+    schedule(index);
+    return TimerHandle{index, node.generation};
+  }
+
+  bool TimerWheel::cancel_timer(TimerHandle handle)
+  {
+    if (!is_active(handle))
+    {
+      return false;
+    }
+
+    Node &node = nodes_[handle.index];
+    if (node.firing)
+    {
+      // freed when its callback returns
+      node.cancelled = true;
+      unlink_owner(handle.index);
+      return true;
+    }
+
+    unlink(handle.index);
+    free_node(handle.index);
+    return true;
+  }
+
+  void TimerWheel::cancel_timers(TimerOwner &owner)
+  {
+    while (owner.head != kNil)
+    {
+      cancel_timer(TimerHandle{owner.head, nodes_[owner.head].generation});
+    }
+  }
+
+  bool TimerWheel::is_active(TimerHandle handle) const
+  {
+    return handle.is_valid() && handle.index < nodes_.size() && nodes_[handle.index].generation == handle.generation && !nodes_[handle.index].cancelled;
+  }
+
+  void TimerWheel::advance()
+  {
+    current_tick_++;
+
+    // spread slots of higher levels whose turn comes, top down so a node can pass several levels in one tick
+    uint32_t top_level = 0;
+    while (top_level + 1 < TIMER_WHEEL_LEVEL_COUNT && (current_tick_ & ((1ULL << (TIMER_WHEEL_LEVEL_BITS * (top_level + 1))) - 1)) == 0)
+    {
+      top_level++;
+    }
+    for (uint32_t level = top_level; level > 0; level--)
+    {
+      cascade(level, static_cast<uint32_t>(current_tick_ >> (TIMER_WHEEL_LEVEL_BITS * level)) & kSlotMask);
+    }
+
+    // move the due slot aside, callbacks may add timers into the same slot for the next round
+    uint32_t slot = static_cast<uint32_t>(current_tick_) & kSlotMask;
+    while (heads_[slot] != kNil)
+    {
+      uint32_t index = heads_[slot];
+      unlink(index);
+      link(kExpiringList, index);
+    }
+
+    // callbacks may cancel timers of this batch, they are unlinked from the expiring list
+    while (heads_[kExpiringList] != kNil)
+    {
+      uint32_t index = heads_[kExpiringList];
+      unlink(index);
+      fire(index);
+    }
+  }
+
+  void TimerWheel::fire(uint32_t index)
+  {
+    Node &node = nodes_[index];
+    if (node.owner && node.owner->paused)
+    {
+      // skipped, but repeating timers keep their pace
+      if (node.interval_ticks == 0)
+      {
+        free_node(index);
+        return;
+      }
+      node.expire_tick = current_tick_ + node.interval_ticks;
+      schedule(index);
+      return;
+    }
+
+    // the callback may add timers and grow nodes_, so it's moved out and the node is found by index again
+    node.firing = true;
+    Callback callback = std::move(node.callback);
+    callback();
+
+    Node &fired = nodes_[index];
+    fired.firing = false;
+    if (fired.cancelled || fired.interval_ticks == 0)
+    {
+      free_node(index);
+      return;
+    }
+
+    fired.callback = std::move(callback);
+    fired.expire_tick = current_tick_ + fired.interval_ticks;
+    schedule(index);
+  }
+
+  void TimerWheel::cascade(uint32_t level, uint32_t slot)
+  {
+    uint32_t list = level * kSlotCount + slot;
+    while (heads_[list] != kNil)
+    {
+      uint32_t index = heads_[list];
+      unlink(index);
+      schedule(index);
+    }
+  }
+
+  void TimerWheel::schedule(uint32_t index)
+  {
+    Node &node = nodes_[index];
+    uint64_t delay = node.expire_tick > current_tick_ ? node.expire_tick - current_tick_ : 0;
+
+    // longer than the wheel, wait at the far end and be scheduled again from there
+    constexpr uint64_t max_delay = (1ULL << (TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVEL_COUNT)) - 1;
+    uint64_t expire_tick = current_tick_ + std::min(delay, max_delay);
+
+    uint32_t level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVEL_COUNT && delay >= (1ULL << (TIMER_WHEEL_LEVEL_BITS * (level + 1))))
+    {
+      level++;
+    }
+    uint32_t slot = static_cast<uint32_t>(expire_tick >> (TIMER_WHEEL_LEVEL_BITS * level)) & kSlotMask;
+    link(level * kSlotCount + slot, index);
+  }
+
+  uint32_t TimerWheel::allocate_node()
+  {
+    uint32_t index = 0;
+    if (!free_nodes_.empty())
+    {
+      index = free_nodes_.back();
+      free_nodes_.pop_back();
+    }
+    else
+    {
+      index = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+      nodes_.back().generation = 1;
+    }
+
+    active_count_++;
+    return index;
+  }
+
+  void TimerWheel::free_node(uint32_t index)
+  {
+    unlink_owner(index);
+
+    Node &node = nodes_[index];
+    node.generation = node.generation + 1 ? node.generation + 1 : 1;
+    node.list = kNoList;
+    node.firing = false;
+    node.cancelled = false;
+    node.interval_ticks = 0;
+    // release captures now
+    node.callback = nullptr;
+
+    active_count_--;
+    free_nodes_.push_back(index);
+  }
+
+  void TimerWheel::link(uint32_t list, uint32_t index)
+  {
+    Node &node = nodes_[index];
+    node.list = list;
+    node.prev = kNil;
+    node.next = heads_[list];
+    if (node.next != kNil)
+    {
+      nodes_[node.next].prev = index;
+    }
+    heads_[list] = index;
+  }
+
+  void TimerWheel::unlink(uint32_t index)
+  {
+    Node &node = nodes_[index];
+    if (node.list == kNoList)
+    {
+      return;
+    }
+
+    if (node.prev != kNil)
+    {
+      nodes_[node.prev].next = node.next;
+    }
+    else
+    {
+      heads_[node.list] = node.next;
+    }
+    if (node.next != kNil)
+    {
+      nodes_[node.next].prev = node.prev;
+    }
+
+    node.list = kNoList;
+    node.prev = kNil;
+    node.next = kNil;
+  }
+
+  void TimerWheel::unlink_owner(uint32_t index)
+  {
+    Node &node = nodes_[index];
+    if (!node.owner)
+    {
+      return;
+    }
+
+    if (node.owner_prev != kNil)
+    {
+      nodes_[node.owner_prev].owner_next = node.owner_next;
+    }
+    else
+    {
+      node.owner->head = node.owner_next;
+    }
+    if (node.owner_next != kNil)
+    {
+      nodes_[node.owner_next].owner_prev = node.owner_prev;
+    }
+    node.owner->count--;
+
+    node.owner = nullptr;
+    node.owner_prev = kNil;
+    node.owner_next = kNil;
+  }
+}
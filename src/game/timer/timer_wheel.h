@@ -0,0 +1,137 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: hierarchical timing wheel, thousands of timers fire in batches inside the world tick
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// bits of the slot index of one level, every level has 2^bits slots
+#define TIMER_WHEEL_LEVEL_BITS 8
+// levels of the wheel, 4 levels of 8 bits cover 2^32 ticks
+#define TIMER_WHEEL_LEVEL_COUNT 4
+
+namespace multiplayer_server
+{
+  // index of the timer node plus the generation of the node when the timer was added
+  // the generation changes when the timer fires or is cancelled, so old handles do nothing
+  struct TimerHandle
+  {
+    uint32_t index = 0;
+    // 0 is never used by a live timer
+    uint32_t generation = 0;
+
+    bool is_valid() const { return generation != 0; }
+  };
+
+  // timers of one owner, the owner cancels all of them at once when it's destroyed
+  struct TimerOwner
+  {
+    uint32_t head = UINT32_MAX;
+    size_t count = 0;
+    // timers of a paused owner are kept but their callbacks are skipped, for example an entity waiting to be destructed
+    bool paused = false;
+  };
+
+  // one slot is one tick of the wheel, a timer due in n ticks goes to the lowest level that can hold n
+  // level 0 slots fire in turn, a slot of a higher level is spread into the lower levels when its turn comes
+  // add and cancel are O(1), nodes are linked by index and reused through a free list
+  // not thread safe, a wheel belongs to the thread that advances it, for example the world tick or a room
+  class TimerWheel
+  {
+  public:
+    using Callback = std::function<void()>;
+
+  public:
+    TimerWheel(float tick_interval = 1.0f / 30);
+    ~TimerWheel() = default;
+
+    // non-copyable
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+    TimerWheel(TimerWheel &&) = delete;
+    TimerWheel &operator=(TimerWheel &&) = delete;
+
+    // wheel of the world tick
+    static TimerWheel &get_instance();
+
+    // seconds of one tick, delays are rounded up to whole ticks
+    void set_tick_interval(float tick_interval) { tick_interval_ = tick_interval > 0.0f ? tick_interval : tick_interval_; }
+    float get_tick_interval() const { return tick_interval_; }
+
+    // fire callback after delay seconds, then every interval seconds if interval > 0
+    // the timer is cancelled with the owner if owner is not nullptr
+    TimerHandle add_timer(float delay, Callback callback, float interval = 0.0f, TimerOwner *owner = nullptr);
+    // same as add_timer, but delay and interval are in ticks
+    TimerHandle add_tick_timer(uint64_t delay_ticks, Callback callback, uint64_t interval_ticks = 0, TimerOwner *owner = nullptr);
+
+    // return false if the timer already fired or was cancelled
+    // a repeating timer can cancel itself in its callback
+    bool cancel_timer(TimerHandle handle);
+    // cancel all timers of the owner
+    void cancel_timers(TimerOwner &owner);
+
+    bool is_active(TimerHandle handle) const;
+
+    // move one tick forward and fire all timers due, called once per tick
+    void advance();
+
+    uint64_t get_current_tick() const { return current_tick_; }
+    size_t size() const { return active_count_; }
+
+  private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr uint32_t kSlotCount = 1u << TIMER_WHEEL_LEVEL_BITS;
+    static constexpr uint32_t kSlotMask = kSlotCount - 1;
+    // list of nodes whose callback runs in this tick
+    static constexpr uint32_t kExpiringList = TIMER_WHEEL_LEVEL_COUNT * kSlotCount;
+    static constexpr uint32_t kNoList = kExpiringList + 1;
+
+    struct Node
+    {
+      uint32_t generation = 0;
+      // list the node is in, level * slot count + slot, kExpiringList or kNoList
+      uint32_t list = kNoList;
+      uint32_t prev = kNil;
+      uint32_t next = kNil;
+
+      TimerOwner *owner = nullptr;
+      uint32_t owner_prev = kNil;
+      uint32_t owner_next = kNil;
+
+      uint64_t expire_tick = 0;
+      uint64_t interval_ticks = 0;
+      // callback is running, cancel only marks the node
+      bool firing = false;
+      bool cancelled = false;
+      Callback callback;
+    };
+
+    uint64_t to_ticks(float seconds) const;
+
+    uint32_t allocate_node();
+    void free_node(uint32_t index);
+
+    // put the node into the slot of its expire tick
+    void schedule(uint32_t index);
+    void link(uint32_t list, uint32_t index);
+    void unlink(uint32_t index);
+    void unlink_owner(uint32_t index);
+
+    // move all nodes of a slot of a higher level into lower levels
+    void cascade(uint32_t level, uint32_t slot);
+    void fire(uint32_t index);
+
+  private:
+    float tick_interval_ = 1.0f / 30;
+    uint64_t current_tick_ = 0;
+    size_t active_count_ = 0;
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_nodes_;
+    // heads of all slot lists and the expiring list
+    std::array<uint32_t, kExpiringList + 1> heads_;
+  };
+}
@@ -2,16 +2,32 @@
 #include "log/logger.h"
 #include "network/asio_server.h"
 #include "game/game_main.h"
+#include "config/game_config.h"
 #include <iostream>
 #include <filesystem>
 #include <chrono>
 #include <thread>
 #include <functional>
+#include <csignal>
 
 // except g_logger and g_logger_manager, there is no global instance
 // all other game objects are created in game_main object, Reason:
 // 1. avoid using global instance, it is not thread safe
 // 2. reduce the difficulty of maintaining the code, especially when we need init some objects in a specific order
+namespace
+{
+  // only used by the signal handler, it can't capture anything
+  multiplayer_server::GameMain *s_signal_game_main = nullptr;
+
+  void handle_stop_signal(int)
+  {
+    if (s_signal_game_main)
+    {
+      s_signal_game_main->stop_game_loop();
+    }
+  }
+}
+
 int check_config_file(const std::string &config_file_path)
 {
   using namespace multiplayer_server;
@@ -71,14 +87,43 @@ int main(int argc, const char **argv)
   const auto [ip, port] = game_main->get_ip_port();
   auto asio_server = std::make_unique<AsioServer>(ip, port, true, false);
   asio_server->set_io_context_thread_count(game_main->get_concurrency());
+  asio_server->set_idle_read_mode(game_main->get_idle_read_mode());
+  if (auto fault_injection_config = game_main->get_game_config()->get<FaultInjectionConfig>(FAULT_INJECTION_CONFIG_STR))
+  {
+    asio_server->set_fault_injection_config(*fault_injection_config);
+  }
+  if (auto rate_limit_config = game_main->get_game_config()->get<RateLimitConfig>(RATE_LIMIT_CONFIG_STR))
+  {
+    asio_server->set_rate_limit_config(*rate_limit_config);
+  }
+  auto capture_config = game_main->get_game_config()->get<TrafficCaptureConfig>(CAPTURE_CONFIG_STR);
+  if (capture_config && capture_config->enabled)
+  {
+    asio_server->start_traffic_capture(capture_config->file_path);
+  }
+
+  // outbound messages of the world tick are sent by the io threads
+  game_main->start_io_bridge(asio_server->get_io_context());
 
   // register connected callback
   std::function<bool(std::shared_ptr<Connection>)> callback = std::bind(&GameMain::on_client_connected, game_main.get(), std::placeholders::_1);
   asio_server->regist_on_client_connected(callback);
 
-  // start asio server
+  // start asio server, io threads run in background
   asio_server->start();
-  asio_server->wait();
+
+  // stop world tick on ctrl-c or kill
+  s_signal_game_main = game_main.get();
+  std::signal(SIGINT, handle_stop_signal);
+  std::signal(SIGTERM, handle_stop_signal);
+
+  // game logic runs on main thread until stopped
+  game_main->run_game_loop();
+
+  s_signal_game_main = nullptr;
+  asio_server->stop();
+  // io threads and the world tick are stopped, release connections left in the bridge
+  IoBridge::get_instance().reset();
 
   return EXIT_SUCCESS;
 }
\ No newline at end of file
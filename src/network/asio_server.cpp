@@ -1,5 +1,7 @@
 #include "asio_server.h"
 #include "asio_tcp_connection.h"
+#include "fault_injection_connection.h"
+#include "traffic_capture.h"
 
 namespace multiplayer_server
 {
@@ -61,6 +63,12 @@ namespace multiplayer_server
       }
     }
 
+    // write all buffered records
+    if (traffic_capture_)
+    {
+      traffic_capture_->close();
+    }
+
     // finished all threads and io then call game module callback
     if (on_server_closed_callback_)
     {
@@ -72,28 +80,66 @@ namespace multiplayer_server
 
   void AsioServer::start_tcp_accept()
   {
-    // first, resolve the ip address and port
-    boost::asio::ip::tcp::resolver resolver(*io_context_);
-    boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(ip_address_, std::to_string(port_)).begin();
-
-    // create acceptor
-    acceptor_ = std::make_shared<boost::asio::ip::tcp::acceptor>(*io_context_, endpoint);
-    // set reuse address
-    acceptor_->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-    // set no delay
-    acceptor_->set_option(boost::asio::ip::tcp::no_delay(true));
-    // set keep alive
-    acceptor_->set_option(boost::asio::socket_base::keep_alive(true));
+    // create acceptor only once, next accepts reuse it
+    if (!acceptor_)
+    {
+      // first, resolve the ip address and port
+      boost::asio::ip::tcp::resolver resolver(*io_context_);
+      boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(ip_address_, std::to_string(port_)).begin();
+
+      // create acceptor, reuse address must be set before bind
+      acceptor_ = std::make_shared<boost::asio::ip::tcp::acceptor>(*io_context_);
+      acceptor_->open(endpoint.protocol());
+      // set reuse address
+      acceptor_->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+      acceptor_->bind(endpoint);
+      acceptor_->listen();
+      // set no delay
+      acceptor_->set_option(boost::asio::ip::tcp::no_delay(true));
+      // set keep alive
+      acceptor_->set_option(boost::asio::socket_base::keep_alive(true));
+      // log start time and port
+      logger_->info("start tcp accept on {}:{}", ip_address_, port_);
+    }
 
     // create a new connection
     auto connection = std::make_shared<AsioTcpConnection>(ip_address_, port_, io_context_);
+    connection->set_idle_read_mode(idle_read_mode_);
+    connection->set_traffic_capture(traffic_capture_);
+    connection->set_rate_limit_policy(rate_limit_policy_);
+    connection->prepare_accept();
 
     // start accept
     acceptor_->async_accept(*connection->get_socket(), std::bind(&AsioServer::handle_tcp_accept, this, std::placeholders::_1, connection));
     // set status
     status_ = ServerStatus::kRunning;
-    // log start time and port
-    logger_->info("start tcp accept on {}:{}", ip_address_, port_);
+  }
+
+  void AsioServer::set_rate_limit_config(const RateLimitConfig &config)
+  {
+    if (!config.enabled)
+    {
+      rate_limit_policy_.reset();
+      return;
+    }
+
+    // compile once, shared by all connections
+    rate_limit_policy_ = std::make_shared<RateLimitPolicy>(config);
+    logger_->info("limit inbound messages, default rate {} burst {}, {} message rules", config.default_rate, config.default_burst, config.rules.size());
+  }
+
+  bool AsioServer::start_traffic_capture(const std::string &file_path)
+  {
+    auto capture = std::make_shared<TrafficCaptureWriter>();
+    if (!capture->open(file_path))
+    {
+      logger_->error("open traffic capture file {} failed", file_path);
+      return false;
+    }
+
+    traffic_capture_ = capture;
+    logger_->info("record inbound traffic into {}", file_path);
+    return true;
   }
 
   void AsioServer::start_udp_accept()
@@ -116,10 +162,21 @@ namespace multiplayer_server
     // start next accept
     start_tcp_accept();
 
+    connection->on_accepted();
+
+    // wrap the connection if faults should be injected
+    std::shared_ptr<Connection> game_connection = connection;
+    if (auto rule = FaultInjectionConnection::find_rule(fault_injection_config_, connection->get_ip()))
+    {
+      auto fault_connection = std::make_shared<FaultInjectionConnection>(connection, io_context_, *rule);
+      fault_connection->init();
+      game_connection = fault_connection;
+    }
+
     // give connection to game logic module
     if (on_connection_accepted_callback_)
     {
-      if (on_connection_accepted_callback_(std::static_pointer_cast<Connection>(connection)))
+      if (on_connection_accepted_callback_(game_connection))
       {
         // start read
         connection->start_receive();
@@ -144,7 +201,7 @@ namespace multiplayer_server
     int thread_count = io_context_thread_count_;
 
     // create thread pool
-    for (std::size_t i = 0; i < thread_count; i++)
+    for (int i = 0; i < thread_count; i++)
     {
       io_context_threads_pool_.emplace_back([this]()
                                             { 
@@ -3,6 +3,8 @@
 // Purpose: implement a network server based on boost::asio
 #pragma once
 #include "server.h"
+#include "fault_injection.h"
+#include "rate_limiter.h"
 #include "log/logger.h"
 #include <boost/asio.hpp>
 #include <memory>
@@ -14,6 +16,7 @@ namespace multiplayer_server
   // connection forward declaration
   class Connection;
   class AsioTcpConnection;
+  class TrafficCaptureWriter;
 
   class AsioServer : public Server
   {
@@ -22,6 +25,16 @@ namespace multiplayer_server
     virtual ~AsioServer();
 
     virtual bool set_io_context_thread_count(int count) { io_context_thread_count_ = count; return true; }
+    // accepted connections wait for readable without holding a receive buffer
+    void set_idle_read_mode(bool enable) { idle_read_mode_ = enable; }
+    // accepted connections matching a rule are wrapped by FaultInjectionConnection
+    void set_fault_injection_config(const FaultInjectionConfig &config) { fault_injection_config_ = config; }
+    // limit inbound messages of every accepted connection
+    void set_rate_limit_config(const RateLimitConfig &config);
+    // record inbound traffic of all accepted connections into the capture file
+    bool start_traffic_capture(const std::string &file_path);
+    // io context of the server, outbound connections can share its io threads
+    std::shared_ptr<boost::asio::io_context> get_io_context() const { return io_context_; }
     virtual bool start() override;
     virtual bool stop() override;
     void wait();
@@ -50,6 +63,14 @@ namespace multiplayer_server
     // io context thread pool
     std::vector<std::thread> io_context_threads_pool_;
     int io_context_thread_count_ = 2;
+    // idle read mode of accepted connections
+    bool idle_read_mode_ = false;
+    // simulate bad network for benchmark
+    FaultInjectionConfig fault_injection_config_;
+    // record inbound traffic for replay
+    std::shared_ptr<TrafficCaptureWriter> traffic_capture_;
+    // compiled rate limit config, nullptr if rate limit is disabled
+    std::shared_ptr<const RateLimitPolicy> rate_limit_policy_;
     
     // callback game module when a tcp connection is accepted
     std::function<bool(std::shared_ptr<Connection>)> on_connection_accepted_callback_;
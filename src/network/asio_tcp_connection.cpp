@@ -7,20 +7,13 @@
 namespace multiplayer_server
 {
 
+  // if io_context is nullptr, create a new one
   AsioTcpConnection::AsioTcpConnection(const std::string &ip, int port, std::shared_ptr<boost::asio::io_context> io_context)
-      : Connection(ip, port)
+      : Connection(ip, port),
+        io_context_(io_context ? io_context : std::make_shared<boost::asio::io_context>()),
+        strand_(boost::asio::make_strand(*io_context_))
   {
-    // if io_context is nullptr, create a new one
-    if (!io_context)
-    {
-      io_context_ = std::make_shared<boost::asio::io_context>();
-      socket_ = std::make_shared<boost::asio::ip::tcp::socket>(*io_context_);
-    }
-    else
-    {
-      io_context_ = io_context;
-      socket_ = std::make_shared<boost::asio::ip::tcp::socket>(*io_context_);
-    }
+    socket_ = std::make_shared<boost::asio::ip::tcp::socket>(*io_context_);
 
     logger_ = g_logger_manager.create_logger("AsioTcpConnection", LoggerLevel::Debug, "log/AsioTcpConnection.log");
 
@@ -60,6 +53,47 @@ namespace multiplayer_server
     close();
   }
 
+  // acceptor needs a closed socket
+  void AsioTcpConnection::prepare_accept()
+  {
+    boost::system::error_code error;
+    socket_->close(error);
+  }
+
+  void AsioTcpConnection::set_rate_limit_policy(std::shared_ptr<const RateLimitPolicy> policy)
+  {
+    if (policy)
+    {
+      rate_limiter_ = std::make_unique<RateLimiter>(policy);
+    }
+    else
+    {
+      rate_limiter_.reset();
+    }
+  }
+
+  // socket is accepted, options are not inherited from the acceptor on every platform
+  void AsioTcpConnection::on_accepted()
+  {
+    boost::system::error_code error;
+    socket_->set_option(boost::asio::ip::tcp::no_delay(true), error);
+    socket_->set_option(boost::asio::socket_base::keep_alive(true), error);
+
+    // record remote host
+    remote_endpoint_ = socket_->remote_endpoint(error);
+    if (!error)
+    {
+      ip_ = remote_endpoint_.address().to_string();
+      port_ = remote_endpoint_.port();
+    }
+    set_status(ConnectionStatus::kConnected);
+
+    if (traffic_capture_)
+    {
+      traffic_capture_->record(connection_id_, TrafficCaptureEvent::kConnected);
+    }
+  }
+
   // get connection status
   ConnectionStatus AsioTcpConnection::get_status() const
   {
@@ -111,7 +145,7 @@ namespace multiplayer_server
     boost::asio::ip::tcp::resolver::query query(ip_, std::to_string(port_));
     boost::asio::ip::tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 
-    socket_->async_connect(*endpoint_iterator, std::bind(&AsioTcpConnection::handle_connect, this, std::placeholders::_1));
+    socket_->async_connect(*endpoint_iterator, boost::asio::bind_executor(strand_, std::bind(&AsioTcpConnection::handle_connect, this, std::placeholders::_1)));
 
     set_status(ConnectionStatus::kConnecting);
     logger_->debug("async connect to {}:{}", ip_, port_);
@@ -154,85 +188,220 @@ namespace multiplayer_server
     }
   }
 
-  // send data to remote host
+  // send a message to remote host
   // return true if send successfully
-  bool AsioTcpConnection::send(const void *data, size_t size)
+  bool AsioTcpConnection::send(uint16_t message_id, const void *data, size_t size)
   {
-    boost::system::error_code error;
-    socket_->write_some(boost::asio::buffer(data, size), error);
-    if (error)
+    // write all frames of the message, don't mix with async_send on the same connection
+    const char *payload = static_cast<const char *>(data);
+    size_t offset = 0;
+    do
     {
-      logger_->debug("send data to {}:{} failed, size {}", ip_, port_, size);
-      return false;
-    }
+      FrameHeader header;
+      header.size = static_cast<uint32_t>(std::min<size_t>(size - offset, MAX_FRAME_PAYLOAD_SIZE));
+      header.message_id = message_id;
+      header.lane = static_cast<uint8_t>(SendLane::kControl);
+      header.flags = offset + header.size < size ? kFrameFlagMoreFragments : kFrameFlagNone;
+      auto encoded = header.encode();
+
+      std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(encoded),
+        boost::asio::buffer(payload + offset, header.size)};
+
+      boost::system::error_code error;
+      boost::asio::write(*socket_, buffers, error);
+      if (error)
+      {
+        logger_->debug("send data to {}:{} failed, size {}", ip_, port_, size);
+        return false;
+      }
+      offset += header.size;
+    } while (offset < size);
+
     logger_->debug("send data to {}:{} successfully, size {}", ip_, port_, size);
     return true;
   }
 
-  // async send data to remote host
-  // return true if send successfully
-  bool AsioTcpConnection::async_send(const void *data, size_t size)
+  // async send a message to remote host
+  // return true if the message is queued
+  bool AsioTcpConnection::async_send(uint16_t message_id, const void *data, size_t size, SendLane lane)
   {
-    // first, add to send buffer list
-    if (send_buffer_.size() > 0)
+    if (lane >= SendLane::kCount)
     {
-      send_buffer_.emplace_back(data, size);
+      logger_->error("async send data to {}:{} with invalid lane {}", ip_, port_, static_cast<int>(lane));
       return false;
     }
 
-    // second, check if is sending
-    if (is_sending_)
+    if (size > MAX_MESSAGE_SIZE)
     {
-      logger_->error("async send data add to queue, but queue size is {}", send_buffer_.size());
-
-      // add to send queue and wait for send
-      send_buffer_.emplace_back(data, size);
+      logger_->error("async send data to {}:{} failed, message size {} is too large", ip_, port_, size);
       return false;
     }
 
-    is_sending_ = true;
-    socket_->async_write_some(send_buffer_.front(),
-                             std::bind(&AsioTcpConnection::handle_send, this,
-                                         std::placeholders::_1,
-                                         std::placeholders::_2));
-    logger_->debug("async send data to {}:{} size {}", ip_, port_, size);
-     return true;
+    {
+      std::lock_guard<std::mutex> lock(send_mutex_);
+
+      // first, copy the message into the send queue of the lane
+      OutgoingMessage message;
+      message.message_id = message_id;
+      message.payload.assign(static_cast<const char *>(data), static_cast<const char *>(data) + size);
+      send_lanes_[static_cast<size_t>(lane)].emplace_back(std::move(message));
+
+      // second, if is sending, the message will be sent when current batch finished
+      if (is_sending_)
+      {
+        return true;
+      }
+      is_sending_ = true;
+    }
+
+    // then, start to send on the strand, the socket is never used by two threads at once
+    // io bridge already runs on the strand, so its messages start at once
+    boost::asio::dispatch(strand_, [this]()
+                          {
+      std::lock_guard<std::mutex> lock(send_mutex_);
+      if (build_send_batch())
+      {
+        start_send_batch();
+      }
+      else
+      {
+        is_sending_ = false;
+      } });
+    return true;
   }
 
-  // async send handler
-  void AsioTcpConnection::handle_send(const boost::system::error_code &error, size_t bytes_transferred)
+  void AsioTcpConnection::post(std::function<void()> task)
   {
-    // first, set sending flag to false
-    is_sending_ = false;
+    boost::asio::post(strand_, std::move(task));
+  }
+
+  // build next gathered write
+  // control lane is sent first, then realtime lane and bulk lane are sent by weight
+  bool AsioTcpConnection::build_send_batch()
+  {
+    sending_headers_.clear();
+    sending_buffers_.clear();
+    sending_messages_.clear();
+    sending_bytes_ = 0;
 
-    // second, check if has data in send buffer
-    // if no error, pop sent data at the front of send_buffer_
-    if (send_buffer_.size() > 0)
+    // headers are referenced by buffers, don't reallocate while building
+    sending_headers_.reserve(MAX_SEND_BATCH_FRAMES);
+
+    // control lane, strict priority
+    while (append_send_frame(SendLane::kControl, MAX_FRAME_PAYLOAD_SIZE))
     {
-      if (!error)
+    }
+
+    // realtime lane and bulk lane, weighted round robin
+    auto &realtime_lane = send_lanes_[static_cast<size_t>(SendLane::kRealtime)];
+    auto &bulk_lane = send_lanes_[static_cast<size_t>(SendLane::kBulk)];
+    while (!realtime_lane.empty() || !bulk_lane.empty())
+    {
+      bool appended = false;
+      for (size_t i = 0; i < realtime_lane_weight_; i++)
       {
-        send_buffer_.pop_front();
+        if (!append_send_frame(SendLane::kRealtime, MAX_FRAME_PAYLOAD_SIZE))
+        {
+          break;
+        }
+        appended = true;
+      }
+
+      // only one fragment of bulk lane every round, so a big message cannot block realtime lane
+      if (append_send_frame(SendLane::kBulk, bulk_fragment_size_))
+      {
+        appended = true;
+      }
+
+      // batch is full
+      if (!appended)
+      {
+        break;
       }
     }
 
-    // then, send next data in send buffer, maybe resend failed data
-    if (send_buffer_.size() > 0)
+    return !sending_buffers_.empty();
+  }
+
+  // add next frame of the front message of the lane into the batch
+  bool AsioTcpConnection::append_send_frame(SendLane lane, size_t max_fragment_size)
+  {
+    auto &messages = send_lanes_[static_cast<size_t>(lane)];
+    if (messages.empty())
     {
-      is_sending_ = true;
-      socket_->async_write_some(send_buffer_.front(),
-                                std::bind(&AsioTcpConnection::handle_send, this,
-                                          std::placeholders::_1,
-                                          std::placeholders::_2));
-      logger_->debug("async send data to {}:{} size {}", ip_, port_, send_buffer_.front().size());
+      return false;
+    }
+
+    // batch is full, always send at least one frame
+    if (sending_headers_.size() >= MAX_SEND_BATCH_FRAMES)
+    {
+      return false;
+    }
+    if (!sending_headers_.empty() && sending_bytes_ >= MAX_SEND_BATCH_SIZE)
+    {
+      return false;
+    }
+
+    auto &message = messages.front();
+    size_t remain = message.payload.size() - message.offset;
+
+    FrameHeader header;
+    header.size = static_cast<uint32_t>(std::min(remain, max_fragment_size));
+    header.message_id = message.message_id;
+    header.lane = static_cast<uint8_t>(lane);
+    header.flags = header.size < remain ? kFrameFlagMoreFragments : kFrameFlagNone;
+
+    sending_headers_.emplace_back(header.encode());
+    sending_buffers_.emplace_back(boost::asio::buffer(sending_headers_.back()));
+    if (header.size > 0)
+    {
+      // vector data is not moved when the message is moved, so the buffer is valid until the batch finished
+      sending_buffers_.emplace_back(boost::asio::buffer(message.payload.data() + message.offset, header.size));
+    }
+    message.offset += header.size;
+    sending_bytes_ += FRAME_HEADER_SIZE + header.size;
+
+    // last frame of the message, keep the message alive until the batch finished
+    if (!(header.flags & kFrameFlagMoreFragments))
+    {
+      sending_messages_.emplace_back(std::move(message));
+      messages.pop_front();
     }
+    return true;
+  }
+
+  // start gathered write of the batch
+  void AsioTcpConnection::start_send_batch()
+  {
+    is_sending_ = true;
+    boost::asio::async_write(*socket_, sending_buffers_,
+                             boost::asio::bind_executor(strand_, std::bind(&AsioTcpConnection::handle_send, this,
+                                                                           std::placeholders::_1,
+                                                                           std::placeholders::_2)));
+  }
 
+  // async send handler
+  void AsioTcpConnection::handle_send(const boost::system::error_code &error, size_t bytes_transferred)
+  {
     if (error)
     {
-      logger_->debug("async send data to {}:{} failed, size {} error code {} try close", ip_, port_, error.message(), bytes_transferred);
+      logger_->debug("async send data to {}:{} failed, size {} error code {} try close", ip_, port_, bytes_transferred, error.message());
+      {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        is_sending_ = false;
+      }
+      close();
+      return;
     }
-    else
+
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    is_sending_ = false;
+
+    // send next batch
+    if (build_send_batch())
     {
-      logger_->debug("async send data to {}:{} successfully, size {}", ip_, port_, bytes_transferred);
+      start_send_batch();
     }
   }
 
@@ -255,10 +424,24 @@ namespace multiplayer_server
   // start receive from remote host
   void AsioTcpConnection::start_receive()
   {
-    socket_->async_read_some(boost::asio::buffer(receive_buffer_, MAX_BUFFER_SIZE),
-                             std::bind(&AsioTcpConnection::handle_receive, this,
-                                         std::placeholders::_1,
-                                         std::placeholders::_2));
+    // idle read mode, only wait for readable, no buffer is pinned by the pending operation
+    if (idle_read_mode_)
+    {
+      socket_->async_wait(boost::asio::ip::tcp::socket::wait_read,
+                          boost::asio::bind_executor(strand_, std::bind(&AsioTcpConnection::handle_wait_read, this,
+                                                                        std::placeholders::_1)));
+      return;
+    }
+
+    if (!receive_buffer_)
+    {
+      receive_buffer_ = BufferPool::get_receive_pool().acquire();
+    }
+
+    socket_->async_read_some(boost::asio::buffer(receive_buffer_.get(), BufferPool::get_receive_pool().get_buffer_size()),
+                             boost::asio::bind_executor(strand_, std::bind(&AsioTcpConnection::handle_receive, this,
+                                                                           std::placeholders::_1,
+                                                                           std::placeholders::_2)));
   }
 
   // handle async receive data
@@ -271,9 +454,69 @@ namespace multiplayer_server
       return;
     }
 
+    // deliver data before next read, next read will reuse the same buffer
+    on_received(receive_buffer_.get(), bytes_transferred);
+
+    if (status_ == ConnectionStatus::kClosed)
+    {
+      return;
+    }
+
     start_receive();
+  }
+
+  // socket is readable, borrow a buffer and read all data already received by kernel
+  void AsioTcpConnection::handle_wait_read(const boost::system::error_code &error)
+  {
+    if (error)
+    {
+      logger_->debug("wait readable from {}:{} failed, error code {}", ip_, port_, error.message());
+      close();
+      return;
+    }
+
+    {
+      auto buffer = BufferPool::get_receive_pool().acquire();
+      size_t buffer_size = BufferPool::get_receive_pool().get_buffer_size();
 
-    on_received(receive_buffer_.data(), bytes_transferred);
+      // read without blocking until kernel buffer is empty
+      // blocking mode is restored before data is delivered, handlers may call the blocking send()
+      while (status_ != ConnectionStatus::kClosed)
+      {
+        boost::system::error_code read_error;
+        boost::system::error_code mode_error;
+        socket_->non_blocking(true, mode_error);
+        size_t bytes_transferred = socket_->read_some(boost::asio::buffer(buffer.get(), buffer_size), read_error);
+        socket_->non_blocking(false, mode_error);
+        if (read_error == boost::asio::error::would_block || read_error == boost::asio::error::try_again)
+        {
+          break;
+        }
+
+        if (read_error)
+        {
+          logger_->debug("receive data from {}:{} failed, error code {}", ip_, port_, read_error.message());
+          close();
+          return;
+        }
+
+        on_received(buffer.get(), bytes_transferred);
+
+        // buffer is not full, kernel buffer is drained
+        if (bytes_transferred < buffer_size)
+        {
+          break;
+        }
+      }
+      // buffer goes back to the pool here, before waiting again
+    }
+
+    if (status_ == ConnectionStatus::kClosed)
+    {
+      return;
+    }
+
+    start_receive();
   }
 
   // close connection
@@ -288,6 +531,11 @@ namespace multiplayer_server
     socket_->close(error);
     set_status(ConnectionStatus::kClosed);
 
+    if (traffic_capture_)
+    {
+      traffic_capture_->record(connection_id_, TrafficCaptureEvent::kDisconnected);
+    }
+
     // call disconnected callback
     if (disconnected_callback_)
     {
@@ -316,14 +564,60 @@ namespace multiplayer_server
     }
   }
 
-  // on received data
+  // on received data, decode data into messages
   void AsioTcpConnection::on_received(const void *data, size_t size)
   {
+    if (rate_limiter_)
+    {
+      receive_time_ = std::chrono::steady_clock::now();
+    }
+
+    bool result = frame_decoder_.feed(static_cast<const char *>(data), size,
+                                      [this](uint16_t message_id, const char *message, size_t message_size)
+                                      { on_message(message_id, message, message_size); });
+    if (!result)
+    {
+      logger_->error("receive broken frame from {}:{}, close connection", ip_, port_);
+      close();
+    }
+  }
+
+  // on received a complete message
+  void AsioTcpConnection::on_message(uint16_t message_id, const void *data, size_t size)
+  {
+    // connection is closed by a previous message of the same read
+    if (status_ == ConnectionStatus::kClosed)
+    {
+      return;
+    }
+
+    // capture everything the client sent, including throttled messages
+    if (traffic_capture_)
+    {
+      traffic_capture_->record(connection_id_, TrafficCaptureEvent::kMessage, message_id, data, size);
+    }
+
+    // throttle before the message is handled by game logic
+    if (rate_limiter_)
+    {
+      auto result = rate_limiter_->check(message_id, receive_time_);
+      if (result == RateLimiter::Result::kDrop)
+      {
+        return;
+      }
+      if (result == RateLimiter::Result::kDisconnect)
+      {
+        logger_->warn("connection {}:{} keeps flooding message {}, dropped {} messages, close it", ip_, port_, message_id, rate_limiter_->get_dropped_count());
+        close();
+        return;
+      }
+    }
+
     if (received_callback_)
     {
       try 
       {
-        received_callback_(data, size);
+        received_callback_(message_id, data, size);
       }
       catch(const std::exception& e)
       {
@@ -331,4 +625,4 @@ namespace multiplayer_server
       }
     }
   }
-}
\ No newline at end of file
+}
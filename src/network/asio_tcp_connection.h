@@ -4,13 +4,29 @@
 #pragma once
 
 #include "connection.h"
+#include "buffer_pool.h"
+#include "traffic_capture.h"
+#include "rate_limiter.h"
 #include <boost/asio.hpp>
 #include <memory>
 #include <functional>
 #include <array>
-#include <list>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <algorithm>
 
 #define MAX_BUFFER_SIZE 1024
+// max number of free receive buffers kept by the receive buffer pool
+#define MAX_CACHED_RECEIVE_BUFFER_COUNT 4096
+// max bytes written by one gathered write
+#define MAX_SEND_BATCH_SIZE 65536
+// max frames written by one gathered write
+#define MAX_SEND_BATCH_FRAMES 64
+// default fragment size of bulk lane messages
+#define DEFAULT_BULK_FRAGMENT_SIZE 4096
+// default number of realtime messages sent before one bulk fragment
+#define DEFAULT_REALTIME_LANE_WEIGHT 4
 
 namespace multiplayer_server
 {
@@ -32,12 +48,14 @@ namespace multiplayer_server
     // rsync connect to remote host
     virtual bool async_connect() override;
 
-    // send data to remote host
+    // send a message to remote host
     // return true if send successfully
-    virtual bool send(const void* data, size_t size) override;
-    // async send data to remote host
-    // return true if send successfully
-    virtual bool async_send(const void* data, size_t size) override;
+    virtual bool send(uint16_t message_id, const void* data, size_t size) override;
+    // async send a message to remote host
+    // return true if the message is queued
+    virtual bool async_send(uint16_t message_id, const void* data, size_t size, SendLane lane = SendLane::kRealtime) override;
+    // run the task on the strand of the connection
+    virtual void post(std::function<void()> task) override;
 
     // receive data from remote host
     // return true if receive successfully
@@ -52,6 +70,28 @@ namespace multiplayer_server
     // get socket
     std::shared_ptr<boost::asio::ip::tcp::socket> get_socket() const { return socket_; }
 
+    // record inbound messages of this connection, set before start_receive
+    void set_traffic_capture(std::shared_ptr<TrafficCaptureWriter> capture) { traffic_capture_ = capture; }
+
+    // limit inbound messages of this connection, set before start_receive
+    void set_rate_limit_policy(std::shared_ptr<const RateLimitPolicy> policy);
+
+    // acceptor needs a closed socket, call it before async_accept
+    void prepare_accept();
+    // socket is accepted by acceptor, set socket options and status
+    void on_accepted();
+
+    // idle read mode, wait for the socket to be readable and borrow a receive buffer only when data is ready
+    // must be set before start_receive
+    void set_idle_read_mode(bool enable) { idle_read_mode_ = enable; }
+    bool is_idle_read_mode() const { return idle_read_mode_; }
+
+    // send scheduling, control lane is strict priority, realtime and bulk lanes are weighted
+    // realtime_weight realtime messages are sent before one bulk fragment
+    void set_realtime_lane_weight(size_t realtime_weight) { realtime_lane_weight_ = std::max<size_t>(realtime_weight, 1); }
+    // bulk messages are split into fragments of this size
+    void set_bulk_fragment_size(size_t fragment_size) { bulk_fragment_size_ = std::clamp<size_t>(fragment_size, 1, MAX_FRAME_PAYLOAD_SIZE); }
+
   protected:
     // async connected callback, result is true if connect successfully
     virtual void on_connected(bool result) override;
@@ -65,9 +105,24 @@ namespace multiplayer_server
     // handle send
     void handle_send(const boost::system::error_code& error, size_t bytes_transferred);
 
+    // handle a message decoded from received data
+    void on_message(uint16_t message_id, const void* data, size_t size);
+
+    // build next gathered write from send lanes, send_mutex_ must be locked
+    // return false if there is nothing to send
+    bool build_send_batch();
+    // add next frame of the front message of the lane into the batch, send_mutex_ must be locked
+    // return false if the batch is full or the lane is empty
+    bool append_send_frame(SendLane lane, size_t max_fragment_size);
+    // start gathered write of the batch
+    void start_send_batch();
+
     // handle receive
     void handle_receive(const boost::system::error_code& error, size_t bytes_transferred);
 
+    // handle socket readable in idle read mode
+    void handle_wait_read(const boost::system::error_code& error);
+
     // heartbeat, check connection status especially for udp
     virtual void heartbeat() override {}; // tcp do nothing
     virtual void set_keep_alive(bool enable) override;
@@ -75,18 +130,51 @@ namespace multiplayer_server
   protected:
     // io service
     std::shared_ptr<boost::asio::io_context> io_context_ = nullptr;
+    // all handlers of the connection run on the strand, one at a time
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
     // socket
     std::shared_ptr<boost::asio::ip::tcp::socket> socket_ = nullptr;
     // remote endpoint
     boost::asio::ip::tcp::endpoint remote_endpoint_;
 
-    // receive buffer
-    std::array<char, MAX_BUFFER_SIZE> receive_buffer_;
-    // send buffer
-    std::list<boost::asio::const_buffer> send_buffer_;
+    // receive buffer, borrowed from BufferPool::get_receive_pool()
+    // in idle read mode it is only held while reading
+    BufferPool::Buffer receive_buffer_;
+    // wait for readable instead of holding a pending read with a buffer
+    bool idle_read_mode_ = false;
+    // decode received data into messages
+    FrameDecoder frame_decoder_;
+    // record inbound traffic, nullptr if capture is disabled
+    std::shared_ptr<TrafficCaptureWriter> traffic_capture_ = nullptr;
+    // drop flooding messages before they are handled, nullptr if rate limit is disabled
+    std::unique_ptr<RateLimiter> rate_limiter_ = nullptr;
+    // time of current read, shared by all messages decoded from it
+    std::chrono::steady_clock::time_point receive_time_;
+
+    // message waiting in a send lane, payload is owned by the connection
+    struct OutgoingMessage
+    {
+      uint16_t message_id = 0;
+      std::vector<char> payload;
+      // bytes already put into frames
+      size_t offset = 0;
+    };
+
+    // guard send lanes and sending batch, async_send may be called from any thread
+    std::mutex send_mutex_;
+    // send queue of every lane
+    std::array<std::deque<OutgoingMessage>, kSendLaneCount> send_lanes_;
+    // batch in flight: frame headers, buffers of the gathered write, and messages whose last frame is in the batch
+    std::vector<FrameHeader::Encoded> sending_headers_;
+    std::vector<boost::asio::const_buffer> sending_buffers_;
+    std::vector<OutgoingMessage> sending_messages_;
+    size_t sending_bytes_ = 0;
     // is sending
     bool is_sending_ = false;
 
+    size_t realtime_lane_weight_ = DEFAULT_REALTIME_LANE_WEIGHT;
+    size_t bulk_fragment_size_ = DEFAULT_BULK_FRAGMENT_SIZE;
+
     // logger
     std::shared_ptr<LoggerImp> logger_ = nullptr;
   };
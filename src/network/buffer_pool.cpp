@@ -0,0 +1,93 @@
+#include "buffer_pool.h"
+#include "asio_tcp_connection.h"
+
+namespace multiplayer_server
+{
+  void BufferPool::Releaser::operator()(char *buffer) const
+  {
+    if (pool_)
+    {
+      pool_->release(buffer);
+    }
+    else
+    {
+      delete[] buffer;
+    }
+  }
+
+  BufferPool::BufferPool(std::size_t buffer_size, std::size_t max_cached_count)
+      : buffer_size_(buffer_size), max_cached_count_(max_cached_count)
+  {
+    free_buffers_.reserve(max_cached_count_);
+  }
+
+  BufferPool::~BufferPool()
+  {
+    for (auto buffer : free_buffers_)
+    {
+      delete[] buffer;
+    }
+    free_buffers_.clear();
+  }
+
+  // the receive pool lives until the process exits, so connections can release buffers in any order
+  BufferPool &BufferPool::get_receive_pool()
+  {
+    static BufferPool instance(MAX_BUFFER_SIZE, MAX_CACHED_RECEIVE_BUFFER_COUNT);
+    return instance;
+  }
+
+  BufferPool::Buffer BufferPool::acquire()
+  {
+    char *buffer = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++used_count_;
+      if (!free_buffers_.empty())
+      {
+        buffer = free_buffers_.back();
+        free_buffers_.pop_back();
+      }
+    }
+
+    // allocate outside the lock
+    if (!buffer)
+    {
+      buffer = new char[buffer_size_];
+    }
+    return Buffer(buffer, Releaser(this));
+  }
+
+  void BufferPool::release(char *buffer)
+  {
+    if (!buffer)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --used_count_;
+      if (free_buffers_.size() < max_cached_count_)
+      {
+        free_buffers_.push_back(buffer);
+        return;
+      }
+    }
+
+    // too many free buffers, give it back to system
+    delete[] buffer;
+  }
+
+  std::size_t BufferPool::get_used_count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_count_;
+  }
+
+  std::size_t BufferPool::get_cached_count() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_buffers_.size();
+  }
+}
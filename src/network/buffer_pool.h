@@ -0,0 +1,69 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: a thread safe pool of fixed size network buffers
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace multiplayer_server
+{
+  // fixed size buffer pool shared by all connections
+  // idle connections don't hold any buffer, they borrow one from the pool only when the socket is readable
+  // so the memory footprint depends on the number of active connections instead of the number of all connections
+  class BufferPool
+  {
+  public:
+    // return the buffer to the pool when the unique_ptr is destructed
+    class Releaser
+    {
+    public:
+      Releaser(BufferPool *pool = nullptr) : pool_(pool) {}
+      void operator()(char *buffer) const;
+
+    private:
+      BufferPool *pool_ = nullptr;
+    };
+
+    using Buffer = std::unique_ptr<char, Releaser>;
+
+  public:
+    // buffer_size is the size of every buffer
+    // max_cached_count is the max number of free buffers kept by the pool, more buffers are freed to system
+    BufferPool(std::size_t buffer_size, std::size_t max_cached_count);
+    ~BufferPool();
+
+    // non-copyable
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+    BufferPool(BufferPool &&) = delete;
+    BufferPool &operator=(BufferPool &&) = delete;
+
+    // pool used by all tcp connections to receive data
+    static BufferPool &get_receive_pool();
+
+    // borrow a buffer from the pool, allocate a new one if there is no free buffer
+    Buffer acquire();
+
+    // size of every buffer
+    std::size_t get_buffer_size() const { return buffer_size_; }
+    // number of buffers in use
+    std::size_t get_used_count() const;
+    // number of free buffers in the pool
+    std::size_t get_cached_count() const;
+
+  private:
+    // give the buffer back, called by Releaser
+    void release(char *buffer);
+
+  private:
+    std::size_t buffer_size_ = 0;
+    std::size_t max_cached_count_ = 0;
+    std::size_t used_count_ = 0;
+
+    mutable std::mutex mutex_;
+    std::vector<char *> free_buffers_;
+  };
+}
@@ -3,8 +3,11 @@
 // Purpose: a abstract class of network connection
 #pragma once
 
+#include "message_frame.h"
 #include <string>
 #include <functional>
+#include <cstdint>
+#include <atomic>
 
 namespace multiplayer_server
 {
@@ -27,6 +30,7 @@ namespace multiplayer_server
     {
       ip_ = ip;
       port_ = port;
+      connection_id_ = generate_connection_id();
     }
     virtual ~Connection() = default;
 
@@ -51,20 +55,23 @@ namespace multiplayer_server
     // set disconnected callback
     virtual void set_disconnected_callback(std::function<void()> callback) { disconnected_callback_ = callback; }
 
-    // send data to remote host
+    // send a message to remote host, data is framed with message id
     // return true if send successfully
-    virtual bool send(const void *data, size_t size) = 0;
-    // async send data to remote host
-    // return true if send successfully
-    virtual bool async_send(const void *data, size_t size) = 0;
+    virtual bool send(uint16_t message_id, const void *data, size_t size) = 0;
+    // async send a message to remote host, data is copied into the send queue of the lane
+    // return true if the message is queued
+    virtual bool async_send(uint16_t message_id, const void *data, size_t size, SendLane lane = SendLane::kRealtime) = 0;
+    // run the task where the io handlers of the connection run, never at the same time as them
+    // a connection without io handlers runs it at once
+    virtual void post(std::function<void()> task) { task(); }
 
     // receive data from remote host
     // return true if receive successfully
     virtual bool receive(void *data, size_t size) = 0;
-    // receive callback
+    // receive raw data callback, raw data is decoded into messages
     virtual void on_received(const void *data, size_t size) = 0;
-    // set receive data callback
-    virtual void set_receive_callback(std::function<void(const void *, size_t)> callback) { received_callback_ = callback; };
+    // set receive message callback, it's called for every complete message
+    virtual void set_receive_callback(std::function<void(uint16_t, const void *, size_t)> callback) { received_callback_ = callback; };
 
     // close connection
     virtual void close() = 0;
@@ -75,6 +82,13 @@ namespace multiplayer_server
     // get connection status
     virtual void get_status(ConnectionStatus status) { status_ = status; }
 
+    // get process unique connection id
+    virtual uint64_t get_connection_id() const { return connection_id_; }
+
+    // get remote host ip and port
+    virtual const std::string &get_ip() const { return ip_; }
+    virtual int get_port() const { return port_; }
+
     virtual void set_keep_alive(bool enable) = 0;
 
     // heartbeat, check connection status especially for udp
@@ -88,9 +102,17 @@ namespace multiplayer_server
     // update connection status
     virtual void set_status(ConnectionStatus status) { status_ = status; }
 
+    // generate process unique connection id, start from 1
+    static uint64_t generate_connection_id()
+    {
+      static std::atomic<uint64_t> next_connection_id{1};
+      return next_connection_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
   protected:
     // connection status
     ConnectionStatus status_{ConnectionStatus::kNone};
+    uint64_t connection_id_ = 0;  // process unique connection id
     std::string ip_; // remote host ip
     int port_;  // remote host port
 
@@ -98,8 +120,8 @@ namespace multiplayer_server
     std::function<void(bool)> connected_callback_ = nullptr;
     // disconnected callback
     std::function<void()> disconnected_callback_ = nullptr;
-    // receive data callback
-    std::function<void(const void *, size_t)> received_callback_ = nullptr;
+    // receive message callback, arguments are message id, data and size
+    std::function<void(uint16_t, const void *, size_t)> received_callback_ = nullptr;
 
     // heart beat check variables
     int keep_idle_interval_ = 60;
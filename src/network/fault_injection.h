@@ -0,0 +1,36 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: configuration of network fault injection, simulate bad network in local environment
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace multiplayer_server
+{
+  // faults injected into connections matching the ip range
+  // faults are applied on message level in both directions
+  struct FaultInjectionRule
+  {
+    // remote ip range in CIDR notation, for example "10.0.0.0/8" or "::1/128", empty means all connections
+    std::string ip_range = "";
+    // fixed delay of every message
+    int latency_ms = 0;
+    // random delay in [-jitter_ms, jitter_ms] added to latency
+    int jitter_ms = 0;
+    // max bytes per second of every direction, 0 means unlimited
+    int64_t bandwidth_bytes_per_second = 0;
+    // probability of dropping a message, in [0, 1]
+    double loss_rate = 0.0;
+    // probability of holding a message for an extra latency period so later messages overtake it, in [0, 1]
+    double reorder_rate = 0.0;
+  };
+
+  struct FaultInjectionConfig
+  {
+    bool enabled = false;
+    // the first matched rule is used
+    std::vector<FaultInjectionRule> rules = {};
+  };
+}
@@ -0,0 +1,277 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: a connection decorator injecting latency, jitter, bandwidth limit, loss and reordering
+#include "fault_injection_connection.h"
+#include "log/logger.h"
+#include <vector>
+
+namespace multiplayer_server
+{
+  // check if ip is in the CIDR range
+  static bool is_ip_in_range(const boost::asio::ip::address &address, const std::string &range)
+  {
+    if (range.empty())
+    {
+      return true;
+    }
+
+    // split range into network address and prefix length
+    auto slash = range.find('/');
+    boost::system::error_code error;
+    auto network = boost::asio::ip::make_address(range.substr(0, slash), error);
+    if (error)
+    {
+      return false;
+    }
+
+    if (network.is_v4() != address.is_v4())
+    {
+      return false;
+    }
+
+    std::vector<unsigned char> network_bytes;
+    std::vector<unsigned char> address_bytes;
+    if (network.is_v4())
+    {
+      auto bytes = network.to_v4().to_bytes();
+      network_bytes.assign(bytes.begin(), bytes.end());
+      bytes = address.to_v4().to_bytes();
+      address_bytes.assign(bytes.begin(), bytes.end());
+    }
+    else
+    {
+      auto bytes = network.to_v6().to_bytes();
+      network_bytes.assign(bytes.begin(), bytes.end());
+      bytes = address.to_v6().to_bytes();
+      address_bytes.assign(bytes.begin(), bytes.end());
+    }
+
+    int prefix = static_cast<int>(network_bytes.size() * 8);
+    if (slash != std::string::npos)
+    {
+      try
+      {
+        prefix = std::stoi(range.substr(slash + 1));
+      }
+      catch (const std::exception &)
+      {
+        return false;
+      }
+    }
+
+    // compare prefix bits
+    for (size_t i = 0; i < network_bytes.size() && prefix > 0; i++, prefix -= 8)
+    {
+      unsigned char mask = prefix >= 8 ? 0xff : static_cast<unsigned char>(0xff << (8 - prefix));
+      if ((network_bytes[i] & mask) != (address_bytes[i] & mask))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  FaultInjectionConnection::FaultInjectionConnection(std::shared_ptr<Connection> connection, std::shared_ptr<boost::asio::io_context> io_context, const FaultInjectionRule &rule)
+      : Connection(connection->get_ip(), connection->get_port()), connection_(connection), io_context_(io_context), rule_(rule), random_engine_(std::random_device()())
+  {
+    logger_ = g_logger_manager.create_logger("FaultInjection", LoggerLevel::Debug, "log/FaultInjection.log");
+    logger_->info("inject faults into connection {}:{}, latency {}ms jitter {}ms bandwidth {}B/s loss {} reorder {}",
+                  ip_, port_, rule_.latency_ms, rule_.jitter_ms, rule_.bandwidth_bytes_per_second, rule_.loss_rate, rule_.reorder_rate);
+  }
+
+  FaultInjectionConnection::~FaultInjectionConnection()
+  {
+  }
+
+  void FaultInjectionConnection::init()
+  {
+    std::weak_ptr<FaultInjectionConnection> weak_self = shared_from_this();
+    connection_->set_receive_callback([weak_self](uint16_t message_id, const void *data, size_t size)
+                                      {
+                                        if (auto self = weak_self.lock())
+                                        {
+                                          self->on_message(message_id, data, size);
+                                        } });
+  }
+
+  const FaultInjectionRule *FaultInjectionConnection::find_rule(const FaultInjectionConfig &config, const std::string &ip)
+  {
+    if (!config.enabled)
+    {
+      return nullptr;
+    }
+
+    boost::system::error_code error;
+    auto address = boost::asio::ip::make_address(ip, error);
+    if (error)
+    {
+      return nullptr;
+    }
+
+    for (const auto &rule : config.rules)
+    {
+      if (is_ip_in_range(address, rule.ip_range))
+      {
+        return &rule;
+      }
+    }
+    return nullptr;
+  }
+
+  void FaultInjectionConnection::set_rule(const FaultInjectionRule &rule)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rule_ = rule;
+  }
+
+  bool FaultInjectionConnection::send(uint16_t message_id, const void *data, size_t size)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (std::bernoulli_distribution(rule_.loss_rate)(random_engine_))
+      {
+        return true;
+      }
+    }
+    return connection_->send(message_id, data, size);
+  }
+
+  bool FaultInjectionConnection::async_send(uint16_t message_id, const void *data, size_t size, SendLane lane)
+  {
+    // copy the message, the caller's buffer may be released before it is sent
+    auto payload = std::make_shared<std::vector<char>>(static_cast<const char *>(data), static_cast<const char *>(data) + size);
+    auto connection = connection_;
+    if (!schedule(Direction::kOutbound, size, [connection, message_id, payload, lane]()
+                  { connection->async_send(message_id, payload->data(), payload->size(), lane); }))
+    {
+      logger_->debug("drop message {} to {}:{}", message_id, ip_, port_);
+    }
+    return true;
+  }
+
+  void FaultInjectionConnection::on_message(uint16_t message_id, const void *data, size_t size)
+  {
+    // data is only valid in this call, copy it
+    auto payload = std::make_shared<std::vector<char>>(static_cast<const char *>(data), static_cast<const char *>(data) + size);
+    std::weak_ptr<FaultInjectionConnection> weak_self = shared_from_this();
+    if (!schedule(Direction::kInbound, size, [weak_self, message_id, payload]()
+                  {
+                    auto self = weak_self.lock();
+                    if (self && self->received_callback_)
+                    {
+                      try
+                      {
+                        self->received_callback_(message_id, payload->data(), payload->size());
+                      }
+                      catch (const std::exception &e)
+                      {
+                        self->logger_->error("on_received callback error {}", e.what());
+                      }
+                    } }))
+    {
+      logger_->debug("drop message {} from {}:{}", message_id, ip_, port_);
+    }
+  }
+
+  bool FaultInjectionConnection::schedule(Direction direction, size_t size, std::function<void()> deliver)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // loss
+    if (std::bernoulli_distribution(rule_.loss_rate)(random_engine_))
+    {
+      return false;
+    }
+
+    // latency and jitter
+    auto now = std::chrono::steady_clock::now();
+    auto delay_ms = std::chrono::milliseconds(rule_.latency_ms);
+    if (rule_.jitter_ms > 0)
+    {
+      delay_ms += std::chrono::milliseconds(std::uniform_int_distribution<int>(-rule_.jitter_ms, rule_.jitter_ms)(random_engine_));
+    }
+    auto delivery_time = now + std::max<std::chrono::steady_clock::duration>(delay_ms, std::chrono::steady_clock::duration::zero());
+
+    // bandwidth, the message waits until the simulated link has transferred all previous messages
+    if (rule_.bandwidth_bytes_per_second > 0)
+    {
+      auto &link_free_time = link_free_time_[static_cast<size_t>(direction)];
+      link_free_time = std::max(link_free_time, now) +
+                       std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                           std::chrono::duration<double>(static_cast<double>(size) / static_cast<double>(rule_.bandwidth_bytes_per_second)));
+      delivery_time += link_free_time - now;
+    }
+
+    // reorder, hold the message for one more latency period, later messages overtake it
+    if (std::bernoulli_distribution(rule_.reorder_rate)(random_engine_))
+    {
+      delivery_time += std::chrono::milliseconds(std::max(rule_.latency_ms + rule_.jitter_ms, 1));
+      run_at(delivery_time, std::move(deliver));
+      return true;
+    }
+
+    // in order, jitter can't move a message before the one in front of it
+    // messages in front are already posted to the strand if the queue is empty, so a due message is posted right away
+    auto &messages = delayed_messages_[static_cast<size_t>(direction)];
+    if (messages.empty() && delivery_time <= now)
+    {
+      connection_->post(std::move(deliver));
+      return true;
+    }
+
+    if (!messages.empty())
+    {
+      delivery_time = std::max(delivery_time, messages.back().delivery_time);
+    }
+    messages.push_back(DelayedMessage{delivery_time, std::move(deliver)});
+    if (messages.size() == 1)
+    {
+      wait_delayed_messages(direction);
+    }
+    return true;
+  }
+
+  void FaultInjectionConnection::wait_delayed_messages(Direction direction)
+  {
+    // queued messages are dropped if the connection is released before they are due
+    auto timer = std::make_shared<boost::asio::steady_timer>(*io_context_, delayed_messages_[static_cast<size_t>(direction)].front().delivery_time);
+    std::weak_ptr<FaultInjectionConnection> weak_self = shared_from_this();
+    timer->async_wait([timer, weak_self, direction](const boost::system::error_code &error)
+                      {
+                        auto self = weak_self.lock();
+                        if (!error && self)
+                        {
+                          self->on_delayed_messages(direction);
+                        } });
+  }
+
+  void FaultInjectionConnection::on_delayed_messages(Direction direction)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    auto &messages = delayed_messages_[static_cast<size_t>(direction)];
+    // the strand runs posted handlers in order
+    while (!messages.empty() && messages.front().delivery_time <= now)
+    {
+      connection_->post(std::move(messages.front().deliver));
+      messages.pop_front();
+    }
+
+    if (!messages.empty())
+    {
+      wait_delayed_messages(direction);
+    }
+  }
+
+  void FaultInjectionConnection::run_at(std::chrono::steady_clock::time_point time, std::function<void()> deliver)
+  {
+    auto timer = std::make_shared<boost::asio::steady_timer>(*io_context_, time);
+    auto connection = connection_;
+    timer->async_wait([timer, connection, deliver](const boost::system::error_code &error)
+                      {
+                        if (!error)
+                        {
+                          connection->post(deliver);
+                        } });
+  }
+}
@@ -0,0 +1,113 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: a connection decorator injecting latency, jitter, bandwidth limit, loss and reordering
+#pragma once
+
+#include "connection.h"
+#include "fault_injection.h"
+#include <boost/asio.hpp>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <deque>
+#include <functional>
+
+namespace multiplayer_server
+{
+  // forward declaration, abstract logger class
+  class LoggerImp;
+
+  // wrap a real connection, game module uses it as a normal connection
+  // messages of one direction keep their order unless the reorder rate picks them, delayed ones run on the strand of the wrapped connection
+  // only for benchmark and test, never enable it on production servers
+  class FaultInjectionConnection : public Connection, public std::enable_shared_from_this<FaultInjectionConnection>
+  {
+  public:
+    FaultInjectionConnection(std::shared_ptr<Connection> connection, std::shared_ptr<boost::asio::io_context> io_context, const FaultInjectionRule &rule);
+    virtual ~FaultInjectionConnection();
+
+    // hook receive callback of the wrapped connection, must be called before start_receive
+    void init();
+
+    // find the first rule matching the ip, return nullptr if no rule matches
+    static const FaultInjectionRule *find_rule(const FaultInjectionConfig &config, const std::string &ip);
+
+    // change rule of this connection at runtime
+    void set_rule(const FaultInjectionRule &rule);
+
+    // get wrapped connection
+    std::shared_ptr<Connection> get_connection() const { return connection_; }
+
+    virtual ConnectionStatus get_status() const override { return connection_->get_status(); }
+    virtual const std::string &get_ip() const override { return connection_->get_ip(); }
+    virtual int get_port() const override { return connection_->get_port(); }
+    virtual uint64_t get_connection_id() const override { return connection_->get_connection_id(); }
+
+    virtual bool connect() override { return connection_->connect(); }
+    virtual bool async_connect() override { return connection_->async_connect(); }
+    virtual void on_connected(bool result) override { connection_->on_connected(result); }
+    virtual void set_connected_callback(std::function<void(bool)> callback) override { connection_->set_connected_callback(callback); }
+    virtual void set_disconnected_callback(std::function<void()> callback) override { connection_->set_disconnected_callback(callback); }
+
+    // synchronous send is not delayed, only loss is applied
+    virtual bool send(uint16_t message_id, const void *data, size_t size) override;
+    // async send is delayed, dropped or reordered according to the rule
+    virtual bool async_send(uint16_t message_id, const void *data, size_t size, SendLane lane = SendLane::kRealtime) override;
+    virtual void post(std::function<void()> task) override { connection_->post(std::move(task)); }
+
+    virtual bool receive(void *data, size_t size) override { return connection_->receive(data, size); }
+    virtual void on_received(const void *data, size_t size) override { connection_->on_received(data, size); }
+
+    virtual void close() override { connection_->close(); }
+    virtual void start_receive() override { connection_->start_receive(); }
+
+    virtual void set_keep_alive(bool enable) override { connection_->set_keep_alive(enable); }
+    virtual void heartbeat() override { connection_->heartbeat(); }
+
+  private:
+    // one direction of traffic
+    enum class Direction
+    {
+      kInbound,
+      kOutbound,
+      kCount
+    };
+
+    // message received from the wrapped connection
+    void on_message(uint16_t message_id, const void *data, size_t size);
+
+    // roll the dice for a message and deliver it through the wrapped connection's strand at its time
+    // return false if the message is dropped
+    bool schedule(Direction direction, size_t size, std::function<void()> deliver);
+
+    // wait for the first delayed message of the direction, called with the lock held
+    void wait_delayed_messages(Direction direction);
+    // deliver delayed messages of the direction which are due
+    void on_delayed_messages(Direction direction);
+
+    // deliver a reordered message at time, out of the order of its direction
+    void run_at(std::chrono::steady_clock::time_point time, std::function<void()> deliver);
+
+  private:
+    std::shared_ptr<Connection> connection_;
+    std::shared_ptr<boost::asio::io_context> io_context_;
+
+    // guard rule, random engine and bandwidth state
+    std::mutex mutex_;
+    FaultInjectionRule rule_;
+    std::mt19937 random_engine_;
+    // time when the simulated link of every direction becomes free
+    std::chrono::steady_clock::time_point link_free_time_[static_cast<size_t>(Direction::kCount)];
+
+    // messages in order waiting for their time, a message is never due before the one in front of it
+    struct DelayedMessage
+    {
+      std::chrono::steady_clock::time_point delivery_time;
+      std::function<void()> deliver;
+    };
+    std::deque<DelayedMessage> delayed_messages_[static_cast<size_t>(Direction::kCount)];
+
+    std::shared_ptr<LoggerImp> logger_ = nullptr;
+  };
+}
@@ -0,0 +1,172 @@
+#include "message_frame.h"
+#include <cstring>
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  void FrameHeader::encode(char *out) const
+  {
+    out[0] = static_cast<char>(size & 0xff);
+    out[1] = static_cast<char>((size >> 8) & 0xff);
+    out[2] = static_cast<char>((size >> 16) & 0xff);
+    out[3] = static_cast<char>((size >> 24) & 0xff);
+    out[4] = static_cast<char>(message_id & 0xff);
+    out[5] = static_cast<char>((message_id >> 8) & 0xff);
+    out[6] = static_cast<char>(lane);
+    out[7] = static_cast<char>(flags);
+  }
+
+  FrameHeader::Encoded FrameHeader::encode() const
+  {
+    Encoded encoded;
+    encode(encoded.data());
+    return encoded;
+  }
+
+  FrameHeader FrameHeader::decode(const char *in)
+  {
+    auto byte = [in](int index) { return static_cast<uint32_t>(static_cast<uint8_t>(in[index])); };
+
+    FrameHeader header;
+    header.size = byte(0) | (byte(1) << 8) | (byte(2) << 16) | (byte(3) << 24);
+    header.message_id = static_cast<uint16_t>(byte(4) | (byte(5) << 8));
+    header.lane = static_cast<uint8_t>(byte(6));
+    header.flags = static_cast<uint8_t>(byte(7));
+    return header;
+  }
+
+  bool FrameDecoder::feed(const char *data, std::size_t size, const MessageHandler &handler)
+  {
+    // first, complete the frame left by last feed
+    if (!pending_.empty())
+    {
+      // complete the header
+      if (pending_.size() < FRAME_HEADER_SIZE)
+      {
+        std::size_t count = std::min(FRAME_HEADER_SIZE - pending_.size(), size);
+        pending_.insert(pending_.end(), data, data + count);
+        data += count;
+        size -= count;
+        if (pending_.size() < FRAME_HEADER_SIZE)
+        {
+          return true;
+        }
+      }
+
+      FrameHeader header = FrameHeader::decode(pending_.data());
+      if (header.size > MAX_FRAME_PAYLOAD_SIZE)
+      {
+        return false;
+      }
+
+      // complete the payload
+      std::size_t frame_size = FRAME_HEADER_SIZE + header.size;
+      std::size_t count = std::min(frame_size - pending_.size(), size);
+      pending_.insert(pending_.end(), data, data + count);
+      data += count;
+      size -= count;
+      if (pending_.size() < frame_size)
+      {
+        return true;
+      }
+
+      bool result = on_frame(header, pending_.data() + FRAME_HEADER_SIZE, handler);
+      release_buffer(pending_);
+      if (!result)
+      {
+        return false;
+      }
+    }
+
+    // second, handle complete frames in place
+    while (size >= FRAME_HEADER_SIZE)
+    {
+      FrameHeader header = FrameHeader::decode(data);
+      if (header.size > MAX_FRAME_PAYLOAD_SIZE)
+      {
+        return false;
+      }
+
+      std::size_t frame_size = FRAME_HEADER_SIZE + header.size;
+      if (size < frame_size)
+      {
+        break;
+      }
+
+      if (!on_frame(header, data + FRAME_HEADER_SIZE, handler))
+      {
+        return false;
+      }
+      data += frame_size;
+      size -= frame_size;
+    }
+
+    // last, keep the incomplete frame
+    if (size > 0)
+    {
+      pending_.insert(pending_.end(), data, data + size);
+    }
+    return true;
+  }
+
+  bool FrameDecoder::on_frame(const FrameHeader &header, const char *payload, const MessageHandler &handler)
+  {
+    if (header.lane >= kSendLaneCount)
+    {
+      return false;
+    }
+
+    auto &fragments = fragments_[header.lane];
+
+    // not fragmented, deliver without copy
+    if (fragments.empty() && !(header.flags & kFrameFlagMoreFragments))
+    {
+      handler(header.message_id, payload, header.size);
+      return true;
+    }
+
+    // fragments of one message must have the same message id
+    if (fragments.empty())
+    {
+      fragment_message_ids_[header.lane] = header.message_id;
+    }
+    else if (fragment_message_ids_[header.lane] != header.message_id)
+    {
+      return false;
+    }
+
+    if (fragments.size() + header.size > MAX_MESSAGE_SIZE)
+    {
+      return false;
+    }
+    fragments.insert(fragments.end(), payload, payload + header.size);
+
+    if (!(header.flags & kFrameFlagMoreFragments))
+    {
+      handler(header.message_id, fragments.data(), fragments.size());
+      release_buffer(fragments);
+    }
+    return true;
+  }
+
+  void FrameDecoder::release_buffer(std::vector<char> &buffer)
+  {
+    if (buffer.capacity() > FRAME_DECODER_KEEP_BUFFER_SIZE)
+    {
+      std::vector<char>().swap(buffer);
+    }
+    else
+    {
+      buffer.clear();
+    }
+  }
+
+  void FrameDecoder::reset()
+  {
+    release_buffer(pending_);
+    for (auto &fragments : fragments_)
+    {
+      release_buffer(fragments);
+    }
+  }
+}
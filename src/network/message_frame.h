@@ -0,0 +1,94 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: message frame on the byte stream, every frame has a fixed size header and a payload
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <functional>
+
+// size of encoded frame header
+#define FRAME_HEADER_SIZE 8
+// max payload size of a single frame, bigger messages are split into fragments
+#define MAX_FRAME_PAYLOAD_SIZE 65536
+// max size of a reassembled message
+#define MAX_MESSAGE_SIZE (16 * 1024 * 1024)
+// decoder buffers bigger than this are freed after use instead of kept for the next message
+#define FRAME_DECODER_KEEP_BUFFER_SIZE 4096
+
+namespace multiplayer_server
+{
+  // outgoing message lanes of a connection, lower value has higher priority
+  // control: connection control messages, always sent first
+  // realtime: movement and state updates
+  // bulk: big data such as inventory dumps, split into fragments so it cannot block other lanes
+  enum class SendLane : uint8_t
+  {
+    kControl = 0,
+    kRealtime = 1,
+    kBulk = 2,
+    kCount
+  };
+
+  constexpr std::size_t kSendLaneCount = static_cast<std::size_t>(SendLane::kCount);
+
+  // frame flags
+  enum FrameFlag : uint8_t
+  {
+    kFrameFlagNone = 0,
+    // more fragments of the same message follow on the same lane
+    kFrameFlagMoreFragments = 1 << 0,
+  };
+
+  // frame header layout, little endian:
+  //   uint32 payload size | uint16 message id | uint8 lane | uint8 flags
+  // fragments of messages on different lanes may interleave, but fragments on one lane are in order
+  struct FrameHeader
+  {
+    uint32_t size = 0;
+    uint16_t message_id = 0;
+    uint8_t lane = 0;
+    uint8_t flags = kFrameFlagNone;
+
+    using Encoded = std::array<char, FRAME_HEADER_SIZE>;
+
+    void encode(char *out) const;
+    Encoded encode() const;
+    static FrameHeader decode(const char *in);
+  };
+
+  // split the byte stream into frames and reassemble fragmented messages
+  // one decoder for one connection, not thread safe
+  class FrameDecoder
+  {
+  public:
+    // called for every complete message
+    using MessageHandler = std::function<void(uint16_t message_id, const char *data, std::size_t size)>;
+
+  public:
+    FrameDecoder() = default;
+    ~FrameDecoder() = default;
+
+    // feed data received from the stream
+    // return false if the stream is broken, the connection should be closed
+    bool feed(const char *data, std::size_t size, const MessageHandler &handler);
+
+    // drop all pending data
+    void reset();
+
+  private:
+    // handle a complete frame
+    bool on_frame(const FrameHeader &header, const char *payload, const MessageHandler &handler);
+    // empty the buffer, a big one is freed so one huge message doesn't pin its memory for the connection lifetime
+    static void release_buffer(std::vector<char> &buffer);
+
+  private:
+    // incomplete frame kept between two feeds
+    std::vector<char> pending_;
+    // reassembly buffer of every lane
+    std::array<std::vector<char>, kSendLaneCount> fragments_;
+    std::array<uint16_t, kSendLaneCount> fragment_message_ids_ = {};
+  };
+}
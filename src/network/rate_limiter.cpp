@@ -0,0 +1,75 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <limits>
+
+namespace multiplayer_server
+{
+  RateLimitPolicy::RateLimitPolicy(const RateLimitConfig &config)
+      : bucket_indexes_(static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1, kDefaultBucketIndex),
+        max_violations_(config.max_violations),
+        violation_decay_per_second_(config.violation_decay_per_second)
+  {
+    // first bucket is the default bucket
+    bucket_rules_.push_back(BucketRule{config.default_rate, std::max(config.default_burst, 1.0)});
+
+    for (const auto &rule : config.rules)
+    {
+      bucket_indexes_[rule.message_id] = static_cast<uint16_t>(bucket_rules_.size());
+      bucket_rules_.push_back(BucketRule{rule.rate, std::max(rule.burst, 1.0)});
+    }
+  }
+
+  RateLimiter::RateLimiter(std::shared_ptr<const RateLimitPolicy> policy) : policy_(policy)
+  {
+    // every bucket starts full
+    auto now = std::chrono::steady_clock::now();
+    for (const auto &rule : policy_->get_bucket_rules())
+    {
+      buckets_.push_back(TokenBucket{rule.burst, now});
+    }
+    last_violation_time_ = now;
+  }
+
+  RateLimiter::Result RateLimiter::check(uint16_t message_id, std::chrono::steady_clock::time_point now)
+  {
+    uint16_t index = policy_->get_bucket_index(message_id);
+    const auto &rule = policy_->get_bucket_rules()[index];
+
+    // unlimited
+    if (rule.rate <= 0.0)
+    {
+      return Result::kAccept;
+    }
+
+    // refill tokens
+    auto &bucket = buckets_[index];
+    if (now > bucket.last_refill_time)
+    {
+      double elapsed = std::chrono::duration<double>(now - bucket.last_refill_time).count();
+      bucket.tokens = std::min(rule.burst, bucket.tokens + elapsed * rule.rate);
+      bucket.last_refill_time = now;
+    }
+
+    if (bucket.tokens >= 1.0)
+    {
+      bucket.tokens -= 1.0;
+      return Result::kAccept;
+    }
+
+    // throttled, decay old violations and add a new one
+    dropped_count_++;
+    if (now > last_violation_time_)
+    {
+      double elapsed = std::chrono::duration<double>(now - last_violation_time_).count();
+      violations_ = std::max(0.0, violations_ - elapsed * policy_->get_violation_decay_per_second());
+      last_violation_time_ = now;
+    }
+    violations_ += 1.0;
+
+    if (violations_ > policy_->get_max_violations())
+    {
+      return Result::kDisconnect;
+    }
+    return Result::kDrop;
+  }
+}
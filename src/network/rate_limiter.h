@@ -0,0 +1,105 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: per connection, per message id token bucket rate limiting of inbound messages
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+namespace multiplayer_server
+{
+  // rate limit of one message id
+  struct RateLimitRule
+  {
+    uint16_t message_id = 0;
+    // tokens added per second, 0 means unlimited
+    double rate = 0.0;
+    // max tokens in the bucket, it's the max burst of messages
+    double burst = 0.0;
+  };
+
+  struct RateLimitConfig
+  {
+    bool enabled = false;
+    // limit of message ids without a rule, rate 0 means unlimited
+    double default_rate = 0.0;
+    double default_burst = 0.0;
+    std::vector<RateLimitRule> rules = {};
+    // every dropped message adds one violation, violations decay over time
+    // the connection is closed when violations exceed max_violations
+    double max_violations = 100.0;
+    double violation_decay_per_second = 10.0;
+  };
+
+  // rate limit config compiled for fast lookup, shared by all connections
+  // message id is mapped to a bucket index by a dense table, no hash lookup per message
+  class RateLimitPolicy
+  {
+  public:
+    // rate and burst of a bucket
+    struct BucketRule
+    {
+      double rate = 0.0;
+      double burst = 0.0;
+    };
+
+    // bucket index of message ids without a rule
+    static constexpr uint16_t kDefaultBucketIndex = 0;
+
+  public:
+    RateLimitPolicy(const RateLimitConfig &config);
+    ~RateLimitPolicy() = default;
+
+    uint16_t get_bucket_index(uint16_t message_id) const { return bucket_indexes_[message_id]; }
+    const std::vector<BucketRule> &get_bucket_rules() const { return bucket_rules_; }
+    double get_max_violations() const { return max_violations_; }
+    double get_violation_decay_per_second() const { return violation_decay_per_second_; }
+
+  private:
+    // message id -> bucket index
+    std::vector<uint16_t> bucket_indexes_;
+    std::vector<BucketRule> bucket_rules_;
+    double max_violations_ = 0.0;
+    double violation_decay_per_second_ = 0.0;
+  };
+
+  // token buckets of one connection, not thread safe
+  class RateLimiter
+  {
+  public:
+    enum class Result
+    {
+      kAccept,
+      // drop the message
+      kDrop,
+      // sustained abuse, close the connection
+      kDisconnect,
+    };
+
+  public:
+    RateLimiter(std::shared_ptr<const RateLimitPolicy> policy);
+    ~RateLimiter() = default;
+
+    // check one inbound message, now is taken once for all messages of one read
+    Result check(uint16_t message_id, std::chrono::steady_clock::time_point now);
+
+    // number of dropped messages
+    uint64_t get_dropped_count() const { return dropped_count_; }
+
+  private:
+    struct TokenBucket
+    {
+      double tokens = 0.0;
+      std::chrono::steady_clock::time_point last_refill_time;
+    };
+
+    std::shared_ptr<const RateLimitPolicy> policy_;
+    std::vector<TokenBucket> buckets_;
+
+    double violations_ = 0.0;
+    std::chrono::steady_clock::time_point last_violation_time_;
+    uint64_t dropped_count_ = 0;
+  };
+}
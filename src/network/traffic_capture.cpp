@@ -0,0 +1,218 @@
+#include "traffic_capture.h"
+#include <filesystem>
+#include <cstring>
+
+// flush to file when buffered bytes reach this size
+#define TRAFFIC_CAPTURE_FLUSH_SIZE (256 * 1024)
+// flush to file at least once per interval, so a killed process loses little traffic
+#define TRAFFIC_CAPTURE_FLUSH_INTERVAL std::chrono::seconds(1)
+
+namespace multiplayer_server
+{
+  static void write_le(char *out, uint64_t value, int bytes)
+  {
+    for (int i = 0; i < bytes; i++)
+    {
+      out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  static uint64_t read_le(const char *in, int bytes)
+  {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+      value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+  }
+
+  TrafficCaptureWriter::TrafficCaptureWriter()
+  {
+    write_buffer_.reserve(TRAFFIC_CAPTURE_FLUSH_SIZE * 2);
+    writing_buffer_.reserve(TRAFFIC_CAPTURE_FLUSH_SIZE * 2);
+  }
+
+  TrafficCaptureWriter::~TrafficCaptureWriter()
+  {
+    close();
+  }
+
+  bool TrafficCaptureWriter::open(const std::string &file_path)
+  {
+    close();
+
+    std::error_code error;
+    auto parent = std::filesystem::path(file_path).parent_path();
+    if (!parent.empty())
+    {
+      std::filesystem::create_directories(parent, error);
+    }
+
+    {
+      std::lock_guard<std::mutex> file_lock(file_mutex_);
+      file_.open(file_path, std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!file_.is_open())
+      {
+        return false;
+      }
+
+      file_.write(TRAFFIC_CAPTURE_MAGIC, TRAFFIC_CAPTURE_MAGIC_SIZE);
+      file_.flush();
+      if (!file_.good())
+      {
+        file_.close();
+        return false;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      start_time_ = std::chrono::steady_clock::now();
+      opened_ = true;
+      stop_ = false;
+    }
+    writer_thread_ = std::thread(&TrafficCaptureWriter::writer_loop, this);
+    return true;
+  }
+
+  void TrafficCaptureWriter::close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      opened_ = false;
+      stop_ = true;
+    }
+    flush_condition_.notify_one();
+    if (writer_thread_.joinable())
+    {
+      writer_thread_.join();
+    }
+
+    // records appended before opened_ was cleared
+    flush();
+
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    if (file_.is_open())
+    {
+      file_.close();
+    }
+  }
+
+  bool TrafficCaptureWriter::is_open() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return opened_;
+  }
+
+  void TrafficCaptureWriter::record(uint64_t connection_id, TrafficCaptureEvent event, uint16_t message_id, const void *data, size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!opened_)
+    {
+      return;
+    }
+    auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time_).count();
+
+    // encode record header and payload into write buffer
+    size_t offset = write_buffer_.size();
+    write_buffer_.resize(offset + TRAFFIC_CAPTURE_RECORD_HEADER_SIZE + size);
+    char *out = write_buffer_.data() + offset;
+    write_le(out, static_cast<uint64_t>(timestamp), 8);
+    write_le(out + 8, connection_id, 8);
+    write_le(out + 16, message_id, 2);
+    out[18] = static_cast<char>(event);
+    out[19] = 0;
+    write_le(out + 20, size, 4);
+    if (size > 0)
+    {
+      std::memcpy(out + TRAFFIC_CAPTURE_RECORD_HEADER_SIZE, data, size);
+    }
+
+    // wake the writer early instead of letting the buffer grow for the whole interval
+    if (write_buffer_.size() >= TRAFFIC_CAPTURE_FLUSH_SIZE)
+    {
+      flush_condition_.notify_one();
+    }
+  }
+
+  void TrafficCaptureWriter::flush()
+  {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    {
+      // io threads only wait for the swap, not for the disk
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing_buffer_.swap(write_buffer_);
+    }
+
+    if (!file_.is_open())
+    {
+      writing_buffer_.clear();
+      return;
+    }
+
+    if (!writing_buffer_.empty())
+    {
+      file_.write(writing_buffer_.data(), static_cast<std::streamsize>(writing_buffer_.size()));
+      writing_buffer_.clear();
+    }
+    file_.flush();
+  }
+
+  void TrafficCaptureWriter::writer_loop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+      flush_condition_.wait_for(lock, TRAFFIC_CAPTURE_FLUSH_INTERVAL, [this]()
+                                { return stop_ || write_buffer_.size() >= TRAFFIC_CAPTURE_FLUSH_SIZE; });
+      if (stop_)
+      {
+        break;
+      }
+
+      // flush takes the file lock before the buffer lock
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  bool TrafficCaptureReader::open(const std::string &file_path)
+  {
+    file_.open(file_path, std::ios::binary | std::ios::in);
+    if (!file_.is_open())
+    {
+      return false;
+    }
+
+    char magic[TRAFFIC_CAPTURE_MAGIC_SIZE];
+    if (!file_.read(magic, TRAFFIC_CAPTURE_MAGIC_SIZE))
+    {
+      return false;
+    }
+    return std::memcmp(magic, TRAFFIC_CAPTURE_MAGIC, TRAFFIC_CAPTURE_MAGIC_SIZE) == 0;
+  }
+
+  bool TrafficCaptureReader::next(TrafficCaptureRecord &record)
+  {
+    char header[TRAFFIC_CAPTURE_RECORD_HEADER_SIZE];
+    if (!file_.read(header, TRAFFIC_CAPTURE_RECORD_HEADER_SIZE))
+    {
+      return false;
+    }
+
+    record.timestamp_us = read_le(header, 8);
+    record.connection_id = read_le(header + 8, 8);
+    record.message_id = static_cast<uint16_t>(read_le(header + 16, 2));
+    record.event = static_cast<TrafficCaptureEvent>(header[18]);
+
+    size_t size = static_cast<size_t>(read_le(header + 20, 4));
+    record.payload.resize(size);
+    if (size > 0 && !file_.read(record.payload.data(), static_cast<std::streamsize>(size)))
+    {
+      return false;
+    }
+    return true;
+  }
+}
@@ -0,0 +1,108 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: record inbound traffic into a binary capture file and read it back for replay
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+// magic of capture file
+#define TRAFFIC_CAPTURE_MAGIC "MPGSCAP1"
+#define TRAFFIC_CAPTURE_MAGIC_SIZE 8
+// size of encoded record header
+#define TRAFFIC_CAPTURE_RECORD_HEADER_SIZE 24
+
+namespace multiplayer_server
+{
+  // capture file layout, little endian:
+  //   file header: 8 bytes magic
+  //   record: uint64 timestamp in microseconds since capture start | uint64 connection id |
+  //           uint16 message id | uint8 event | uint8 reserved | uint32 payload size | payload
+  enum class TrafficCaptureEvent : uint8_t
+  {
+    kConnected = 0,
+    kMessage = 1,
+    kDisconnected = 2,
+  };
+
+  struct TrafficCaptureRecord
+  {
+    uint64_t timestamp_us = 0;
+    uint64_t connection_id = 0;
+    uint16_t message_id = 0;
+    TrafficCaptureEvent event = TrafficCaptureEvent::kMessage;
+    std::vector<char> payload;
+  };
+
+  // thread safe capture writer shared by all connections
+  // io threads only append to a buffer, a writer thread of its own writes the buffer to disk
+  // when it's big enough or once per flush interval, so an idle server still flushes
+  class TrafficCaptureWriter
+  {
+  public:
+    TrafficCaptureWriter();
+    ~TrafficCaptureWriter();
+
+    // non-copyable
+    TrafficCaptureWriter(const TrafficCaptureWriter &) = delete;
+    TrafficCaptureWriter &operator=(const TrafficCaptureWriter &) = delete;
+    TrafficCaptureWriter(TrafficCaptureWriter &&) = delete;
+    TrafficCaptureWriter &operator=(TrafficCaptureWriter &&) = delete;
+
+    // create the capture file and start the writer thread, the parent directory is created if not exist
+    bool open(const std::string &file_path);
+    // write everything recorded, stop the writer thread and close the file
+    void close();
+    bool is_open() const;
+
+    // append a record, timestamp is taken from steady clock in the same lock, so records are in timestamp order
+    void record(uint64_t connection_id, TrafficCaptureEvent event, uint16_t message_id = 0, const void *data = nullptr, size_t size = 0);
+
+    // write buffered records into file, called by the writer thread
+    void flush();
+
+  private:
+    void writer_loop();
+
+  private:
+    // guards the buffer, held by io threads only to append
+    mutable std::mutex mutex_;
+    std::condition_variable flush_condition_;
+    std::vector<char> write_buffer_;
+    std::chrono::steady_clock::time_point start_time_;
+    bool opened_ = false;
+    bool stop_ = false;
+
+    // guards the file, disk writes never hold mutex_
+    std::mutex file_mutex_;
+    std::ofstream file_;
+    // buffer taken from write_buffer_ by the flush being written
+    std::vector<char> writing_buffer_;
+
+    std::thread writer_thread_;
+  };
+
+  // sequential capture reader, used by replay tool
+  class TrafficCaptureReader
+  {
+  public:
+    TrafficCaptureReader() = default;
+    ~TrafficCaptureReader() = default;
+
+    // open a capture file and check the magic
+    bool open(const std::string &file_path);
+
+    // read next record, return false at the end of file or if the file is broken
+    bool next(TrafficCaptureRecord &record);
+
+  private:
+    std::ifstream file_;
+  };
+}
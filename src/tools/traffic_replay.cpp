@@ -0,0 +1,238 @@
+// Created: 2026.10.19
+// Author: CasinoHe
+// Purpose: replay a traffic capture file against a running server, at original or accelerated speed
+#include "network/message_frame.h"
+#include "network/traffic_capture.h"
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <memory>
+#include <map>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <array>
+#include <algorithm>
+
+namespace multiplayer_server
+{
+  // replay every captured connection with a new tcp connection, in the captured order and timing
+  class TrafficReplayer
+  {
+  public:
+    TrafficReplayer(const std::string &ip, int port, double speed) : ip_(ip), port_(port), speed_(speed) {}
+
+    bool run(const std::string &capture_file_path)
+    {
+      TrafficCaptureReader reader;
+      if (!reader.open(capture_file_path))
+      {
+        std::cout << "open capture file failed, path: " << capture_file_path << std::endl;
+        return false;
+      }
+
+      boost::asio::ip::tcp::resolver resolver(io_context_);
+      boost::system::error_code error;
+      auto endpoints = resolver.resolve(ip_, std::to_string(port_), error);
+      if (error || endpoints.empty())
+      {
+        std::cout << "resolve " << ip_ << ":" << port_ << " failed, error: " << error.message() << std::endl;
+        return false;
+      }
+      endpoint_ = *endpoints.begin();
+
+      auto start_time = std::chrono::steady_clock::now();
+      TrafficCaptureRecord record;
+      while (reader.next(record))
+      {
+        // wait until the scaled capture time, speed 0 means as fast as possible
+        if (speed_ > 0)
+        {
+          auto offset = std::chrono::duration<double, std::micro>(static_cast<double>(record.timestamp_us) / speed_);
+          std::this_thread::sleep_until(start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+        }
+
+        switch (record.event)
+        {
+        case TrafficCaptureEvent::kConnected:
+          get_socket(record.connection_id);
+          break;
+        case TrafficCaptureEvent::kMessage:
+          send_message(record);
+          break;
+        case TrafficCaptureEvent::kDisconnected:
+          close_socket(record.connection_id);
+          break;
+        default:
+          break;
+        }
+
+        // discard data sent by server, so the server is not blocked by a full socket buffer
+        if (++record_count_ % 64 == 0)
+        {
+          drain_all();
+        }
+      }
+
+      for (auto &iter : sockets_)
+      {
+        iter.second->close(error);
+      }
+      sockets_.clear();
+
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+      std::cout << "replay finished, records: " << record_count_
+                << ", messages: " << message_count_
+                << ", bytes: " << byte_count_
+                << ", connections: " << connection_count_
+                << ", failed connections: " << failed_connection_count_
+                << ", seconds: " << elapsed << std::endl;
+      return true;
+    }
+
+  private:
+    // get the socket replaying the captured connection, connect if not exist
+    std::shared_ptr<boost::asio::ip::tcp::socket> get_socket(uint64_t connection_id)
+    {
+      auto iter = sockets_.find(connection_id);
+      if (iter != sockets_.end())
+      {
+        return iter->second;
+      }
+
+      auto socket = std::make_shared<boost::asio::ip::tcp::socket>(io_context_);
+      boost::system::error_code error;
+      socket->connect(endpoint_, error);
+      if (error)
+      {
+        failed_connection_count_++;
+        return nullptr;
+      }
+      socket->set_option(boost::asio::ip::tcp::no_delay(true), error);
+
+      connection_count_++;
+      sockets_.emplace(connection_id, socket);
+      return socket;
+    }
+
+    void close_socket(uint64_t connection_id)
+    {
+      auto iter = sockets_.find(connection_id);
+      if (iter == sockets_.end())
+      {
+        return;
+      }
+
+      boost::system::error_code error;
+      iter->second->shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+      iter->second->close(error);
+      sockets_.erase(iter);
+    }
+
+    // frame the captured message and write it
+    void send_message(const TrafficCaptureRecord &record)
+    {
+      auto socket = get_socket(record.connection_id);
+      if (!socket)
+      {
+        return;
+      }
+
+      size_t size = record.payload.size();
+      size_t offset = 0;
+      do
+      {
+        FrameHeader header;
+        header.size = static_cast<uint32_t>(std::min<size_t>(size - offset, MAX_FRAME_PAYLOAD_SIZE));
+        header.message_id = record.message_id;
+        header.lane = static_cast<uint8_t>(SendLane::kRealtime);
+        header.flags = offset + header.size < size ? kFrameFlagMoreFragments : kFrameFlagNone;
+        auto encoded = header.encode();
+
+        std::array<boost::asio::const_buffer, 2> buffers = {
+          boost::asio::buffer(encoded),
+          boost::asio::buffer(record.payload.data() + offset, header.size)};
+        boost::system::error_code error;
+        boost::asio::write(*socket, buffers, error);
+        if (error)
+        {
+          close_socket(record.connection_id);
+          return;
+        }
+        offset += header.size;
+      } while (offset < size);
+
+      message_count_++;
+      byte_count_ += size;
+    }
+
+    void drain_all()
+    {
+      std::array<char, 4096> buffer;
+      for (auto &iter : sockets_)
+      {
+        boost::system::error_code error;
+        // only read bytes already received, so read_some never blocks
+        size_t available = iter.second->available(error);
+        while (available > 0 && !error)
+        {
+          available -= iter.second->read_some(boost::asio::buffer(buffer.data(), std::min(available, buffer.size())), error);
+        }
+      }
+    }
+
+  private:
+    std::string ip_;
+    int port_ = 0;
+    double speed_ = 1.0;
+
+    boost::asio::io_context io_context_;
+    boost::asio::ip::tcp::endpoint endpoint_;
+    // captured connection id -> replaying socket
+    std::map<uint64_t, std::shared_ptr<boost::asio::ip::tcp::socket>> sockets_;
+
+    // statistics
+    size_t record_count_ = 0;
+    size_t message_count_ = 0;
+    size_t byte_count_ = 0;
+    size_t connection_count_ = 0;
+    size_t failed_connection_count_ = 0;
+  };
+}
+
+int main(int argc, const char **argv)
+{
+  using namespace multiplayer_server;
+  namespace po = boost::program_options;
+
+  po::options_description desc("Allowed options");
+  desc.add_options()
+    ("help", "produce help message")
+    ("capture", po::value<std::string>(), "set capture file path")
+    ("ip", po::value<std::string>()->default_value("127.0.0.1"), "set server ip")
+    ("port", po::value<int>()->default_value(52500), "set server port")
+    ("speed", po::value<double>()->default_value(1.0), "replay speed, 1 is original speed, 0 is as fast as possible")
+    ;
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception &e)
+  {
+    std::cout << e.what() << std::endl;
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help") || !vm.count("capture"))
+  {
+    std::cout << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  TrafficReplayer replayer(vm["ip"].as<std::string>(), vm["port"].as<int>(), std::max(vm["speed"].as<double>(), 0.0));
+  return replayer.run(vm["capture"].as<std::string>()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}